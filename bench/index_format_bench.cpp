@@ -0,0 +1,244 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file index_format_bench.cpp
+  * @brief Size and lookup time of the memsector index formats, for an index
+  * of harvests
+  * @date 17 Oct 2026
+  */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <stack>
+using std::stack;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "common/utils/FlagParser.hpp"
+using common::utils::FlagParser;
+#include "mws/dbc/MemCrawlDb.hpp"
+#include "mws/dbc/MemFormulaDb.hpp"
+#include "mws/index/IndexManager.hpp"
+#include "mws/index/MeaningDictionary.hpp"
+using mws::index::MeaningDictionary;
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/index/index.h"
+#include "mws/xmlparser/processMwsHarvest.hpp"
+
+#include "build-gen/config.h"
+
+using namespace mws;
+
+#define DEFAULT_NUM_LOOKUPS     (1 << 20)
+#define DEFAULT_MEMSECTOR_PATH  "/tmp/index_format_bench.memsector"
+#define DEFAULT_HARVEST_PATH    MWS_TESTDATA_PATH
+
+struct IndexStats {
+    uint64_t numInodes;
+    uint64_t numLeaves;
+    uint64_t numChildren;
+};
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static const inode_t* getNode(const index_handle_t* index,
+                              memsector_off_t off) {
+    return (const inode_t*) memsector_off2addr(index->alloc,
+                                               index->off_shift, off);
+}
+
+/**
+ * @brief visit every node of the index, as queries with a variable at the
+ * root do
+ */
+static IndexStats walkIndex(const index_handle_t* index) {
+    IndexStats stats = {0, 0, 0};
+    stack<const inode_t*> nodes;
+
+    nodes.push(index->root);
+    while (!nodes.empty()) {
+        const inode_t* inode = nodes.top();
+        nodes.pop();
+        if (inode->type == LEAF_NODE) {
+            stats.numLeaves++;
+            continue;
+        }
+        stats.numInodes++;
+        stats.numChildren += inode->size;
+        for (uint32_t i = 0; i < inode->size; i++) {
+            nodes.push(getNode(index, inode_get_off(index, inode, i)));
+        }
+    }
+
+    return stats;
+}
+
+/**
+ * @return tokens of the formulae reached by random walks from the root
+ */
+static vector<vector<encoded_token_t> >
+sampleFormulae(const index_handle_t* index, size_t count) {
+    vector<vector<encoded_token_t> > formulae(count);
+
+    for (vector<encoded_token_t>& formula : formulae) {
+        const inode_t* inode = index->root;
+        while (inode->type == INTERNAL_NODE) {
+            uint32_t i = rand() % inode->size;
+            formula.push_back(inode_get_token(inode, index->format, i));
+            inode = getNode(index, inode_get_off(index, inode, i));
+        }
+    }
+
+    return formulae;
+}
+
+/**
+ * @return average time in nanoseconds to find the leaf of a formula
+ */
+static double timeLookups(const index_handle_t* index,
+                          const vector<vector<encoded_token_t> >& formulae) {
+    uint64_t checksum = 0;
+    double start = nowNs();
+    for (const vector<encoded_token_t>& formula : formulae) {
+        const inode_t* inode = index->root;
+        for (const encoded_token_t& token : formula) {
+            inode = getNode(index, inode_get_child(index, inode, token));
+        }
+        checksum += ((const leaf_t*) inode)->formula_id;
+    }
+    double end = nowNs();
+    if (checksum == 0) {
+        PRINT_WARN("Lookups failed\n");
+    }
+
+    return (end - start) / formulae.size();
+}
+
+int main(int argc, char* argv[]) {
+    const struct {
+        index_format_t format;
+        const char* name;
+    } formats[] = {
+        {INDEX_FORMAT_SORTED_PAIRS, "pairs"},
+        {INDEX_FORMAT_BLOCKED_KEYS, "blocked"},
+        {INDEX_FORMAT_COMPACT,      "compact"},
+    };
+    size_t numLookups = DEFAULT_NUM_LOOKUPS;
+    string memsectorPath = DEFAULT_MEMSECTOR_PATH;
+    string harvestPath = DEFAULT_HARVEST_PATH;
+    string harvestExtension = "harvest";
+    uint32_t memsectorFlags = 0;
+    vector<vector<encoded_token_t> > formulae;
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+    MwsIndexNode data;
+    MeaningDictionary meaningDictionary;
+    index::IndexingOptions indexingOptions;
+
+    FlagParser::addFlag('I', "include-harvest-path",    FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('e', "harvest-file-extension",  FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('r', "recursive",               FLAG_OPT, ARG_NONE);
+    FlagParser::addFlag('n', "lookups",                 FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('O', "tmp-memsector-path",      FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('s', "subtree-counts",          FLAG_OPT, ARG_NONE);
+
+    if (FlagParser::parse(argc, argv) != 0) {
+        fprintf(stderr, "%s", FlagParser::getUsage().c_str());
+        return EXIT_FAILURE;
+    }
+    if (FlagParser::hasArg('I')) {
+        harvestPath = FlagParser::getArg('I');
+    }
+    if (FlagParser::hasArg('e')) {
+        harvestExtension = FlagParser::getArg('e');
+    }
+    if (FlagParser::hasArg('n')) {
+        numLookups = atol(FlagParser::getArg('n').c_str());
+    }
+    if (FlagParser::hasArg('O')) {
+        memsectorPath = FlagParser::getArg('O');
+    }
+    if (FlagParser::hasArg('s')) {
+        memsectorFlags = MEMSECTOR_FLAG_SUBTREE_COUNTS;
+    }
+
+    indexingOptions.renameCi = false;
+    index::IndexManager indexManager(&formulaDb, &crawlDb, &data,
+                                     &meaningDictionary, indexingOptions);
+    if (parser::loadMwsHarvestFromDirectory(&indexManager,
+                                            AbsPath(harvestPath),
+                                            harvestExtension,
+                                            FlagParser::hasArg('r')) <= 0) {
+        PRINT_WARN("No harvests loaded from %s\n", harvestPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    srand(42);
+    printf("%8s %12s %14s %12s %12s %12s\n", "format", "bytes",
+           "bytes/formula", "bytes/child", "lookup (ns)", "walk (ms)");
+    for (const auto& format : formats) {
+        memsector_writer_t mswr;
+        memsector_handle_t ms;
+
+        FAIL_ON(unlink(memsectorPath.c_str()) != 0 && errno != ENOENT);
+        FAIL_ON(memsector_create_flags(&mswr, memsectorPath.c_str(),
+                                       MEMSECTOR_INITIAL_SIZE, format.format,
+                                       /* off_shift = */ 0,
+                                       memsectorFlags) != 0);
+        FAIL_ON(data.exportToMemsector(&mswr) != 0);
+        FAIL_ON(memsector_save(&mswr) != 0);
+        FAIL_ON(memsector_load(&ms, memsectorPath.c_str()) != 0);
+
+        // the same formulae are looked up in every format
+        if (formulae.empty()) {
+            formulae = sampleFormulae(&ms.index, numLookups);
+        }
+        double walkStart = nowNs();
+        IndexStats stats = walkIndex(&ms.index);
+        double walkEnd = nowNs();
+        uint64_t size = memsector_size_inuse(ms.alloc, ms.index.off_shift);
+
+        printf("%8s %12lu %14.1f %12.1f %12.1f %12.1f\n", format.name,
+               (unsigned long) size, (double) size / stats.numLeaves,
+               (double) size / stats.numChildren,
+               timeLookups(&ms.index, formulae),
+               (walkEnd - walkStart) / 1e6);
+        FAIL_ON(memsector_remove(&ms) != 0);
+    }
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
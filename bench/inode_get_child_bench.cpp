@@ -0,0 +1,214 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file inode_get_child_bench.cpp
+  * @brief Microbenchmark of the child lookup of memsector index nodes, for
+  * every index format and lookup instruction set
+  * @date 17 Oct 2026
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "common/utils/FlagParser.hpp"
+using common::utils::FlagParser;
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/index/index.h"
+
+using namespace mws;
+
+#define DEFAULT_NUM_LOOKUPS     (1 << 22)
+#define DEFAULT_MEMSECTOR_PATH  "/tmp/inode_get_child_bench.memsector"
+/// Children over all benchmarked nodes, for the nodes not to fit in cache
+#define DEFAULT_TOTAL_CHILDREN  (1 << 20)
+
+struct Lookup {
+    const inode_t* inode;
+    encoded_token_t token;
+};
+
+static bool tokenLess(const encoded_token_t& lhs, const encoded_token_t& rhs) {
+    return memcmp(&lhs, &rhs, sizeof(encoded_token_t)) < 0;
+}
+
+static vector<encoded_token_t> sortedRandomTokens(size_t count) {
+    vector<encoded_token_t> tokens;
+
+    while (tokens.size() < count) {
+        tokens.push_back(encoded_token(CONSTANT_ID_MIN + rand() % (1 << 23),
+                                       rand() % 4));
+        if (tokens.size() == count) {
+            std::sort(tokens.begin(), tokens.end(), tokenLess);
+            tokens.erase(std::unique(tokens.begin(), tokens.end(),
+                                     [](const encoded_token_t& lhs,
+                                        const encoded_token_t& rhs) {
+                return memcmp(&lhs, &rhs, sizeof(encoded_token_t)) == 0;
+            }), tokens.end());
+        }
+    }
+
+    return tokens;
+}
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @return average lookup time in nanoseconds
+ */
+static double timeLookups(const vector<Lookup>& lookups,
+                          const index_handle_t* index) {
+    memsector_off_t checksum = 0;
+    double start = nowNs();
+    for (const Lookup& lookup : lookups) {
+        checksum |= inode_get_child(index, lookup.inode, lookup.token);
+    }
+    double end = nowNs();
+    if (checksum == MEMSECTOR_OFF_NULL) {
+        PRINT_WARN("Lookup failed\n");
+    }
+
+    return (end - start) / lookups.size();
+}
+
+static int benchNodeSize(uint32_t nodeSize, uint32_t totalChildren,
+                         size_t numLookups, const char* memsectorPath) {
+    const size_t numNodes = std::max(totalChildren / nodeSize, 1u);
+    const vector<encoded_token_t> parents = sortedRandomTokens(numNodes);
+    vector<vector<encoded_token_t> > children;
+    MwsIndexNode data;
+
+    // tokens are inserted in order, for VectorMap to only append
+    for (const encoded_token_t& parent : parents) {
+        vector<encoded_token_t> formula(2);
+        formula[0] = parent;
+        children.push_back(sortedRandomTokens(nodeSize));
+        for (const encoded_token_t& child : children.back()) {
+            formula[1] = child;
+            data.insertData(formula);
+        }
+    }
+
+    printf("%8u", nodeSize);
+    for (index_format_t format : {INDEX_FORMAT_SORTED_PAIRS,
+                                  INDEX_FORMAT_BLOCKED_KEYS,
+                                  INDEX_FORMAT_COMPACT}) {
+        memsector_writer_t mswr;
+        memsector_handle_t ms;
+        vector<Lookup> lookups;
+
+        unlink(memsectorPath);
+        FAIL_ON(memsector_create_format(&mswr, memsectorPath,
+                                        MEMSECTOR_INITIAL_SIZE, format,
+                                        /* off_shift = */ 0) != 0);
+        FAIL_ON(data.exportToMemsector(&mswr) != 0);
+        FAIL_ON(memsector_save(&mswr) != 0);
+        FAIL_ON(memsector_load(&ms, memsectorPath) != 0);
+
+        for (size_t i = 0; i < numLookups; i++) {
+            size_t node = rand() % parents.size();
+            const inode_t* inode = (const inode_t*) memsector_off2addr(
+                    ms.alloc, ms.index.off_shift,
+                    inode_get_child(&ms.index, ms.index.root, parents[node]));
+            lookups.push_back({inode, children[node][rand() % nodeSize]});
+        }
+
+        if (format != INDEX_FORMAT_BLOCKED_KEYS) {
+            printf(" %12.1f", timeLookups(lookups, &ms.index));
+        } else {
+            for (inode_search_isa_t isa : {INODE_SEARCH_SCALAR,
+                                           INODE_SEARCH_SSE2,
+                                           INODE_SEARCH_AVX2}) {
+                if (inode_search_set_isa(isa) == 0) {
+                    printf(" %12.1f", timeLookups(lookups, &ms.index));
+                } else {
+                    printf(" %12s", "-");
+                }
+            }
+        }
+        FAIL_ON(memsector_remove(&ms) != 0);
+    }
+    printf("\n");
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t nodeSizes[] = {2, 4, 8, 16, 32, 64, 256, 4096, 65536};
+    size_t numLookups = DEFAULT_NUM_LOOKUPS;
+    uint32_t totalChildren = DEFAULT_TOTAL_CHILDREN;
+    string memsectorPath = DEFAULT_MEMSECTOR_PATH;
+    inode_search_isa_t defaultIsa = inode_search_get_isa();
+
+    FlagParser::addFlag('n', "lookups",                 FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('c', "total-children",          FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('O', "tmp-memsector-path",      FLAG_OPT, ARG_REQ);
+
+    if (FlagParser::parse(argc, argv) != 0) {
+        fprintf(stderr, "%s", FlagParser::getUsage().c_str());
+        return EXIT_FAILURE;
+    }
+    if (FlagParser::hasArg('n')) {
+        numLookups = atol(FlagParser::getArg('n').c_str());
+    }
+    if (FlagParser::hasArg('c')) {
+        totalChildren = atoi(FlagParser::getArg('c').c_str());
+    }
+    if (FlagParser::hasArg('O')) {
+        memsectorPath = FlagParser::getArg('O');
+    }
+
+    srand(42);
+    printf("Average lookup time (ns), %zu random lookups of present tokens "
+           "among %u children\n", numLookups, totalChildren);
+    printf("Instruction set selected on this CPU: %s\n",
+           defaultIsa == INODE_SEARCH_AVX2 ? "avx2" :
+           defaultIsa == INODE_SEARCH_SSE2 ? "sse2" : "scalar");
+    printf("%8s %12s %12s %12s %12s %12s\n", "children",
+           "pairs/memcmp", "keys/scalar", "keys/sse2", "keys/avx2",
+           "compact");
+    for (uint32_t nodeSize : nodeSizes) {
+        if (benchNodeSize(nodeSize, totalChildren, numLookups,
+                          memsectorPath.c_str()) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
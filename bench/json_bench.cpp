@@ -0,0 +1,181 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file json_bench.cpp
+  * @brief Throughput of the JSON answer set serializer against json-c
+  * @date 18 Oct 2026
+  */
+
+#include <json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include "common/utils/compiler_defs.h"
+#include "common/utils/FlagParser.hpp"
+using common::utils::FlagParser;
+#include "mws/types/MwsAnswset.hpp"
+using mws::MwsAnswset;
+using mws::types::Answer;
+#include "mws/xmlparser/writeJsonAnswset.hpp"
+using mws::xmlparser::JsonAnswsetWriter;
+
+#define DEFAULT_NUM_ANSWSETS    1000
+#define DEFAULT_NUM_HITS        30
+#define DEFAULT_XHTML_SIZE      2048
+
+/// MathML as crawled: closing tags, quoted attributes and line breaks
+#define XHTML_SNIPPET                                                       \
+    "<math xmlns=\"http://www.w3.org/1998/Math/MathML\" display=\"inline\">" \
+    "\n  <semantics><mrow><msup><mi>x</mi><mn>2</mn></msup><mo>+</mo>"       \
+    "<mi>\xce\xb1</mi></mrow></semantics>\n</math>\n"
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static string jsoncAnswset(const MwsAnswset& answset) {
+    json_object* json_doc = json_object_new_object();
+    json_object* qvars = json_object_new_array();
+    json_object* hits = json_object_new_array();
+
+    json_object_object_add(json_doc, "total",
+                           json_object_new_int(answset.total));
+    for (size_t i = 0; i < answset.qvarNames.size(); i++) {
+        json_object* qvar = json_object_new_object();
+        json_object_object_add(qvar, "name",
+                json_object_new_string(answset.qvarNames[i].c_str()));
+        json_object_object_add(qvar, "xpath",
+                json_object_new_string(answset.qvarXpaths[i].c_str()));
+        json_object_array_add(qvars, qvar);
+    }
+    json_object_object_add(json_doc, "qvars", qvars);
+    for (const Answer* answer : answset.answers) {
+        json_object* hit = json_object_new_object();
+        json_object* math_ids = json_object_new_array();
+        json_object* math_id = json_object_new_object();
+        json_object_object_add(math_id, "url",
+                               json_object_new_string(answer->uri.c_str()));
+        json_object_object_add(math_id, "xpath",
+                               json_object_new_string(answer->xpath.c_str()));
+        json_object_array_add(math_ids, math_id);
+        json_object_object_add(hit, "math_ids", math_ids);
+        json_object_object_add(hit, "xhtml",
+                               json_object_new_string(answer->data.c_str()));
+        json_object_array_add(hits, hit);
+    }
+    json_object_object_add(json_doc, "hits", hits);
+
+    string result = json_object_to_json_string(json_doc);
+    json_object_put(json_doc);
+
+    return result;
+}
+
+static string mwsAnswset(const MwsAnswset& answset) {
+    JsonAnswsetWriter writer(&answset);
+    string result;
+
+    while (writer.writeNext(&result) == 1) continue;
+
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    const struct {
+        const char* name;
+        string (*write)(const MwsAnswset&);
+    } serializers[] = {
+        {"json-c",  jsoncAnswset},
+        {"mws",     mwsAnswset},
+    };
+    size_t numAnswsets = DEFAULT_NUM_ANSWSETS;
+    size_t numHits = DEFAULT_NUM_HITS;
+    size_t xhtmlSize = DEFAULT_XHTML_SIZE;
+    MwsAnswset answset;
+    string xhtml;
+    string expected;
+
+    FlagParser::addFlag('n', "answer-sets",             FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('s', "hits",                    FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('x', "xhtml-size",              FLAG_OPT, ARG_REQ);
+
+    if (FlagParser::parse(argc, argv) != 0) {
+        fprintf(stderr, "%s", FlagParser::getUsage().c_str());
+        return EXIT_FAILURE;
+    }
+    if (FlagParser::hasArg('n')) {
+        numAnswsets = atol(FlagParser::getArg('n').c_str());
+        if (numAnswsets == 0) {
+            fprintf(stderr, "Invalid number of answer sets \"%s\"\n",
+                    FlagParser::getArg('n').c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    if (FlagParser::hasArg('s')) {
+        numHits = atol(FlagParser::getArg('s').c_str());
+    }
+    if (FlagParser::hasArg('x')) {
+        xhtmlSize = atol(FlagParser::getArg('x').c_str());
+    }
+
+    while (xhtml.size() < xhtmlSize) xhtml += XHTML_SNIPPET;
+    xhtml.resize(xhtmlSize);
+    answset.total = numHits;
+    answset.qvarNames.push_back("x");
+    answset.qvarXpaths.push_back("/*[1]/*[1]/*[1]");
+    for (size_t i = 0; i < numHits; i++) {
+        Answer* answer = new Answer();
+        answer->uri = "http://arxiv.org/abs/math/" + to_string(i) + "#p1.m1";
+        answer->xpath = "/*[1]/*[2]/*[1]";
+        answer->data = xhtml;
+        answset.answers.push_back(answer);
+    }
+
+    printf("%8s %10s %10s %10s %10s\n", "writer", "answsets", "bytes",
+           "us/answset", "MB/s");
+    expected = jsoncAnswset(answset);
+    for (const auto& serializer : serializers) {
+        size_t totalBytes = 0;
+
+        FAIL_ON(serializer.write(answset) != expected);
+        double start = nowNs();
+        for (size_t i = 0; i < numAnswsets; i++) {
+            totalBytes += serializer.write(answset).size();
+        }
+        double elapsedNs = nowNs() - start;
+
+        printf("%8s %10lu %10lu %10.1f %10.1f\n", serializer.name,
+               (unsigned long) numAnswsets, (unsigned long) expected.size(),
+               elapsedNs / numAnswsets / 1e3, totalBytes / (elapsedNs / 1e3));
+    }
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,436 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file query_bench.cpp
+  * @brief Latency and throughput of the query engines over a mix of
+  * queries, answered as mwsd answers them
+  * @date 17 Oct 2026
+  */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+using std::shared_ptr;
+#include <sstream>
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "common/utils/FlagParser.hpp"
+using common::utils::FlagParser;
+#include "mws/dbc/DbQueryManager.hpp"
+using mws::dbc::DbQueryManager;
+using mws::dbc::DbAnswerCallback;
+using mws::dbc::CrawlData;
+#include "mws/dbc/MemCrawlDb.hpp"
+#include "mws/dbc/MemFormulaDb.hpp"
+#include "mws/index/IndexAccessor.hpp"
+using mws::index::IndexAccessor;
+#include "mws/index/IndexManager.hpp"
+#include "mws/index/MeaningDictionary.hpp"
+using mws::index::MeaningDictionary;
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/index/index.h"
+#include "mws/query/MatchList.hpp"
+using mws::query::MatchList;
+#include "mws/query/MatchListCache.hpp"
+using mws::query::MatchListCache;
+#include "mws/query/SearchContext.hpp"
+using mws::query::SearchContext;
+#include "mws/query/engine.h"
+#include "mws/types/FormulaPath.hpp"
+using mws::types::FormulaPath;
+#include "mws/types/MwsAnswset.hpp"
+#include "mws/xmlparser/processMwsHarvest.hpp"
+
+#include "build-gen/config.h"
+
+using namespace mws;
+
+#define DEFAULT_NUM_QUERIES     1000
+#define DEFAULT_QUERY_MIX       "constant,anon,repeated,root"
+#define DEFAULT_MEMSECTOR_PATH  "/tmp/query_bench.memsector"
+#define DEFAULT_HARVEST_PATH    MWS_TESTDATA_PATH
+
+typedef vector<encoded_token_t> Query;
+
+struct QueryOptions {
+    unsigned offset;
+    unsigned size;
+    unsigned maxTotal;
+};
+
+struct EngineCtxt {
+    MwsAnswset* result;
+    DbQueryManager* dbQueryManager;
+    const QueryOptions* options;
+};
+
+static double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static bool sameToken(encoded_token_t lhs, encoded_token_t rhs) {
+    return encoded_token_key(lhs) == encoded_token_key(rhs);
+}
+
+/**
+ * @return end of the subterm starting at token i
+ */
+static size_t subtermEnd(const Query& formula, size_t i) {
+    int pending = 1;
+    while (pending > 0) {
+        pending += formula[i].arity - 1;
+        i++;
+    }
+    return i;
+}
+
+/**
+ * @return formula with the subterm starting at token i replaced by a var
+ */
+static Query replaceSubterm(const Query& formula, size_t i,
+                            encoded_token_t var) {
+    Query query(formula.begin(), formula.begin() + i);
+    query.push_back(var);
+    query.insert(query.end(), formula.begin() + subtermEnd(formula, i),
+                 formula.end());
+    return query;
+}
+
+/**
+ * @return formula reached by a random walk from the root
+ */
+static Query sampleFormula(const index_handle_t* index) {
+    Query formula;
+    const inode_t* inode = index->root;
+
+    while (inode->type == INTERNAL_NODE) {
+        uint32_t i = rand() % inode->size;
+        formula.push_back(inode_get_token(inode, index->format, i));
+        inode = (const inode_t*) memsector_off2addr(index->alloc,
+                index->off_shift, inode_get_off(index, inode, i));
+    }
+
+    return formula;
+}
+
+/**
+ * @brief the formula with one of its subterms replaced by a qvar named
+ * ?x everywhere it occurs, or with the first two arguments of its root
+ * replaced by ?x if no subterm occurs twice
+ */
+static Query repeatQvar(const Query& formula) {
+    const encoded_token_t x = encoded_token(QVAR_ID_MIN, 0);
+    vector<size_t> repeated;
+
+    // every token starts a subterm, so equal tokens delimit equal subterms
+    for (size_t i = 1; i < formula.size(); i++) {
+        size_t size = subtermEnd(formula, i) - i;
+        for (size_t j = i + size; j + size <= formula.size(); j++) {
+            if (std::equal(formula.begin() + i, formula.begin() + i + size,
+                           formula.begin() + j, sameToken)) {
+                repeated.push_back(i);
+                break;
+            }
+        }
+    }
+    if (repeated.empty()) {
+        if (formula[0].arity < 2) return formula;
+        Query query = replaceSubterm(formula, 1, x);
+        return replaceSubterm(query, 2, x);
+    }
+
+    size_t i = repeated[rand() % repeated.size()];
+    Query subterm(formula.begin() + i,
+                  formula.begin() + subtermEnd(formula, i));
+    Query query = formula;
+    for (size_t j = i; j + subterm.size() <= query.size(); j++) {
+        if (std::equal(subterm.begin(), subterm.end(), query.begin() + j,
+                       sameToken)) {
+            query = replaceSubterm(query, j, x);
+        }
+    }
+
+    return query;
+}
+
+static bool makeQuery(const string& kind, const index_handle_t* index,
+                      Query* query) {
+    if (kind == "root") {
+        *query = {encoded_token(QVAR_ID_MIN, 0)};
+        return true;
+    }
+
+    Query formula = sampleFormula(index);
+    if (kind == "constant") {
+        *query = formula;
+    } else if (kind == "anon") {
+        size_t i = (formula.size() > 1) ? 1 + rand() % (formula.size() - 1)
+                                        : 0;
+        *query = replaceSubterm(formula, i,
+                                encoded_token(ANON_QVAR_ID_MIN, 0));
+    } else if (kind == "repeated") {
+        *query = repeatQvar(formula);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief answer each leaf as IndexDaemon does with the experimental engine
+ */
+static result_cb_return_t engineCallback(void* handle, const leaf_t* leaf) {
+    EngineCtxt* ctxt = reinterpret_cast<EngineCtxt*>(handle);
+    MwsAnswset* result = ctxt->result;
+    DbAnswerCallback queryCallback =
+            [result](const FormulaPath& formulaPath,
+                     const CrawlData& crawlData) {
+        types::Answer* answer = new types::Answer();
+        answer->data = crawlData;
+        answer->uri = formulaPath.xmlId;
+        answer->xpath = formulaPath.xpath;
+        result->answers.push_back(answer);
+        return 0;
+    };
+
+    ctxt->dbQueryManager->query(leaf->formula_id, ctxt->options->offset,
+                                ctxt->options->size, queryCallback);
+    result->total += leaf->num_hits;
+
+    return QUERY_CONTINUE;
+}
+
+static MwsAnswset* runSearchContext(index_handle_t* index,
+                                    DbQueryManager* dbQueryManager,
+                                    const QueryOptions& options,
+                                    const Query& query) {
+    SearchContext ctxt(query);
+    return ctxt.getResult<IndexAccessor>(index, dbQueryManager,
+                                         options.offset, options.size,
+                                         options.maxTotal);
+}
+
+static MwsAnswset* runMatchList(index_handle_t* index,
+                                DbQueryManager* dbQueryManager,
+                                const QueryOptions& options,
+                                const Query& query) {
+    static MatchListCache matchListCache(SIZE_MAX, /* ttl = */ 3600);
+    shared_ptr<const MatchList> matches =
+            matchListCache.get(query, options.maxTotal);
+
+    if (matches == NULL) {
+        SearchContext ctxt(query);
+        matches.reset(ctxt.getMatches<IndexAccessor>(index,
+                                                     options.maxTotal));
+        matchListCache.put(query, options.maxTotal, matches);
+    }
+
+    return matches->getPage(dbQueryManager, options.offset, options.size);
+}
+
+static MwsAnswset* runEngine(index_handle_t* index,
+                             DbQueryManager* dbQueryManager,
+                             const QueryOptions& options,
+                             const Query& query) {
+    MwsAnswset* result = new MwsAnswset;
+    EngineCtxt ctxt = {result, dbQueryManager, &options};
+    encoded_formula_t encodedFormula;
+
+    encodedFormula.data = const_cast<encoded_token_t*>(query.data());
+    encodedFormula.size = query.size();
+    query_engine_run(index, &encodedFormula, engineCallback, &ctxt);
+
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    const struct {
+        const char* name;
+        MwsAnswset* (*run)(index_handle_t*, DbQueryManager*,
+                           const QueryOptions&, const Query&);
+        /// run every query once before timing them
+        bool warm;
+    } engines[] = {
+        {"context", runSearchContext,   false},
+        {"engine",  runEngine,          false},
+        {"matches", runMatchList,       true},
+    };
+    size_t numQueries = DEFAULT_NUM_QUERIES;
+    string queryMix = DEFAULT_QUERY_MIX;
+    string memsectorPath = DEFAULT_MEMSECTOR_PATH;
+    string harvestPath = DEFAULT_HARVEST_PATH;
+    string harvestExtension = "harvest";
+    index_format_t format = INDEX_FORMAT_LATEST;
+    QueryOptions options = {DEFAULT_QUERY_OFFSET, DEFAULT_QUERY_RESULT_SIZE,
+                            DEFAULT_QUERY_RESULT_TOTAL};
+    memsector_writer_t mswr;
+    memsector_handle_t ms;
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+    DbQueryManager dbQueryManager(&crawlDb, &formulaDb);
+    MwsIndexNode data;
+    MeaningDictionary meaningDictionary;
+    index::IndexingOptions indexingOptions;
+    std::istringstream kinds;
+    string kind;
+
+    FlagParser::addFlag('I', "include-harvest-path",    FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('e', "harvest-file-extension",  FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('r', "recursive",               FLAG_OPT, ARG_NONE);
+    FlagParser::addFlag('f', "index-format",            FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('n', "queries",                 FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('q', "query-mix",               FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('s', "result-size",             FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('o', "result-offset",           FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('t', "result-total",            FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('O', "tmp-memsector-path",      FLAG_OPT, ARG_REQ);
+
+    if (FlagParser::parse(argc, argv) != 0) {
+        fprintf(stderr, "%s", FlagParser::getUsage().c_str());
+        return EXIT_FAILURE;
+    }
+    if (FlagParser::hasArg('I')) {
+        harvestPath = FlagParser::getArg('I');
+    }
+    if (FlagParser::hasArg('e')) {
+        harvestExtension = FlagParser::getArg('e');
+    }
+    if (FlagParser::hasArg('f')) {
+        if (FlagParser::getArg('f') == "blocked") {
+            format = INDEX_FORMAT_BLOCKED_KEYS;
+        } else if (FlagParser::getArg('f') == "compact") {
+            format = INDEX_FORMAT_COMPACT;
+        } else {
+            fprintf(stderr, "Invalid index format \"%s\"\n",
+                    FlagParser::getArg('f').c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    if (FlagParser::hasArg('n')) {
+        numQueries = atol(FlagParser::getArg('n').c_str());
+        if (numQueries < 1) {
+            fprintf(stderr, "Invalid number of queries \"%s\"\n",
+                    FlagParser::getArg('n').c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    if (FlagParser::hasArg('q')) {
+        queryMix = FlagParser::getArg('q');
+    }
+    if (FlagParser::hasArg('s')) {
+        options.size = atoi(FlagParser::getArg('s').c_str());
+    }
+    if (FlagParser::hasArg('o')) {
+        options.offset = atoi(FlagParser::getArg('o').c_str());
+    }
+    if (FlagParser::hasArg('t')) {
+        options.maxTotal = atoi(FlagParser::getArg('t').c_str());
+    }
+    if (FlagParser::hasArg('O')) {
+        memsectorPath = FlagParser::getArg('O');
+    }
+
+    indexingOptions.renameCi = false;
+    index::IndexManager indexManager(&formulaDb, &crawlDb, &data,
+                                     &meaningDictionary, indexingOptions);
+    if (parser::loadMwsHarvestFromDirectory(&indexManager,
+                                            AbsPath(harvestPath),
+                                            harvestExtension,
+                                            FlagParser::hasArg('r')) <= 0) {
+        PRINT_WARN("No harvests loaded from %s\n", harvestPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    FAIL_ON(unlink(memsectorPath.c_str()) != 0 && errno != ENOENT);
+    FAIL_ON(memsector_create_format(&mswr, memsectorPath.c_str(),
+                                    MEMSECTOR_INITIAL_SIZE, format,
+                                    /* off_shift = */ 0) != 0);
+    FAIL_ON(data.exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+    FAIL_ON(memsector_load(&ms, memsectorPath.c_str()) != 0);
+
+    srand(42);
+    printf("%9s %8s %8s %10s %10s %10s %10s\n", "query", "engine",
+           "queries", "p50 (us)", "p99 (us)", "QPS", "avg total");
+    kinds.str(queryMix);
+    while (std::getline(kinds, kind, ',')) {
+        vector<Query> queries(numQueries);
+        for (Query& query : queries) {
+            if (!makeQuery(kind, &ms.index, &query)) {
+                fprintf(stderr, "Invalid query kind \"%s\"\n", kind.c_str());
+                goto fail;
+            }
+        }
+
+        // the same queries are run by every engine
+        for (const auto& engine : engines) {
+            vector<double> latencies;
+            double totalNs = 0;
+            uint64_t totalHits = 0;
+
+            if (engine.warm) {
+                for (const Query& query : queries) {
+                    delete engine.run(&ms.index, &dbQueryManager, options,
+                                      query);
+                }
+            }
+            for (const Query& query : queries) {
+                double start = nowNs();
+                MwsAnswset* result = engine.run(&ms.index, &dbQueryManager,
+                                                options, query);
+                double end = nowNs();
+                latencies.push_back(end - start);
+                totalNs += end - start;
+                totalHits += result->total;
+                delete result;
+            }
+            std::sort(latencies.begin(), latencies.end());
+
+            printf("%9s %8s %8lu %10.1f %10.1f %10.0f %10.1f\n",
+                   kind.c_str(), engine.name, (unsigned long) numQueries,
+                   latencies[latencies.size() / 2] / 1e3,
+                   latencies[latencies.size() * 99 / 100] / 1e3,
+                   numQueries / (totalNs / 1e9),
+                   (double) totalHits / numQueries);
+        }
+    }
+
+    FAIL_ON(memsector_remove(&ms) != 0);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,104 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief File containing the implementation of the WorkerPool class.
+  *
+  * @file WorkerPool.cpp
+  * @date 17 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include "WorkerPool.hpp"
+
+WorkerPool::WorkerPool(size_t numWorkers, size_t queueDepth) :
+    _queueDepth(queueDepth), _numWorkers(numWorkers), _stopping(false) {
+    pthread_mutex_init(&_lock, NULL);
+    pthread_cond_init(&_jobQueued, NULL);
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+    pthread_cond_destroy(&_jobQueued);
+    pthread_mutex_destroy(&_lock);
+}
+
+int WorkerPool::start() {
+    _stopping = false;
+    while (_workers.size() < _numWorkers) {
+        pthread_t worker;
+        if (pthread_create(&worker, NULL, workerMain, this) != 0) {
+            stop();
+            return -1;
+        }
+        _workers.push_back(worker);
+    }
+
+    return 0;
+}
+
+bool WorkerPool::submit(const Job& job) {
+    bool queued = false;
+
+    pthread_mutex_lock(&_lock);
+    if (!_stopping && _jobs.size() < _queueDepth) {
+        _jobs.push_back(job);
+        pthread_cond_signal(&_jobQueued);
+        queued = true;
+    }
+    pthread_mutex_unlock(&_lock);
+
+    return queued;
+}
+
+void WorkerPool::stop() {
+    pthread_mutex_lock(&_lock);
+    _stopping = true;
+    pthread_cond_broadcast(&_jobQueued);
+    pthread_mutex_unlock(&_lock);
+
+    for (pthread_t worker : _workers) {
+        pthread_join(worker, NULL);
+    }
+    _workers.clear();
+}
+
+void* WorkerPool::workerMain(void* arg) {
+    WorkerPool* pool = (WorkerPool*) arg;
+
+    pthread_mutex_lock(&pool->_lock);
+    while (true) {
+        while (pool->_jobs.empty() && !pool->_stopping) {
+            pthread_cond_wait(&pool->_jobQueued, &pool->_lock);
+        }
+        // queued jobs are run even when stopping
+        if (pool->_jobs.empty()) break;
+
+        Job job = pool->_jobs.front();
+        pool->_jobs.pop_front();
+        pthread_mutex_unlock(&pool->_lock);
+        job();
+        pthread_mutex_lock(&pool->_lock);
+    }
+    pthread_mutex_unlock(&pool->_lock);
+
+    return NULL;
+}
@@ -0,0 +1,90 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _WORKERPOOL_HPP
+#define _WORKERPOOL_HPP
+
+/**
+  * @brief File containing the header of the WorkerPool class.
+  *
+  * @file WorkerPool.hpp
+  * @date 17 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+/**
+  * @brief Fixed set of threads running jobs from a bounded queue
+  */
+class WorkerPool {
+ public:
+    typedef std::function<void ()> Job;
+
+    /**
+      * @param numWorkers number of threads running jobs
+      * @param queueDepth maximum number of jobs waiting for a thread
+      */
+    WorkerPool(size_t numWorkers, size_t queueDepth);
+
+    /// Stops the pool if it is running
+    ~WorkerPool();
+
+    /**
+      * @brief Start the worker threads
+      * @return 0 on success, -1 on failure.
+      */
+    int start();
+
+    /**
+      * @brief Queue a job to be run by a worker thread
+      * @return true if the job was queued, false if the queue is full or
+      * the pool is stopping.
+      */
+    bool submit(const Job& job);
+
+    /**
+      * @brief Run the jobs already queued and join the worker threads
+      */
+    void stop();
+
+ private:
+    static void* workerMain(void* arg);
+
+    size_t _queueDepth;
+    size_t _numWorkers;
+    std::vector<pthread_t> _workers;
+    std::deque<Job> _jobs;
+    pthread_mutex_t _lock;
+    /// Signaled when a job is queued or the pool stops
+    pthread_cond_t _jobQueued;
+    bool _stopping;
+
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+};
+
+#endif  // _WORKERPOOL_HPP
@@ -65,7 +65,11 @@ public:
         return 0;
     }
 
-    int save(std::ostream& out) const {
+    /**
+     * @return the keys of the dictionary, ordered by their id (the key with
+     * id i is found at position i - 1)
+     */
+    std::vector<Key> getKeys() const {
         std::vector<Key> keys;
         keys.resize(_map.size());
 
@@ -76,6 +80,12 @@ public:
             keys[it->second - 1] = it->first;
         }
 
+        return keys;
+    }
+
+    int save(std::ostream& out) const {
+        const std::vector<Key> keys = getKeys();
+
         try {
             for (int i = 0; i < (int)keys.size(); i++) {
                 out << keys[i] << '\0';
@@ -0,0 +1,105 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file Arena.cpp
+  * @brief Slab-backed region allocator implementation
+  * @date 17 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+using std::bad_alloc;
+#include <vector>
+using std::vector;
+
+#include "Arena.hpp"
+
+namespace common { namespace utils {
+
+static inline size_t roundToAlignment(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+}
+
+Arena::Arena(size_t slabSize) :
+    _curr(NULL), _end(NULL), _slabSize(slabSize), _slabBytes(0) {
+    memset(_freeLists, 0, sizeof(_freeLists));
+}
+
+Arena::~Arena() {
+    for (char* slab : _slabs) {
+        free(slab);
+    }
+}
+
+char* Arena::allocateSlab(size_t size) {
+    char* slab = (char*) malloc(size);
+    if (slab == NULL) {
+        throw bad_alloc();
+    }
+    _slabs.push_back(slab);
+    _slabBytes += size;
+
+    return slab;
+}
+
+void* Arena::allocate(size_t size) {
+    size = roundToAlignment(size > 0 ? size : 1);
+
+    if (size <= ARENA_MAX_RECYCLED_SIZE) {
+        FreeBlock** freeList = &_freeLists[size / ARENA_ALIGNMENT];
+        if (*freeList != NULL) {
+            FreeBlock* block = *freeList;
+            *freeList = block->next;
+            return block;
+        }
+    }
+
+    // Large blocks get a slab of their own, to keep slabs densely used
+    if (size > _slabSize / 4) {
+        return allocateSlab(size);
+    }
+
+    if ((size_t) (_end - _curr) < size) {
+        _curr = allocateSlab(_slabSize);
+        _end = _curr + _slabSize;
+    }
+    void* result = _curr;
+    _curr += size;
+
+    return result;
+}
+
+void Arena::release(void* ptr, size_t size) {
+    size = roundToAlignment(size > 0 ? size : 1);
+
+    if (size <= ARENA_MAX_RECYCLED_SIZE) {
+        FreeBlock* block = (FreeBlock*) ptr;
+        block->next = _freeLists[size / ARENA_ALIGNMENT];
+        _freeLists[size / ARENA_ALIGNMENT] = block;
+    }
+}
+
+}  // namespace utils
+}  // namespace common
@@ -0,0 +1,99 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _COMMON_UTILS_ARENA_HPP
+#define _COMMON_UTILS_ARENA_HPP
+
+/**
+  * @file Arena.hpp
+  * @brief Slab-backed region allocator
+  * @date 17 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <stddef.h>
+
+#include <vector>
+
+/// Size of the slabs allocated by default
+#define ARENA_DEFAULT_SLAB_SIZE     (1 << 20)
+/// Alignment of all blocks returned by an Arena
+#define ARENA_ALIGNMENT             8
+/// Blocks larger than this are not recycled after release()
+#define ARENA_MAX_RECYCLED_SIZE     4096
+
+namespace common { namespace utils {
+
+/**
+ * @brief Region allocator for many small objects with the same lifetime.
+ * Blocks are carved out of large slabs, which are only given back when the
+ * Arena is destroyed. Objects allocated in an Arena are never destructed.
+ * Released blocks are recycled by later allocations of the same size.
+ */
+class Arena {
+ public:
+    explicit Arena(size_t slabSize = ARENA_DEFAULT_SLAB_SIZE);
+    ~Arena();
+
+    /**
+     * @brief allocate a block aligned to ARENA_ALIGNMENT
+     * @param size of the block in bytes
+     * @return pointer to the block
+     * @throw std::bad_alloc
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief release a block so that it can be reused
+     * @param ptr block returned by allocate()
+     * @param size size requested when the block was allocated
+     */
+    void release(void* ptr, size_t size);
+
+    /**
+     * @return number of bytes held in slabs
+     */
+    size_t getSlabBytes() const {
+        return _slabBytes;
+    }
+
+ private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    char* allocateSlab(size_t size);
+
+    std::vector<char*> _slabs;
+    char* _curr;
+    char* _end;
+    size_t _slabSize;
+    size_t _slabBytes;
+    FreeBlock* _freeLists[ARENA_MAX_RECYCLED_SIZE / ARENA_ALIGNMENT + 1];
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+};
+
+}  // namespace utils
+}  // namespace common
+
+#endif  // _COMMON_UTILS_ARENA_HPP
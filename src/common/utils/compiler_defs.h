@@ -62,6 +62,13 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 /* PACKED */
 #define PACKED      __attribute__ ((__packed__))    // GNU and Clang specific
 
+/* ALWAYS_INLINE */
+#define ALWAYS_INLINE   __attribute__ ((__always_inline__)) // GNU and Clang
+
+/* TARGET */
+/// Compile a function for an instruction set extension, e.g. TARGET("avx2")
+#define TARGET(isa)     __attribute__ ((__target__ (isa)))  // GNU and Clang
+
 /* BREAKPOINT */
 #define BREAKPOINT  asm("int $3");  // Platform specific
 
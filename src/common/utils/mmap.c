@@ -26,6 +26,9 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
  * License: GPLv3
  */
 
+#ifdef __linux__
+#define _GNU_SOURCE             // mremap
+#endif  // __linux__
 #include <fcntl.h>
 #include <stdio.h>
 #include <sys/mman.h>
@@ -72,13 +75,11 @@ int mmap_create(const char* path, off_t size, int flags, mmap_handle_t* mmap_han
                          /* offset = */ 0);
     FAIL_ON(mapped_region == MAP_FAILED);
 
-    /* copy to mmap_handle */
+    /* copy to mmap_handle, file descriptor is kept for mmap_resize */
     mmap_handle->path = path;
     mmap_handle->start_addr = mapped_region;
     mmap_handle->size = size;
-
-    /* close file descriptor */
-    (void) close(fd);
+    mmap_handle->fd = fd;
 
     return 0;
 
@@ -115,6 +116,7 @@ int mmap_load(const char* path, int flags, mmap_handle_t* mmap_handle) {
     mmap_handle->path = path;
     mmap_handle->start_addr = mapped_region;
     mmap_handle->size = size;
+    mmap_handle->fd = -1;
 
     /* close file descriptor */
     (void) close(fd);
@@ -128,6 +130,10 @@ fail:
 
 int mmap_unload(mmap_handle_t* mmap_handle) {
     FAIL_ON(munmap(mmap_handle->start_addr, mmap_handle->size) != 0);
+    if (mmap_handle->fd >= 0) {
+        (void) close(mmap_handle->fd);
+        mmap_handle->fd = -1;
+    }
     return 0;
 
 fail:
@@ -141,3 +147,35 @@ int mmap_remove(mmap_handle_t* mmap_handle) {
 fail:
     return  -1;
 }
+
+int mmap_resize(mmap_handle_t* mmap_handle, off_t size, int flags) {
+    char* mapped_region;
+
+    FAIL_ON(mmap_handle->fd < 0);
+
+    /* round up size to page boundary */
+    size = round_to_page_size(size);
+
+    /* resize file */
+    FAIL_ON(ftruncate(mmap_handle->fd, size) != 0);
+
+    /* remap the file */
+#ifdef __linux__
+    UNUSED(flags);
+    mapped_region = mremap(mmap_handle->start_addr, mmap_handle->size, size,
+                           MREMAP_MAYMOVE);
+#else
+    FAIL_ON(munmap(mmap_handle->start_addr, mmap_handle->size) != 0);
+    mapped_region = mmap(/* addr   = */ NULL, size, PROT_READ | PROT_WRITE,
+                         flags, mmap_handle->fd, /* offset = */ 0);
+#endif  // __linux__
+    FAIL_ON(mapped_region == MAP_FAILED);
+
+    mmap_handle->start_addr = mapped_region;
+    mmap_handle->size = size;
+
+    return 0;
+
+fail:
+    return -1;
+}
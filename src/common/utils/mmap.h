@@ -44,7 +44,8 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 typedef struct mmap_handle_s {
     const char* path;
     char*    start_addr;
-    uint32_t size;
+    uint64_t size;
+    int      fd;        /* open until unload for created files, else -1 */
 } mmap_handle_t;
 
 /*--------------------------------------------------------------------------*/
@@ -81,6 +82,15 @@ int mmap_unload(mmap_handle_t* mmap_handle);
  */
 int mmap_remove(mmap_handle_t* mmap_handle);
 
+/**
+ * Resize a file created by mmap_create and remap it. The mapping may move,
+ * so pointers into the old mapping become invalid.
+ *
+ * @return 0 on success
+ * @return -1 on failure
+ */
+int mmap_resize(mmap_handle_t* mmap_handle, off_t size, int flags);
+
 END_DECLS
 
 #endif // __COMMON_UTILS_MMAP_H
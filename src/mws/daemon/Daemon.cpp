@@ -26,6 +26,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   * License: GPL v3
   */
 
+#include <assert.h>
 #include <fcntl.h>              // File control operations
 #include <signal.h>
 #include <stdio.h>
@@ -36,13 +37,15 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <memory>
 using std::unique_ptr;
 #include <stack>
 #include <string>
+using std::string;
 
 #include "common/utils/compiler_defs.h"
-#include "common/utils/memstream.h"
+#include "common/thread/WorkerPool.hpp"
 #include "mws/daemon/GenericResponses.hpp"
 #include "mws/daemon/microhttpd_linux.h"
 #include "mws/query/SearchContext.hpp"
@@ -50,107 +53,117 @@ using std::unique_ptr;
 #include "mws/xmlparser/initxmlparser.hpp"
 #include "mws/xmlparser/processMwsHarvest.hpp"
 #include "mws/xmlparser/readMwsQuery.hpp"
-using mws::xmlparser::readMwsQuery;
+using mws::xmlparser::MwsQueryReader;
 #include "mws/xmlparser/writeJsonAnswset.hpp"
 #include "mws/xmlparser/writeXmlAnswset.hpp"
-using mws::xmlparser::writeXmlAnswset;
+using mws::xmlparser::AnswsetWriter;
+using mws::xmlparser::JsonAnswsetWriter;
+using mws::xmlparser::XmlAnswsetWriter;
+
+#include "build-gen/config.h"
 
 #include "mws/daemon/Daemon.hpp"
 
 namespace mws { namespace daemon {
 
-Config::Config() : useExperimentalQueryEngine(false) {
+/// Bytes of response handed to libmicrohttpd per read callback
+const size_t RESPONSE_BLOCK_SIZE = 32 * 1024;
+
+Config::Config() : useExperimentalQueryEngine(false), numQueryWorkers(0),
+    queryQueueDepth(DEFAULT_QUERY_QUEUE_DEPTH),
+    queryCacheSize(DEFAULT_QUERY_CACHE_SIZE),
+    matchListCacheSize(DEFAULT_MATCH_LIST_CACHE_SIZE),
+    matchListTtl(DEFAULT_MATCH_LIST_TTL), indexLoadFlags(0), warmUpDepth(0),
+    compactSegments(0), compactionWriteRate(0) {
+}
+
+Daemon::Daemon() : _daemonHandler(NULL), _workerPool(NULL) {
 }
 
-Daemon::Daemon() : _daemonHandler(NULL) {
+WorkerPool* Daemon::getWorkerPool() {
+    return _workerPool;
 }
 
 static void cleanupMws() {
     clearxmlparser();
 }
 
-class MemStream {
-    enum Mode {
-        MODE_WRITING,
-        MODE_READING_BUFFER,
-        MODE_READING_FILE
-    } _mode;
-    char* _buffer;
-    size_t _buffer_size;
-    FILE* _input;
-    FILE* _output;
-
- public:
-    struct Buffer {
-        char* data;
-        size_t size;
-
-        Buffer(char* data, size_t size) : data(data), size(size) {
-        }
-    };
-
-    MemStream()
-        : _mode(MODE_WRITING), _buffer(NULL), _buffer_size(0), _output(NULL) {
-        _input = open_memstream(&_buffer, &_buffer_size);
-        assert(_input != NULL);
-    }
-
-    ~MemStream() {
-        switch (_mode) {
-        case MODE_WRITING:
-            closeWritingMode();
-            break;
-        case MODE_READING_FILE:
-            closeReadingFileMode();
-            break;
-        case MODE_READING_BUFFER:
-            break;
-        default:
-            assert(false);
-            break;
-        }
-        assert(_input == NULL);
-        assert(_output == NULL);
-        free(_buffer);
-    }
-
-    FILE* getInput() {
-        return _input;
+/**
+ * @brief Answer set serialized as libmicrohttpd pulls the response, or
+ * rendered at once off the thread polling the connections
+ */
+struct ResponseStream {
+    unique_ptr<MwsAnswset> answset;
+    unique_ptr<AnswsetWriter> writer;
+    /// piece of the document being sent
+    string piece;
+    size_t pieceOffset;
+    size_t bytesSent;
+    bool failed;
+
+    ResponseStream(MwsAnswset* answset, AnswsetWriter* writer)
+        : answset(answset), writer(writer), pieceOffset(0), bytesSent(0),
+          failed(false) {
     }
 
-    FILE* getOutputFile() {
-        closeWritingMode();
-        _mode = MODE_READING_FILE;
-        _output = fmemopen(_buffer, _buffer_size, "r");
-        assert(_output != NULL);
-        return _output;
+    /**
+     * @brief serialize the whole document into piece, releasing the
+     * answer set and the writer
+     * @return 0 on success, -1 on failure
+     */
+    int render() {
+        int ret;
+        while ((ret = writer->writeNext(&piece)) == 1) {}
+        writer.reset();
+        answset.reset();
+        return ret;
     }
+};
 
-    Buffer getOutputBuffer() {
-        closeWritingMode();
-        _mode = MODE_READING_BUFFER;
-        return Buffer(_buffer, _buffer_size);
+static ssize_t
+readResponseStream(void* cls, uint64_t pos, char* buf, size_t max) {
+    ResponseStream* stream = (ResponseStream*) cls;
+    size_t nbytes = 0;
+
+    assert(pos == stream->bytesSent);
+    while (nbytes < max && !stream->failed) {
+        if (stream->pieceOffset == stream->piece.size()) {
+            // A rendered document is a single piece
+            if (stream->writer == NULL) break;
+            stream->piece.clear();
+            stream->pieceOffset = 0;
+            int ret = stream->writer->writeNext(&stream->piece);
+            if (ret == 0) break;
+            if (ret == -1) {
+                PRINT_WARN("Error while writing the Answer Set\n");
+                stream->failed = true;
+            }
+            continue;
+        }
+        size_t n = std::min(max - nbytes,
+                            stream->piece.size() - stream->pieceOffset);
+        memcpy(buf + nbytes, stream->piece.data() + stream->pieceOffset, n);
+        stream->pieceOffset += n;
+        nbytes += n;
     }
+    stream->bytesSent += nbytes;
 
-    Buffer releaseOutputBuffer() {
-        Buffer buffer = getOutputBuffer();
-        _buffer = NULL;
-        return buffer;
+    if (nbytes > 0) {
+        return nbytes;
+    } else if (stream->failed) {
+        return MHD_CONTENT_READER_END_WITH_ERROR;
+    } else {
+        return MHD_CONTENT_READER_END_OF_STREAM;
     }
+}
 
- private:
-    void closeWritingMode() {
-        assert(_mode == MODE_WRITING);
-        fclose(_input);
-        _input = NULL;
-    }
+static void
+freeResponseStream(void* cls) {
+    ResponseStream* stream = (ResponseStream*) cls;
 
-    void closeReadingFileMode() {
-        assert(_mode == MODE_READING_FILE);
-        fclose(_output);
-        _output = NULL;
-    }
-};
+    PRINT_LOG("Response of %zu bytes sent.\n", stream->bytesSent);
+    delete stream;
+}
 
 static int
 my_MHD_AcceptPolicyCallback(void* cls,
@@ -164,109 +177,79 @@ my_MHD_AcceptPolicyCallback(void* cls,
     return MHD_YES;
 }
 
-static int
-my_MHD_AccessHandlerCallback(void*                  cls,
-                             struct MHD_Connection* connection,
-                             const char*            url,
-                             const char*            method,
-                             const char*            version,
-                             const char*            upload_data,
-                             size_t*                upload_data_size,
-                             void**                 ptr) {
-    UNUSED(url);
-    UNUSED(version);
-
-    // On OPTIONS method request different behavior
-    if (0 == strcmp(method, MHD_HTTP_METHOD_OPTIONS)) {
-        return sendOptionsResponse(connection);
-    }
-
-    // Accept only POST requests
-    if (0 != strcmp(method, MHD_HTTP_METHOD_POST)) {
-        return MHD_NO;
-    }
-
-    // Allocate handler data
-    if (*ptr == NULL) {
-        *ptr = new MemStream();
-        return MHD_YES;
-    }
-    MemStream* memstream = (MemStream*) *ptr;
-
-    // Process data
-    if (*upload_data_size) {
-        while (*upload_data_size) {
-            size_t nbytes = fwrite(upload_data, sizeof(char), *upload_data_size,
-                                   memstream->getInput());
-            if (nbytes <= 0) {
-                delete memstream;
-                return MHD_NO;
-            }
+/**
+ * @brief State of a request across the calls of the access handler
+ */
+struct Request {
+    /// Query parsed as it is uploaded
+    MwsQueryReader queryReader;
+    /// Response of a query answered by a worker thread
+    struct MHD_Response* response;
+    unsigned int statusCode;
 
-            upload_data       += nbytes;
-            *upload_data_size -= nbytes;
-        }
-        return MHD_YES;
+    Request() : response(NULL), statusCode(MHD_HTTP_OK) {
     }
+};
 
-    // Parse query
-    unique_ptr<MwsQuery> mwsQuery(readMwsQuery(memstream->getOutputFile()));
-    delete memstream;
+/**
+ * @brief answer a query which was uploaded completely
+ * @param render whether to serialize the answer set now, rather than as
+ * libmicrohttpd sends it
+ * @return response to send with statusCode
+ */
+static struct MHD_Response*
+createQueryResponse(Daemon* daemon, MwsQueryReader* queryReader,
+                    unsigned int* statusCode, bool render) {
+    // Parse the end of the query
+    unique_ptr<MwsQuery> mwsQuery(queryReader->finish());
 
     // Check if query failed or is empty
     if (mwsQuery == NULL || mwsQuery->tokens.size() == 0) {
         PRINT_WARN("Bad query request\n");
-        return sendXmlGenericResponse(connection, XML_MWS_BAD_QUERY,
-                                      MHD_HTTP_BAD_REQUEST);
+        *statusCode = MHD_HTTP_BAD_REQUEST;
+        return createXmlGenericResponse(XML_MWS_BAD_QUERY);
     }
 
     // Process query
 #ifdef APPLY_RESTRICTIONS
     mwsQuery->applyRestrictions();
 #endif
-    Daemon* daemon = (Daemon*) cls;
     unique_ptr<MwsAnswset> answset(daemon->handleQuery(mwsQuery.get()));
     if (answset == NULL) {
         PRINT_WARN("Error while obtaining answer set\n");
-        return sendXmlGenericResponse(connection, XML_MWS_SERVER_ERROR,
-                                      MHD_HTTP_INTERNAL_SERVER_ERROR);
+        *statusCode = MHD_HTTP_INTERNAL_SERVER_ERROR;
+        return createXmlGenericResponse(XML_MWS_SERVER_ERROR);
     }
 
-    // Write answer
-    int ret;
-    MemStream responseData;
+    AnswsetWriter* writer;
     switch (mwsQuery->attrResultOutputFormat) {
     case DATAFORMAT_XML:
-        ret = writeXmlAnswset(answset.get(), responseData.getInput());
+        writer = new XmlAnswsetWriter(answset.get());
         break;
     case DATAFORMAT_JSON:
-        ret = writeJsonAnswset(answset.get(), responseData.getInput());
+        writer = new JsonAnswsetWriter(answset.get());
         break;
     default:
-        ret = writeXmlAnswset(answset.get(), responseData.getInput());
+        writer = new XmlAnswsetWriter(answset.get());
         break;
     }
-    if (ret < 0) {
+    ResponseStream* stream = new ResponseStream(answset.release(), writer);
+    if (render && stream->render() != 0) {
         PRINT_WARN("Error while writing the Answer Set\n");
-        return sendXmlGenericResponse(connection, XML_MWS_SERVER_ERROR,
-                                      MHD_HTTP_INTERNAL_SERVER_ERROR);
-    } else {
-        PRINT_LOG("Response of %d bytes sent.\n", ret);
+        delete stream;
+        *statusCode = MHD_HTTP_INTERNAL_SERVER_ERROR;
+        return createXmlGenericResponse(XML_MWS_SERVER_ERROR);
+    }
+    struct MHD_Response* response =
+            MHD_create_response_from_callback(MHD_SIZE_UNKNOWN,
+                                              RESPONSE_BLOCK_SIZE,
+                                              readResponseStream, stream,
+                                              freeResponseStream);
+    if (response == NULL) {
+        delete stream;
+        *statusCode = MHD_HTTP_INTERNAL_SERVER_ERROR;
+        return createXmlGenericResponse(XML_MWS_SERVER_ERROR);
     }
-
-    // Compose and send response
-    MemStream::Buffer responseDataBuffer = responseData.releaseOutputBuffer();
-    struct MHD_Response* response;
-#ifndef MICROHTTPD_DEPRECATED
-    response = MHD_create_response_from_buffer(responseDataBuffer.size,
-                                               responseDataBuffer.data,
-                                               MHD_RESPMEM_MUST_FREE);
-#else
-    response = MHD_create_response_from_data(responseDataBuffer.size,
-                                             responseDataBuffer.data,
-                                             /* must_free = */ 1,
-                                             /* must_copy = */ 0);
-#endif
     switch (mwsQuery->attrResultOutputFormat) {
     case DATAFORMAT_XML:
         MHD_add_response_header(response, "Content-Type", "text/xml");
@@ -282,16 +265,123 @@ my_MHD_AccessHandlerCallback(void*                  cls,
     MHD_add_response_header(response, "Access-Control-Allow-Origin", "*");
     MHD_add_response_header(response,
                             "Cache-Control", "no-cache, must-revalidate");
-    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
-    MHD_destroy_response(response);
+    *statusCode = MHD_HTTP_OK;
+
+    return response;
+}
+
+static int
+queueResponse(struct MHD_Connection* connection, Request* request) {
+    int ret = MHD_queue_response(connection, request->statusCode,
+                                 request->response);
+    MHD_destroy_response(request->response);
+    delete request;
 
     return ret;
 }
 
-Daemon::~Daemon() {
-    if (_daemonHandler != NULL) {
-        MHD_stop_daemon(_daemonHandler);
+static int
+my_MHD_AccessHandlerCallback(void*                  cls,
+                             struct MHD_Connection* connection,
+                             const char*            url,
+                             const char*            method,
+                             const char*            version,
+                             const char*            upload_data,
+                             size_t*                upload_data_size,
+                             void**                 ptr) {
+    UNUSED(url);
+    UNUSED(version);
+
+    // On OPTIONS method request different behavior
+    if (0 == strcmp(method, MHD_HTTP_METHOD_OPTIONS)) {
+        return sendOptionsResponse(connection);
+    }
+
+    // Accept only POST requests
+    if (0 != strcmp(method, MHD_HTTP_METHOD_POST)) {
+        return MHD_NO;
+    }
+
+    // Allocate handler data
+    if (*ptr == NULL) {
+        *ptr = new Request();
+        return MHD_YES;
     }
+    Request* request = (Request*) *ptr;
+
+    // Send the response of a worker, once the connection is resumed
+    if (request->response != NULL) {
+        *ptr = NULL;
+        return queueResponse(connection, request);
+    }
+
+    // Parse data as it arrives, a malformed query is reported once uploaded
+    if (*upload_data_size) {
+        request->queryReader.push(upload_data, *upload_data_size);
+        *upload_data_size = 0;
+        return MHD_YES;
+    }
+
+    Daemon* daemon = (Daemon*) cls;
+    WorkerPool* workerPool = daemon->getWorkerPool();
+    if (workerPool == NULL) {
+        *ptr = NULL;
+        request->response = createQueryResponse(daemon,
+                                                &request->queryReader,
+                                                &request->statusCode,
+                                                /* render = */ false);
+        return queueResponse(connection, request);
+    }
+
+    // Answer and serialize on a worker thread, releasing MHD to serve
+    // other connections
+    MHD_suspend_connection(connection);
+    bool queued = workerPool->submit([daemon, request, connection]() {
+        request->response = createQueryResponse(daemon,
+                                                &request->queryReader,
+                                                &request->statusCode,
+                                                /* render = */ true);
+        MHD_resume_connection(connection);
+    });
+    if (!queued) {
+        PRINT_WARN("Query queue full\n");
+        request->statusCode = MHD_HTTP_SERVICE_UNAVAILABLE;
+        request->response = createXmlGenericResponse(XML_MWS_BUSY);
+        MHD_resume_connection(connection);
+    }
+
+    return MHD_YES;
+}
+
+/**
+ * @brief free a request whose response was not queued, e.g. when the
+ * client disconnects during the upload
+ *
+ * A connection suspended for a worker completes only once resumed, when
+ * the worker is done with the request.
+ */
+static void
+my_MHD_RequestCompletedCallback(void*                          cls,
+                                struct MHD_Connection*         connection,
+                                void**                         ptr,
+                                enum MHD_RequestTerminationCode toe) {
+    UNUSED(cls);
+    UNUSED(connection);
+    UNUSED(toe);
+
+    Request* request = (Request*) *ptr;
+    if (request == NULL) {
+        return;
+    }
+    if (request->response != NULL) {
+        MHD_destroy_response(request->response);
+    }
+    delete request;
+    *ptr = NULL;
+}
+
+Daemon::~Daemon() {
+    stop();
 }
 
 int Daemon::startAsync(const Config& config) {
@@ -301,15 +391,45 @@ int Daemon::startAsync(const Config& config) {
 
     atexit(cleanupMws);
 
-    _daemonHandler = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION,
-                                      config.mwsPort,
-                                      my_MHD_AcceptPolicyCallback,
-                                      NULL,
-                                      my_MHD_AccessHandlerCallback,
-                                      this,
-                                      MHD_OPTION_CONNECTION_LIMIT,
-                                      20,
-                                      MHD_OPTION_END);
+    if (config.numQueryWorkers == 0) {
+        _daemonHandler = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION |
+                                          MHD_USE_PIPE_FOR_SHUTDOWN,
+                                          config.mwsPort,
+                                          my_MHD_AcceptPolicyCallback,
+                                          NULL,
+                                          my_MHD_AccessHandlerCallback,
+                                          this,
+                                          MHD_OPTION_CONNECTION_LIMIT,
+                                          20,
+                                          MHD_OPTION_NOTIFY_COMPLETED,
+                                          my_MHD_RequestCompletedCallback,
+                                          NULL,
+                                          MHD_OPTION_END);
+    } else {
+        _workerPool = new WorkerPool(config.numQueryWorkers,
+                                     config.queryQueueDepth);
+        if (_workerPool->start() != 0) {
+            PRINT_WARN("Error while starting the query workers\n");
+            return -1;
+        }
+        // A single thread polls the connections, workers answer queries
+        unsigned int flags = MHD_USE_SELECT_INTERNALLY |
+                             MHD_USE_SUSPEND_RESUME |
+                             MHD_USE_PIPE_FOR_SHUTDOWN;
+#ifdef __linux__
+        flags |= MHD_USE_EPOLL_LINUX_ONLY;
+#endif  // __linux__
+        _daemonHandler = MHD_start_daemon(flags,
+                                          config.mwsPort,
+                                          my_MHD_AcceptPolicyCallback,
+                                          NULL,
+                                          my_MHD_AccessHandlerCallback,
+                                          this,
+                                          MHD_OPTION_NOTIFY_COMPLETED,
+                                          my_MHD_RequestCompletedCallback,
+                                          NULL,
+                                          MHD_OPTION_END);
+    }
     if (_daemonHandler == NULL) {
         return -1;
     }
@@ -318,10 +438,27 @@ int Daemon::startAsync(const Config& config) {
 }
 
 void Daemon::stop() {
+    // No new connections, while the open ones are still served
+    if (_daemonHandler != NULL) {
+        MHD_socket listenSocket = MHD_quiesce_daemon(_daemonHandler);
+        if (listenSocket != MHD_INVALID_SOCKET) {
+            close(listenSocket);
+        }
+    }
+    // Suspended connections are resumed by the queued queries, and the
+    // stopped pool refuses the queries arriving after them
+    if (_workerPool != NULL) {
+        _workerPool->stop();
+    }
     if (_daemonHandler != NULL) {
         MHD_stop_daemon(_daemonHandler);
         _daemonHandler = NULL;
     }
+    // The polling thread, which submits to the pool, is joined
+    if (_workerPool != NULL) {
+        delete _workerPool;
+        _workerPool = NULL;
+    }
 }
 
 int Daemon::initMws(const Config& config) {
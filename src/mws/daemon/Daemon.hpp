@@ -31,11 +31,13 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   */
 
 #include <signal.h>
+#include <time.h>
 #include "mws/daemon/microhttpd_linux.h"
 
 #include <vector>
 #include <string>
 
+#include "common/thread/WorkerPool.hpp"
 #include "mws/types/MwsAnswset.hpp"
 #include "mws/types/MwsQuery.hpp"
 #include "mws/index/IndexManager.hpp"
@@ -52,6 +54,28 @@ struct Config {
     index::IndexingOptions   indexingOptions;
     bool                     deleteOldData;
     bool                     useExperimentalQueryEngine;
+    /// Threads answering queries, 0 for a thread per connection
+    unsigned int             numQueryWorkers;
+    /// Queries waiting for a worker before the server reports being busy
+    unsigned int             queryQueueDepth;
+    /// Bytes of answer sets cached by IndexDaemon, 0 to disable the cache
+    size_t                   queryCacheSize;
+    /// Bytes of match lists cached by IndexDaemon to answer later pages of
+    /// a query, 0 to disable the cache
+    size_t                   matchListCacheSize;
+    /// Seconds after which a cached match list expires
+    time_t                   matchListTtl;
+    /// MEMSECTOR_LOAD_* flags used by IndexDaemon to map the index
+    int                      indexLoadFlags;
+    /// Levels of the index below the root read before serving queries
+    unsigned int             warmUpDepth;
+    /// Directory of queries answered before serving queries, if not empty
+    std::string              warmUpQueriesPath;
+    /// Delta segments from which IndexDaemon compacts the index in the
+    /// background, 0 to never compact it
+    unsigned int             compactSegments;
+    /// Bytes written per second when compacting, 0 for no limit
+    uint64_t                 compactionWriteRate;
 
     Config();
 };
@@ -61,6 +85,8 @@ class Daemon {
     int startAsync(const Config& config);
     void stop();
     virtual MwsAnswset* handleQuery(MwsQuery* query) = 0;
+    /// @return pool answering queries, NULL with a thread per connection
+    WorkerPool* getWorkerPool();
     Daemon();
     virtual ~Daemon();
 
@@ -69,6 +95,7 @@ class Daemon {
     Config _config;
  private:
     struct MHD_Daemon* _daemonHandler;
+    WorkerPool* _workerPool;
 };
 }  // namespace daemon
 }  // namespace mws
@@ -47,15 +47,17 @@ const char* XML_MWS_SERVER_ERROR =
     "<mws:info xmlns:mws=\"http://search.mathweb.org/ns\">"
     "Server error</mws:info>";
 
+const char* XML_MWS_BUSY =
+    "<?xml version=\"1.0\"?>\n"
+    "<mws:info xmlns:mws=\"http://search.mathweb.org/ns\">"
+    "Server busy</mws:info>";
+
 const char* EMPTY_RESPONSE = "";
 
-inline int
-sendXmlGenericResponse(struct MHD_Connection* connection,
-                       const char*            xmlGenericResponse,
-                       int                    statusCode)
+inline struct MHD_Response*
+createXmlGenericResponse(const char* xmlGenericResponse)
 {
     struct MHD_Response* response;
-    int                  ret;
 
 #ifdef MICROHTTPD_DEPRECATED
     response = MHD_create_response_from_data(strlen(xmlGenericResponse),
@@ -69,6 +71,19 @@ sendXmlGenericResponse(struct MHD_Connection* connection,
 #endif // MICROHTTPD_DEPRECATED
     MHD_add_response_header(response,
                             "Content-Type", "text/xml");
+
+    return response;
+}
+
+inline int
+sendXmlGenericResponse(struct MHD_Connection* connection,
+                       const char*            xmlGenericResponse,
+                       int                    statusCode)
+{
+    struct MHD_Response* response;
+    int                  ret;
+
+    response = createXmlGenericResponse(xmlGenericResponse);
     ret = MHD_queue_response(connection,
                              statusCode,
                              response);
@@ -32,6 +32,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 
 // System includes
 
+#include <dirent.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -39,6 +40,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include <sys/stat.h>           // POSIX File characteristics
 #include <fcntl.h>              // File control operations
 #include <stdlib.h>
+#include <time.h>
 
 #include <string>
 using std::string;
@@ -48,33 +50,54 @@ using std::vector;
 using std::filebuf;
 using std::istream;
 using std::ios;
+#include <memory>
+using std::shared_ptr;
 #include <stdexcept>
 using std::exception;
 
 #include "mws/dbc/CrawlDb.hpp"
 using mws::dbc::CrawlData;
-#include "mws/dbc/LevFormulaDb.hpp"
-using mws::dbc::LevFormulaDb;
-#include "mws/dbc/LevCrawlDb.hpp"
-using mws::dbc::LevCrawlDb;
 #include "mws/dbc/DbQueryManager.hpp"
 using mws::dbc::DbQueryManager;
 using mws::dbc::DbAnswerCallback;
 #include "mws/index/index.h"
+#include "mws/index/memsector.h"
 #include "mws/index/ExpressionEncoder.hpp"
 using mws::index::QueryEncoder;
 using mws::index::ExpressionInfo;
 #include "mws/index/MeaningDictionary.hpp"
 using mws::index::MeaningDictionary;
+#include "mws/index/MmapMeaningDictionary.hpp"
+using mws::index::MmapMeaningDictionary;
+#include "mws/index/IndexSegments.hpp"
+using mws::index::getDeltaSegments;
+using mws::index::getDeltaSegmentPath;
+using mws::index::getRealPath;
+#include "mws/index/IndexCompaction.hpp"
+using mws::index::CompactionOptions;
+using mws::index::compactIndex;
+#include "mws/index/SegmentDatabases.hpp"
+using mws::index::SegmentDatabasesList;
+using mws::index::openSegmentDatabases;
 #include "mws/index/IndexAccessor.hpp"
 using mws::index::IndexAccessor;
+#include "mws/query/MatchList.hpp"
+using mws::query::MatchList;
+#include "mws/query/MatchListCache.hpp"
+using mws::query::MatchListCache;
+#include "mws/query/QueryCache.hpp"
+using mws::query::QueryCache;
 #include "mws/query/SearchContext.hpp"
 using mws::query::SearchContext;
+#include "mws/query/SegmentedQuery.hpp"
+using mws::query::querySegments;
 #include "mws/query/engine.h"
 #include "mws/types/FormulaPath.hpp"
 using mws::types::FormulaId;
 using mws::types::FormulaPath;
 #include "mws/xmlparser/processMwsHarvest.hpp"
+#include "mws/xmlparser/readMwsQuery.hpp"
+using mws::xmlparser::readMwsQuery;
 #include "mws/xmlparser/writeXmlAnswset.hpp"
 #include "mws/xmlparser/initxmlparser.hpp"
 #include "mws/xmlparser/clearxmlparser.hpp"
@@ -83,6 +106,9 @@ using mws::types::FormulaPath;
 
 namespace mws { namespace daemon {
 
+/// Seconds between checks of the number of delta segments to compact
+const time_t COMPACTION_CHECK_INTERVAL = 60;
+
 struct HandlerStruct {
     MwsAnswset*     result;
     MwsQuery*       mwsQuery;
@@ -119,95 +145,465 @@ result_cb_return_t result_callback(void* _ctxt,
 }
 
 MwsAnswset* IndexDaemon::handleQuery(MwsQuery *query) {
-    MwsAnswset* result = new MwsAnswset;
-    QueryEncoder encoder(meaningDictionary);
+    MwsAnswset* result = NULL;
+
+    pthread_rwlock_rdlock(&queryLock);
+    {
+        // the generation stays loaded until its last query returns
+        shared_ptr<IndexGeneration> generation = getGeneration();
+        if (generation != NULL) {
+            result = answer(generation.get(), query);
+        }
+    }
+    pthread_rwlock_unlock(&queryLock);
+
+    return result;
+}
+
+MwsAnswset* IndexDaemon::answer(IndexGeneration* generation,
+                                MwsQuery* query) {
+    MwsAnswset* result;
+    const vector<IndexSegment*>& segments = generation->segments;
+    QueryCache* queryCache = generation->queryCache;
+    QueryEncoder encoder = (generation->mmapMeaningDictionary != NULL) ?
+            QueryEncoder(generation->mmapMeaningDictionary) :
+            QueryEncoder(generation->meaningDictionary);
     vector<encoded_token_t> encodedQuery;
     ExpressionInfo queryInfo;
 
     if (encoder.encode(_config.indexingOptions,
                        query->tokens[0],
                        &encodedQuery, &queryInfo) == 0) {
-        DbQueryManager dbQueryManager(crawlDb, formulaDb);
-        if (_config.useExperimentalQueryEngine) {
-            HandlerStruct ctxt;
-            ctxt.result = result;
-            ctxt.mwsQuery = query;
-            ctxt.dbQueryManager = &dbQueryManager;
-
-            encoded_formula_t encodedFormula;
-            encodedFormula.data = encodedQuery.data(),
-            encodedFormula.size = encodedQuery.size();
+        result = queryCache->get(encodedQuery, *query);
+        if (result != NULL) {
+            // qvars are encoded by their order, not by their names, so the
+            // answers may have been cached for a query with other names
+            result->qvarNames = queryInfo.qvarNames;
+            result->qvarXpaths = queryInfo.qvarXpaths;
+            return result;
+        }
 
-            query_engine_run(data, &encodedFormula, result_callback, &ctxt);
+        if (_config.useExperimentalQueryEngine) {
+            result = new MwsAnswset;
+            for (IndexSegment* segment : segments) {
+                DbQueryManager dbQueryManager(segment->crawlDb,
+                                              segment->formulaDb);
+                HandlerStruct ctxt;
+                ctxt.result = result;
+                ctxt.mwsQuery = query;
+                ctxt.dbQueryManager = &dbQueryManager;
+
+                encoded_formula_t encodedFormula;
+                encodedFormula.data = encodedQuery.data(),
+                encodedFormula.size = encodedQuery.size();
+
+                query_engine_run(segment->data, &encodedFormula,
+                                 result_callback, &ctxt);
+            }
         } else {
+            // later pages are answered from the matches of the first walk
+            const bool useMatchLists = query->attrResultLimitMin > 0 &&
+                    segments[0]->matchListCache->isEnabled();
             SearchContext ctxt(encodedQuery);
-            result = ctxt.getResult<IndexAccessor>(data,
-                                                   &dbQueryManager,
-                                                   query->attrResultLimitMin,
-                                                   query->attrResultMaxSize,
-                                                   query->attrResultTotalReqNr);
+            // the hits of the delta segments follow those of the base
+            result = querySegments(segments.size(),
+                                   query->attrResultLimitMin,
+                                   query->attrResultMaxSize,
+                                   query->attrResultTotalReqNr,
+                                   [&](size_t i, unsigned int offset,
+                                       unsigned int size,
+                                       unsigned int maxTotal) -> MwsAnswset* {
+                IndexSegment* segment = segments[i];
+                DbQueryManager dbQueryManager(segment->crawlDb,
+                                              segment->formulaDb);
+                if (!useMatchLists) {
+                    return ctxt.getResult<IndexAccessor>(segment->data,
+                                                         &dbQueryManager,
+                                                         offset, size,
+                                                         maxTotal);
+                }
+                MatchListCache* matchListCache = segment->matchListCache;
+                shared_ptr<const MatchList> matches =
+                        matchListCache->get(encodedQuery, maxTotal);
+                if (matches == NULL) {
+                    matches.reset(ctxt.getMatches<IndexAccessor>(
+                            segment->data, maxTotal));
+                    matchListCache->put(encodedQuery, maxTotal, matches);
+                }
+                return matches->getPage(&dbQueryManager, offset, size);
+            });
         }
+        result->qvarNames = queryInfo.qvarNames;
+        result->qvarXpaths = queryInfo.qvarXpaths;
+        queryCache->put(encodedQuery, *query, *result);
+    } else {
+        result = new MwsAnswset;
+        result->qvarNames = queryInfo.qvarNames;
+        result->qvarXpaths = queryInfo.qvarXpaths;
     }
 
-    result->qvarNames = queryInfo.qvarNames;
-    result->qvarXpaths = queryInfo.qvarXpaths;
-
     return result;
 }
 
 int IndexDaemon::initMws(const Config& config) {
     int ret = Daemon::initMws(config);
-    LevCrawlDb* crdb = new LevCrawlDb();
-    LevFormulaDb* fmdb = new LevFormulaDb();
-    string crdbPath = config.dataPath + "/crawl.db";
-    string fmdbPath = config.dataPath + "/formula.db";
 
-    try {
-        crdb->open(crdbPath.c_str());
-        fmdb->open(fmdbPath.c_str());
+    // queries are only accepted once the index is loaded and warmed up
+    IndexGeneration* loaded = loadGeneration(config, NULL);
+    if (loaded == NULL) {
+        return EXIT_FAILURE;
+    }
+    pthread_mutex_lock(&generationLock);
+    generation.reset(loaded);
+    pthread_mutex_unlock(&generationLock);
+
+    if (config.compactSegments > 0 && !compactionStarted) {
+        if (pthread_create(&compactionThread, NULL, compactionMain,
+                           this) == 0) {
+            compactionStarted = true;
+        } else {
+            PRINT_WARN("Cannot start the index compaction\n");
+        }
+    }
+
+    return ret;
+}
 
-        crawlDb = crdb;
-        formulaDb = fmdb;
+int IndexDaemon::reload() {
+    pthread_mutex_lock(&reloadLock);
+    // its LevelDB databases cannot be opened again while it holds them
+    shared_ptr<IndexGeneration> current = getGeneration();
+    IndexGeneration* loaded = loadGeneration(_config, current.get());
+    current.reset();
+    if (loaded == NULL) {
+        pthread_mutex_unlock(&reloadLock);
+        PRINT_WARN("Keeping the previous index\n");
+        return -1;
     }
-    catch(const exception &e) {
-        PRINT_WARN("Initializing database: %s\n", e.what());
-        return EXIT_FAILURE;
+
+    shared_ptr<IndexGeneration> previous(loaded);
+    pthread_mutex_lock(&generationLock);
+    generation.swap(previous);
+    pthread_mutex_unlock(&generationLock);
+    pthread_mutex_unlock(&reloadLock);
+
+    // unloaded here, or by the last query still using it
+    previous.reset();
+
+    return 0;
+}
+
+shared_ptr<IndexGeneration> IndexDaemon::getGeneration() {
+    pthread_mutex_lock(&generationLock);
+    shared_ptr<IndexGeneration> current = generation;
+    pthread_mutex_unlock(&generationLock);
+
+    return current;
+}
+
+void* IndexDaemon::compactionMain(void* indexDaemon) {
+    static_cast<IndexDaemon*>(indexDaemon)->compactInBackground();
+    return NULL;
+}
+
+bool IndexDaemon::isCompactionStopped() {
+    pthread_mutex_lock(&compactionLock);
+    bool stopped = compactionStopped;
+    pthread_mutex_unlock(&compactionLock);
+
+    return stopped;
+}
+
+void IndexDaemon::compactInBackground() {
+    CompactionOptions options;
+    options.maxWriteRate = _config.compactionWriteRate;
+    // a compaction in progress is abandoned when the daemon is destroyed
+    options.isCancelled = [this]() { return isCompactionStopped(); };
+
+    pthread_mutex_lock(&compactionLock);
+    while (!compactionStopped) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += COMPACTION_CHECK_INTERVAL;
+        pthread_cond_timedwait(&compactionCond, &compactionLock, &deadline);
+        if (compactionStopped) break;
+        pthread_mutex_unlock(&compactionLock);
+
+        size_t numDeltas = getDeltaSegments(_config.dataPath).size();
+        if (numDeltas >= _config.compactSegments) {
+            PRINT_LOG("Compacting %d delta segments of %s\n",
+                      (int) numDeltas, _config.dataPath.c_str());
+            compactAndReload(options);
+        }
+
+        pthread_mutex_lock(&compactionLock);
+    }
+    pthread_mutex_unlock(&compactionLock);
+}
+
+void IndexDaemon::compactAndReload(CompactionOptions options) {
+    bool hasLevelDb = false;
+    bool suspended = false;
+    int ret;
+
+    // the directory the generation was loaded from, not a link to it
+    const string indexPath = getRealPath(_config.dataPath);
+    if (indexPath.empty()) {
+        PRINT_WARN("Cannot find index %s\n", _config.dataPath.c_str());
+        return;
+    }
+
+    // the LevelDB databases of the index are locked by the daemon
+    shared_ptr<IndexGeneration> current = getGeneration();
+    if (current != NULL) {
+        for (IndexSegment* segment : current->segments) {
+            options.databases.push_back(segment->databases);
+            hasLevelDb |= segment->databases->isLevelDb;
+        }
+    }
+    current.reset();
+    if (hasLevelDb) {
+        options.beforeSwap = [this, &options, &suspended]() {
+            // once moved, they would read the files of the compacted index
+            options.databases.clear();
+            pthread_mutex_lock(&reloadLock);
+            pthread_rwlock_wrlock(&queryLock);
+            pthread_mutex_lock(&generationLock);
+            generation.reset();
+            pthread_mutex_unlock(&generationLock);
+            suspended = true;
+        };
+    }
+
+    ret = compactIndex(indexPath, options);
+    if (suspended) {
+        // loaded again even if the swap failed
+        IndexGeneration* loaded = loadGeneration(_config, NULL);
+        if (loaded == NULL) {
+            PRINT_WARN("No index loaded, send SIGHUP to load it again\n");
+        }
+        pthread_mutex_lock(&generationLock);
+        generation.reset(loaded);
+        pthread_mutex_unlock(&generationLock);
+        pthread_rwlock_unlock(&queryLock);
+        pthread_mutex_unlock(&reloadLock);
+        if (ret > 0 && loaded != NULL) {
+            PRINT_LOG("Reloaded compacted index\n");
+        }
+    } else if (ret > 0 && reload() == 0) {
+        PRINT_LOG("Reloaded compacted index\n");
+    }
+}
+
+IndexGeneration* IndexDaemon::loadGeneration(
+        const Config& config, const IndexGeneration* previous) {
+    // an index swapped in by retargeting a symbolic link is opened under
+    // other paths than the one it replaces
+    const string dataPath = getRealPath(config.dataPath);
+    if (dataPath.empty()) {
+        PRINT_WARN("Cannot find index %s\n", config.dataPath.c_str());
+        return NULL;
+    }
+    SegmentDatabasesList opened;
+    if (previous != NULL) {
+        for (IndexSegment* segment : previous->segments) {
+            opened.push_back(segment->databases);
+        }
     }
 
+    IndexGeneration* loaded = new IndexGeneration();
+    IndexSegment* segment = loadSegment(dataPath, config, opened);
+    if (segment == NULL) {
+        delete loaded;
+        return NULL;
+    }
+    loaded->segments.push_back(segment);
+    for (int n : getDeltaSegments(dataPath)) {
+        segment = loadSegment(getDeltaSegmentPath(dataPath, n), config,
+                              opened);
+        if (segment == NULL) {
+            delete loaded;
+            return NULL;
+        }
+        loaded->segments.push_back(segment);
+    }
+    if (loaded->segments.size() > 1) {
+        PRINT_LOG("Loaded %d delta segments\n",
+                  (int) loaded->segments.size() - 1);
+    }
+
+    // answers are only valid for the index they were computed on
+    loaded->queryCache = new QueryCache(config.queryCacheSize);
+
     /*
-     * Initializing data
+     * Initializing meaningDictionary, shared by all segments
      */
-    string ms_path = config.dataPath + "/memsector.dat";
-    memsector_handle_t msHandle;
-    memsector_load(&msHandle, ms_path.c_str());
+    const string meaningPath = dataPath + "/meaning.dat";
+    const string meaningIndexPath = dataPath + "/meaning.idx";
+    if (MmapMeaningDictionary::isUpToDate(meaningIndexPath.c_str(),
+                                          meaningPath.c_str())) {
+        loaded->mmapMeaningDictionary = new MmapMeaningDictionary();
+        try {
+            loaded->mmapMeaningDictionary->open(meaningIndexPath.c_str());
+        } catch (const exception &e) {
+            PRINT_WARN("%s\n", e.what());
+            delete loaded->mmapMeaningDictionary;
+            loaded->mmapMeaningDictionary = NULL;
+        }
+    } else if (access(meaningIndexPath.c_str(), F_OK) == 0) {
+        PRINT_WARN("%s is older than %s, ignoring it\n",
+                   meaningIndexPath.c_str(), meaningPath.c_str());
+    }
+    if (loaded->mmapMeaningDictionary == NULL) {
+        // indexes built before meaning.idx was written
+        loaded->meaningDictionary = new MeaningDictionary();
+        filebuf fb;
+        istream os(&fb);
+        fb.open(meaningPath.c_str(), ios::in);
+        loaded->meaningDictionary->load(os);
+        fb.close();
+    }
+
+    warmUp(loaded, config);
+
+    return loaded;
+}
+
+IndexSegment* IndexDaemon::loadSegment(const string& path,
+                                       const Config& config,
+                                       const SegmentDatabasesList& opened) {
+    IndexSegment* loaded = new IndexSegment();
 
-    data = new index_handle_t;
-    *data = msHandle.index;
+    // memory mapped for indexes built with mws-index --mmap-databases
+    loaded->databases = openSegmentDatabases(path, opened);
+    if (loaded->databases == NULL) {
+        delete loaded;
+        return NULL;
+    }
+    loaded->crawlDb = loaded->databases->crawlDb;
+    loaded->formulaDb = loaded->databases->formulaDb;
 
     /*
-     * Initializing meaningDictionary
+     * Initializing data
      */
-    meaningDictionary = new MeaningDictionary();
-    filebuf fb;
-    istream os(&fb);
-    fb.open((config.dataPath + "/meaning.dat").c_str(), ios::in);
-    meaningDictionary->load(os);
-    fb.close();
+    string ms_path = path + "/memsector.dat";
+    if (memsector_load_flags(&loaded->memsector, ms_path.c_str(),
+                             config.indexLoadFlags) != 0) {
+        PRINT_WARN("Cannot load index %s\n", ms_path.c_str());
+        delete loaded;
+        return NULL;
+    }
+    loaded->data = &loaded->memsector.index;
 
-    return ret;
+    loaded->matchListCache = new MatchListCache(config.matchListCacheSize,
+                                                config.matchListTtl);
+
+    return loaded;
+}
+
+void IndexDaemon::warmUp(IndexGeneration* generation, const Config& config) {
+    if (config.warmUpDepth > 0) {
+        uint64_t numNodes = 0;
+        for (IndexSegment* segment : generation->segments) {
+            numNodes += index_warm_up(segment->data, config.warmUpDepth);
+        }
+        PRINT_LOG("Warmed up %llu index nodes\n",
+                  (unsigned long long) numNodes);
+    }
+
+    if (config.warmUpQueriesPath.empty()) return;
+    DIR* dir = opendir(config.warmUpQueriesPath.c_str());
+    if (dir == NULL) {
+        PRINT_WARN("Cannot open warm-up queries %s\n",
+                   config.warmUpQueriesPath.c_str());
+        return;
+    }
+    int numQueries = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        string path = config.warmUpQueriesPath + "/" + entry->d_name;
+        FILE* file = fopen(path.c_str(), "r");
+        if (file == NULL) continue;
+        MwsQuery* query = readMwsQuery(file);
+        fclose(file);
+        if (query == NULL) {
+            PRINT_WARN("Skipping malformed warm-up query %s\n",
+                       path.c_str());
+            continue;
+        }
+        delete answer(generation, query);
+        delete query;
+        numQueries++;
+    }
+    closedir(dir);
+    PRINT_LOG("Answered %d warm-up queries\n", numQueries);
 }
 
-IndexDaemon::IndexDaemon() : data(NULL),
-                             crawlDb(NULL),
-                             formulaDb(NULL),
-                             meaningDictionary(NULL) {
+IndexSegment::IndexSegment() : data(NULL),
+                               crawlDb(NULL),
+                               formulaDb(NULL),
+                               matchListCache(NULL) {
 }
 
-IndexDaemon::~IndexDaemon() {
+IndexSegment::~IndexSegment() {
+    if (matchListCache) {
+        PRINT_LOG("Match list cache: %llu hits, %llu misses\n",
+                  (unsigned long long) matchListCache->getHits(),
+                  (unsigned long long) matchListCache->getMisses());
+        delete matchListCache;
+    }
+    if (data) memsector_unload(&memsector);
+}
+
+IndexGeneration::IndexGeneration() : meaningDictionary(NULL),
+                                     mmapMeaningDictionary(NULL),
+                                     queryCache(NULL) {
+}
+
+IndexGeneration::~IndexGeneration() {
+    if (queryCache) {
+        PRINT_LOG("Query cache: %llu hits, %llu misses\n",
+                  (unsigned long long) queryCache->getHits(),
+                  (unsigned long long) queryCache->getMisses());
+        delete queryCache;
+    }
+    for (IndexSegment* segment : segments) {
+        delete segment;
+    }
     if (meaningDictionary) delete meaningDictionary;
-    if (crawlDb) delete crawlDb;
-    if (formulaDb) delete formulaDb;
-    if (data) delete data;
+    if (mmapMeaningDictionary) delete mmapMeaningDictionary;
+}
+
+IndexDaemon::IndexDaemon() : compactionStarted(false),
+                             compactionStopped(false) {
+    pthread_mutex_init(&generationLock, NULL);
+    pthread_mutex_init(&reloadLock, NULL);
+    pthread_rwlockattr_t queryLockAttr;
+    pthread_rwlockattr_init(&queryLockAttr);
+    // the compaction waiting for it is not delayed by the next queries
+    pthread_rwlockattr_setkind_np(&queryLockAttr,
+            PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&queryLock, &queryLockAttr);
+    pthread_rwlockattr_destroy(&queryLockAttr);
+    pthread_mutex_init(&compactionLock, NULL);
+    pthread_cond_init(&compactionCond, NULL);
+}
+
+IndexDaemon::~IndexDaemon() {
+    if (compactionStarted) {
+        pthread_mutex_lock(&compactionLock);
+        compactionStopped = true;
+        pthread_cond_signal(&compactionCond);
+        pthread_mutex_unlock(&compactionLock);
+        pthread_join(compactionThread, NULL);
+    }
+    pthread_cond_destroy(&compactionCond);
+    pthread_mutex_destroy(&compactionLock);
+    generation.reset();
+    pthread_rwlock_destroy(&queryLock);
+    pthread_mutex_destroy(&reloadLock);
+    pthread_mutex_destroy(&generationLock);
 }
 
 }  // namespace daemon
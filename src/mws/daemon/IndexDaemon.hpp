@@ -34,7 +34,14 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   *
   */
 
+#include <pthread.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "mws/index/index.h"
+#include "mws/index/memsector.h"
 
 #include "Daemon.hpp"
 #include "mws/dbc/FormulaDb.hpp"
@@ -42,22 +49,110 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include "mws/dbc/LevFormulaDb.hpp"
 #include "mws/dbc/LevCrawlDb.hpp"
 #include "mws/index/MeaningDictionary.hpp"
+#include "mws/index/MmapMeaningDictionary.hpp"
 #include "mws/index/IndexManager.hpp"
+#include "mws/index/IndexCompaction.hpp"
+#include "mws/index/SegmentDatabases.hpp"
+#include "mws/query/MatchListCache.hpp"
+#include "mws/query/QueryCache.hpp"
 
 namespace mws { namespace daemon {
 
+/**
+ * @brief Base or delta segment of an index, with its own formula and crawl
+ * ids
+ */
+struct IndexSegment {
+    memsector_handle_t memsector;
+    index_handle_t* data;
+    /// Shared with the compaction, which cannot open them again
+    std::shared_ptr<index::SegmentDatabases> databases;
+    dbc::CrawlDb* crawlDb;
+    dbc::FormulaDb* formulaDb;
+    /// Matches of queries on this segment only
+    query::MatchListCache* matchListCache;
+
+    IndexSegment();
+    ~IndexSegment();
+ private:
+    IndexSegment(const IndexSegment&);
+    IndexSegment& operator=(const IndexSegment&);
+};
+
+/**
+ * @brief Index loaded from a data path, with the databases and caches
+ * answering queries on it. Each query holds the generation it started on,
+ * which is unloaded when the last of them returns.
+ */
+struct IndexGeneration {
+    /// Base segment followed by the delta segments, in append order
+    std::vector<IndexSegment*> segments;
+    /// Exactly one of the dictionaries is loaded
+    index::MeaningDictionary* meaningDictionary;
+    index::MmapMeaningDictionary* mmapMeaningDictionary;
+    query::QueryCache* queryCache;
+
+    IndexGeneration();
+    ~IndexGeneration();
+ private:
+    IndexGeneration(const IndexGeneration&);
+    IndexGeneration& operator=(const IndexGeneration&);
+};
+
 class IndexDaemon : public Daemon {
  public:
     IndexDaemon();
     ~IndexDaemon();
+
+    /**
+     * @brief load the index of the data path again and answer the following
+     * queries with it. Queries in flight finish on the previous index.
+     * @return 0 on success, -1 if the new index cannot be loaded, in which
+     * case the previous one is kept
+     */
+    int reload();
  private:
     MwsAnswset* handleQuery(MwsQuery *query);
     int initMws(const Config& config);
+    /**
+     * @return index of config.dataPath, warmed up, or NULL on failure
+     * @param previous generation whose LevelDB databases are shared, if the
+     * data path still resolves to their directories
+     */
+    IndexGeneration* loadGeneration(const Config& config,
+                                    const IndexGeneration* previous);
+    /// @return segment stored in path, or NULL on failure
+    IndexSegment* loadSegment(const std::string& path, const Config& config,
+                              const index::SegmentDatabasesList& opened);
+    /// Make the index resident as configured before queries are served
+    void warmUp(IndexGeneration* generation, const Config& config);
+    MwsAnswset* answer(IndexGeneration* generation, MwsQuery* query);
+    std::shared_ptr<IndexGeneration> getGeneration();
+    /**
+     * @brief compact the index and answer the following queries with it.
+     * Queries wait while LevelDB databases of the index are swapped, which
+     * are closed before and opened again after.
+     */
+    void compactAndReload(index::CompactionOptions options);
+    /// Compact the index and reload it whenever it has
+    /// Config::compactSegments delta segments, until the daemon is destroyed
+    void compactInBackground();
+    static void* compactionMain(void* indexDaemon);
+    bool isCompactionStopped();
  private:
-    index_handle_t* data;
-    dbc::CrawlDb* crawlDb;
-    dbc::FormulaDb* formulaDb;
-    index::MeaningDictionary* meaningDictionary;
+    /// Generation answering new queries, guarded by generationLock
+    std::shared_ptr<IndexGeneration> generation;
+    pthread_mutex_t generationLock;
+    /// Serializes reloads
+    pthread_mutex_t reloadLock;
+    /// Held by queries, and exclusively while the index has no generation
+    pthread_rwlock_t queryLock;
+    pthread_t compactionThread;
+    bool compactionStarted;
+    /// Set when the daemon is destroyed, guarded by compactionLock
+    bool compactionStopped;
+    pthread_mutex_t compactionLock;
+    pthread_cond_t compactionCond;
 };
 }  // namespace daemon
 }  // namespace mws
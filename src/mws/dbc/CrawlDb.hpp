@@ -28,6 +28,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   */
 
 #include <string>
+#include <vector>
 
 namespace mws {
 namespace dbc {
@@ -59,6 +60,22 @@ public:
      */
     virtual const CrawlData getData(const CrawlId& crawlId)
     throw(std::exception) = 0;
+
+    /**
+     * @brief get crawled data of several crawl elements
+     * @param crawlIds ids of the crawl elements, without duplicates
+     * @param crawlData CrawlData corresponding to each of crawlIds
+     * @throw NotFound or I/O exceptions
+     */
+    virtual void getDataBatch(const std::vector<CrawlId>& crawlIds,
+                              std::vector<CrawlData>* crawlData)
+    throw(std::exception) {
+        crawlData->clear();
+        crawlData->reserve(crawlIds.size());
+        for (const CrawlId& crawlId : crawlIds) {
+            crawlData->push_back(getData(crawlId));
+        }
+    }
 };
 
 }  // namespace dbc
@@ -30,7 +30,13 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <string>
+#include <utility>
+using std::pair;
+using std::make_pair;
+#include <vector>
+using std::vector;
 
 #include "common/utils/compiler_defs.h"
 #include "mws/types/MwsAnswset.hpp"
@@ -64,5 +70,50 @@ DbQueryManager::query(types::FormulaId formulaId,
                                     formulaQueryCallback);
 }
 
+int
+DbQueryManager::query(const vector<FormulaQuery>& formulaQueries,
+                      DbAnswerCallback dbAnswerCallback) {
+    vector<vector<pair<CrawlId, types::FormulaPath> > >
+            hits(formulaQueries.size());
+    BatchQueryCallback formulaQueryCallback =
+            [&hits](size_t i, const CrawlId& crawlId,
+                    const types::FormulaPath& formulaPath) {
+        hits[i].push_back(make_pair(crawlId, formulaPath));
+        return 0;
+    };
+    if (mFormulaDb->queryFormulae(formulaQueries, formulaQueryCallback) != 0) {
+        return -1;
+    }
+
+    // hits of the same document share its crawl data
+    vector<CrawlId> crawlIds;
+    for (const auto& formulaHits : hits) {
+        for (const auto& hit : formulaHits) {
+            if (hit.first != CRAWLID_NULL) crawlIds.push_back(hit.first);
+        }
+    }
+    std::sort(crawlIds.begin(), crawlIds.end());
+    crawlIds.erase(std::unique(crawlIds.begin(), crawlIds.end()),
+                   crawlIds.end());
+    vector<CrawlData> crawlData;
+    if (!crawlIds.empty()) mCrawlDb->getDataBatch(crawlIds, &crawlData);
+
+    for (const auto& formulaHits : hits) {
+        for (const auto& hit : formulaHits) {
+            int ret;
+            if (hit.first != CRAWLID_NULL) {
+                size_t i = std::lower_bound(crawlIds.begin(), crawlIds.end(),
+                                            hit.first) - crawlIds.begin();
+                ret = dbAnswerCallback(hit.second, crawlData[i]);
+            } else {
+                ret = dbAnswerCallback(hit.second, CRAWLDATA_NULL);
+            }
+            if (ret != 0) return -1;
+        }
+    }
+
+    return 0;
+}
+
 }  // namespace dbc
 }  // namespace mws
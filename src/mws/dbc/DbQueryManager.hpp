@@ -28,6 +28,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #define _MWS_DBC_DBQUERYMANAGER_HPP
 
 #include <functional>
+#include <vector>
 
 #include "mws/dbc/CrawlDb.hpp"
 #include "mws/dbc/FormulaDb.hpp"
@@ -50,6 +51,18 @@ class DbQueryManager {
               unsigned limitSize,
               DbAnswerCallback dbAnswerCallback);
 
+    /**
+     * @brief query the hits of several formulae, sweeping each database
+     * once in key order and reading the crawl data of each crawl element
+     * once
+     * @param formulaQueries formulae and hits to query
+     * @param dbAnswerCallback called for each hit, in the order of
+     * formulaQueries
+     * @return 0 on success and -1 on failure.
+     */
+    int query(const std::vector<FormulaQuery>& formulaQueries,
+              DbAnswerCallback dbAnswerCallback);
+
  private:
     DbQueryManager(const DbQueryManager&);
     DbQueryManager& operator=(const DbQueryManager&);
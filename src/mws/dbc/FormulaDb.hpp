@@ -28,6 +28,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   */
 
 #include <functional>
+#include <vector>
 
 #include "mws/types/FormulaPath.hpp"
 #include "mws/dbc/CrawlDb.hpp"
@@ -37,6 +38,21 @@ namespace mws { namespace dbc {
 typedef std::function<int (const CrawlId&,
                            const mws::types::FormulaPath&)> QueryCallback;
 
+/**
+ * @brief Hits of a formula requested along with others
+ */
+struct FormulaQuery {
+    mws::types::FormulaId formulaId;
+    unsigned limitMin;
+    unsigned limitSize;
+};
+
+/// Called with the position of the FormulaQuery a hit answers
+typedef std::function<int (size_t,
+                           const CrawlId&,
+                           const mws::types::FormulaPath&)>
+BatchQueryCallback;
+
 class FormulaDb {
 public:
     virtual ~FormulaDb() {}
@@ -65,6 +81,31 @@ public:
                              unsigned limitMin,
                              unsigned limitSize,
                              QueryCallback queryCallback) = 0;
+
+    /**
+     * @brief query several formulae in database. The hits of each formula
+     * are passed in order, but formulae may be answered in any order.
+     * @param formulaQueries formulae and hits to query
+     * @param queryCallback
+     * @return 0 on success and -1 on failure.
+     */
+    virtual int queryFormulae(const std::vector<FormulaQuery>& formulaQueries,
+                              BatchQueryCallback queryCallback) {
+        for (size_t i = 0; i < formulaQueries.size(); i++) {
+            const FormulaQuery& formulaQuery = formulaQueries[i];
+            QueryCallback callback = [i, &queryCallback](
+                    const CrawlId& crawlId,
+                    const mws::types::FormulaPath& formulaPath) {
+                return queryCallback(i, crawlId, formulaPath);
+            };
+            if (queryFormula(formulaQuery.formulaId, formulaQuery.limitMin,
+                             formulaQuery.limitSize, callback) != 0) {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
 };
 
 } }
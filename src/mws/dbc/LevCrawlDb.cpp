@@ -30,10 +30,15 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <memory>
+using std::unique_ptr;
 #include <stdexcept>
 using std::runtime_error;
 #include <string>
 using std::string;
+#include <vector>
+using std::vector;
 #include <leveldb/db.h>
 using leveldb::DB;
 using leveldb::Options;
@@ -64,7 +69,7 @@ void LevCrawlDb::open(const char* path) throw (runtime_error) {
         leveldb::DB::Open(options, path, &mDatabase);
 
     if (!status.ok()) {
-        throw std::runtime_error(string(path) + " not found.");
+        throw std::runtime_error(status.ToString());
     }
 }
 
@@ -125,6 +130,39 @@ throw (std::exception) {
     return retrieved;
 }
 
+void LevCrawlDb::getDataBatch(const vector<CrawlId>& crawlIds,
+                              vector<CrawlData>* crawlData)
+throw (std::exception) {
+    vector<string> keys;
+    vector<size_t> order;
+
+    for (const CrawlId& crawlId : crawlIds) {
+        keys.push_back(std::to_string(crawlId));
+        order.push_back(order.size());
+    }
+    // keys are compared as strings, not as the ids they print
+    std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+        return keys[a] < keys[b];
+    });
+
+    crawlData->assign(crawlIds.size(), CRAWLDATA_NULL);
+    unique_ptr<leveldb::Iterator> it(
+            mDatabase->NewIterator(leveldb::ReadOptions()));
+    for (size_t i : order) {
+        // consecutive keys are read without seeking
+        if (it->Valid()) it->Next();
+        if (!it->Valid() || it->key().compare(keys[i]) != 0) {
+            it->Seek(keys[i]);
+        }
+        if (!it->Valid() || it->key().compare(keys[i]) != 0) {
+            throw std::runtime_error("No data corresponding to crawlId = " +
+                                     keys[i]);
+        }
+        leveldb::Slice retrieved = it->value();
+        ParcelDecoder decoder(retrieved.data(), retrieved.size());
+        decoder.decode(&(*crawlData)[i]);
+    }
+}
 
 }  // namespace dbc
 }  // namespace mws
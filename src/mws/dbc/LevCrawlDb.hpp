@@ -32,6 +32,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <leveldb/db.h>
 
 #include "mws/dbc/CrawlDb.hpp"
@@ -66,6 +67,17 @@ class LevCrawlDb : public CrawlDb {
     virtual const CrawlData getData(const CrawlId& crawlId)
     throw (std::exception);
 
+    /**
+     * @brief get crawled data of several crawl elements, seeking a single
+     * iterator through their keys in ascending order
+     * @param crawlIds ids of the crawl elements, without duplicates
+     * @param crawlData CrawlData corresponding to each of crawlIds
+     * @throw NotFound or I/O exceptions
+     */
+    virtual void getDataBatch(const std::vector<CrawlId>& crawlIds,
+                              std::vector<CrawlData>* crawlData)
+    throw (std::exception);
+
  private:
     leveldb::DB* mDatabase;
     CrawlId mNextCrawlId;
@@ -25,27 +25,115 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   * @date 11 Dec 2013
   */
 
-#include <stdlib.h>
+#include <stdint.h>
 
+#include <algorithm>
+#include <memory>
+using std::unique_ptr;
 #include <stdexcept>
 using std::runtime_error;
 #include <string>
 using std::string;
+#include <utility>
+#include <vector>
+using std::vector;
 #include <leveldb/db.h>
 using leveldb::DestroyDB;
 using leveldb::DB;
 using leveldb::Options;
 using leveldb::Status;
 
-#include "common/types/Parcelable.hpp"
-using common::types::ParcelAllocator;
-using common::types::ParcelEncoder;
-using common::types::ParcelDecoder;
 #include "mws/dbc/LevFormulaDb.hpp"
 
 namespace mws { namespace dbc {
 
-LevFormulaDb::LevFormulaDb() : mDatabase(NULL), mCounter(0) {
+/*
+ * Schema: a formula hit is stored under the key
+ *     formulaId (4 bytes, big-endian) ordinal (4 bytes, big-endian)
+ * where ordinal numbers the hits of each formula from 0 in insertion order.
+ * The Nth hit of a formula is found with a single Seek, and the number of
+ * hits of a formula is the ordinal of its last key plus one.
+ * The value is
+ *     crawlId (4 bytes, big-endian) varint(xmlId size) xmlId xpath
+ * The schema version is stored under SCHEMA_KEY, which is too short to
+ * share the 4 byte prefix of any formula.
+ */
+const char LevFormulaDb::SCHEMA_KEY[] = "mws";
+const char LevFormulaDb::SCHEMA_VERSION[] = "2";
+
+static const size_t PREFIX_SIZE = 4;
+static const size_t KEY_SIZE = 8;
+
+static inline void putUint32(string* out, uint32_t value) {
+    out->push_back((char) (value >> 24));
+    out->push_back((char) (value >> 16));
+    out->push_back((char) (value >> 8));
+    out->push_back((char) value);
+}
+
+static inline uint32_t getUint32(const char* data) {
+    const unsigned char* bytes = (const unsigned char*) data;
+    return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) |
+           ((uint32_t) bytes[2] << 8)  | (uint32_t) bytes[3];
+}
+
+static inline string encodePrefix(types::FormulaId formulaId) {
+    string prefix;
+    prefix.reserve(PREFIX_SIZE);
+    putUint32(&prefix, formulaId);
+    return prefix;
+}
+
+static inline string encodeKey(types::FormulaId formulaId, uint32_t ordinal) {
+    string key;
+    key.reserve(KEY_SIZE);
+    putUint32(&key, formulaId);
+    putUint32(&key, ordinal);
+    return key;
+}
+
+static string encodeValue(const CrawlId& crawlId,
+                          const types::FormulaPath& formulaPath) {
+    string value;
+    value.reserve(4 + 5 + formulaPath.xmlId.size() +
+                  formulaPath.xpath.size());
+    putUint32(&value, crawlId);
+    size_t size = formulaPath.xmlId.size();
+    while (size >= 0x80) {
+        value.push_back((char) (0x80 | (size & 0x7f)));
+        size >>= 7;
+    }
+    value.push_back((char) size);
+    value.append(formulaPath.xmlId);
+    value.append(formulaPath.xpath);
+    return value;
+}
+
+static int decodeValue(const leveldb::Slice& value, CrawlId* crawlId,
+                       types::FormulaPath* formulaPath) {
+    const char* curr = value.data();
+    const char* end = curr + value.size();
+
+    if (end - curr < 4) return -1;
+    *crawlId = getUint32(curr);
+    curr += 4;
+
+    size_t size = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (curr == end || shift > 28) return -1;
+        unsigned char byte = *curr++;
+        size |= (size_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    if ((size_t) (end - curr) < size) return -1;
+    formulaPath->xmlId.assign(curr, size);
+    curr += size;
+    formulaPath->xpath.assign(curr, end - curr);
+
+    return 0;
+}
+
+LevFormulaDb::LevFormulaDb() : mDatabase(NULL), mCreated(false) {
 }
 
 LevFormulaDb::~LevFormulaDb() {
@@ -60,6 +148,28 @@ void LevFormulaDb::open(const char* path) throw (runtime_error) {
     if (!status.ok()) {
         throw runtime_error(status.ToString());
     }
+
+    string version;
+    status = mDatabase->Get(leveldb::ReadOptions(), SCHEMA_KEY, &version);
+    if (status.ok() && version == SCHEMA_VERSION) return;
+
+    string error;
+    if (status.ok()) {
+        error = string(path) + " has unknown schema version " + version;
+    } else if (status.IsNotFound()) {
+        unique_ptr<leveldb::Iterator> it(
+                mDatabase->NewIterator(leveldb::ReadOptions()));
+        it->SeekToFirst();
+        if (!it->Valid()) return;  // empty database
+        error = string(path) + " uses the decimal key schema, "
+                "convert it with mws-formula-db-migrate";
+    } else {
+        error = status.ToString();
+    }
+
+    delete mDatabase;
+    mDatabase = NULL;
+    throw runtime_error(error);
 }
 
 void LevFormulaDb::create_new(const char* path, bool deleteIfExists)
@@ -75,6 +185,12 @@ throw (runtime_error) {
     if (!status.ok()) {
         throw runtime_error(status.ToString());
     }
+    mCreated = true;
+    status = mDatabase->Put(leveldb::WriteOptions(), SCHEMA_KEY,
+                            SCHEMA_VERSION);
+    if (!status.ok()) {
+        throw runtime_error(status.ToString());
+    }
 }
 
 
@@ -82,57 +198,63 @@ int
 LevFormulaDb::insertFormula(const types::FormulaId&   formulaId,
                             const CrawlId&     crawlId,
                             const types::FormulaPath& formulaPath) {
-    ++mCounter;
-
-    std::string crawlId_str = std::to_string(crawlId);
-    ParcelAllocator allocator;
-    allocator.reserve(crawlId_str);
-    allocator.reserve(formulaPath);
-    ParcelEncoder encoder(allocator);
-    encoder.encode(crawlId_str);
-    encoder.encode(formulaPath);
-
-    std::string key =
-    std::to_string(formulaId) + "!" + std::to_string(mCounter);
-    std::string value(encoder.getData(), encoder.getSize());
+    auto ret = mCounts.insert(std::make_pair(formulaId, 0));
+    // formulae of databases opened for appending may already have hits
+    if (ret.second && !mCreated) {
+        ret.first->second = getCount(formulaId);
+    }
+    uint32_t& count = ret.first->second;
 
     leveldb::Status status =
-        mDatabase->Put(leveldb::WriteOptions(), key, value);
+        mDatabase->Put(leveldb::WriteOptions(),
+                       encodeKey(formulaId, count),
+                       encodeValue(crawlId, formulaPath));
 
     if (!status.ok()) return -1;
+    count++;
 
     return 0;
 }
 
+uint32_t
+LevFormulaDb::getCount(const types::FormulaId& formulaId) {
+    unique_ptr<leveldb::Iterator> it(
+            mDatabase->NewIterator(leveldb::ReadOptions()));
+    const string prefix = encodePrefix(formulaId);
+
+    // the last key of the formula precedes the first key of the next one
+    if (formulaId < UINT32_MAX) {
+        it->Seek(encodePrefix(formulaId + 1));
+    }
+    if (it->Valid()) {
+        it->Prev();
+    } else {
+        it->SeekToLast();
+    }
+    if (!it->Valid() || !it->key().starts_with(prefix) ||
+            it->key().size() != KEY_SIZE) {
+        return 0;
+    }
+
+    return getUint32(it->key().data() + PREFIX_SIZE) + 1;
+}
+
 int
 LevFormulaDb::queryFormula(const types::FormulaId &formulaId,
                            unsigned limitMin,
                            unsigned limitSize,
                            QueryCallback queryCallback) {
-    leveldb::Iterator* ret = mDatabase->NewIterator(leveldb::ReadOptions());
-    std::string fmId = std::to_string(formulaId) + "!";
-    ret->Seek(fmId);
-    for (unsigned i = 0; i < limitMin; i++) {
-        if (!ret->Valid()) return 0;
-        ret->Next();
-    }
-
-    if (!ret->Valid()) return 0;
-
-    std::string maxKey = fmId + "\xff";
-    for (unsigned i = 0;
-            i < limitSize && ret->Valid() && ret->key().ToString() < maxKey;
-            i++, ret->Next()) {
-        std::string retrieved = ret->value().ToString();
-
-        ParcelDecoder decoder(retrieved.data(), retrieved.size());
-
-        std::string crawlId_str;
-        decoder.decode(&crawlId_str);
-
-        CrawlId crawlId = strtoul(crawlId_str.data(), NULL, 0);
+    unique_ptr<leveldb::Iterator> it(
+            mDatabase->NewIterator(leveldb::ReadOptions()));
+    const string prefix = encodePrefix(formulaId);
+
+    it->Seek(encodeKey(formulaId, limitMin));
+    for (unsigned i = 0; i < limitSize &&
+         it->Valid() && it->key().starts_with(prefix); i++, it->Next()) {
+        CrawlId crawlId;
         types::FormulaPath formulaPath;
-        decoder.decode(&formulaPath);
+        if (decodeValue(it->value(), &crawlId, &formulaPath) != 0)
+            return -1;
 
         if (queryCallback(crawlId, formulaPath) != 0)
             return -1;
@@ -141,5 +263,42 @@ LevFormulaDb::queryFormula(const types::FormulaId &formulaId,
     return 0;
 }
 
+int
+LevFormulaDb::queryFormulae(const vector<FormulaQuery>& formulaQueries,
+                            BatchQueryCallback queryCallback) {
+    vector<size_t> order;
+
+    for (size_t i = 0; i < formulaQueries.size(); i++) {
+        order.push_back(i);
+    }
+    // big-endian keys sort like the ids: seeking them in order sweeps the
+    // table once
+    std::sort(order.begin(), order.end(),
+              [&formulaQueries](size_t a, size_t b) {
+        return formulaQueries[a].formulaId < formulaQueries[b].formulaId;
+    });
+
+    unique_ptr<leveldb::Iterator> it(
+            mDatabase->NewIterator(leveldb::ReadOptions()));
+    for (size_t i : order) {
+        const FormulaQuery& formulaQuery = formulaQueries[i];
+        const string prefix = encodePrefix(formulaQuery.formulaId);
+
+        it->Seek(encodeKey(formulaQuery.formulaId, formulaQuery.limitMin));
+        for (unsigned j = 0; j < formulaQuery.limitSize &&
+             it->Valid() && it->key().starts_with(prefix); j++, it->Next()) {
+            CrawlId crawlId;
+            types::FormulaPath formulaPath;
+            if (decodeValue(it->value(), &crawlId, &formulaPath) != 0)
+                return -1;
+
+            if (queryCallback(i, crawlId, formulaPath) != 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
 }  // namespace dbc
 }  // namespace mws
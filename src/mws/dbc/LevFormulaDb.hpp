@@ -28,9 +28,13 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   * @date 11 Dec 2013
   */
 
+#include <stdint.h>
 #include <stdlib.h>
 
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <leveldb/db.h>
 
 #include "mws/dbc/FormulaDb.hpp"
@@ -39,9 +43,19 @@ namespace mws { namespace dbc {
 
 class LevFormulaDb : public FormulaDb {
  public:
+    /// Key holding the version of the schema of the database
+    static const char SCHEMA_KEY[];
+    /// Version of the binary key schema
+    static const char SCHEMA_VERSION[];
+
     LevFormulaDb();
     virtual ~LevFormulaDb();
 
+    /**
+     * @brief open an existing database
+     * @throw runtime_error if the database cannot be opened or was written
+     * with another schema
+     */
     void open(const char* path) throw (std::runtime_error);
     void create_new(const char* path, bool deleteIfExists)
     throw (std::runtime_error);
@@ -50,14 +64,33 @@ class LevFormulaDb : public FormulaDb {
                               const CrawlId&     crawlId,
                               const types::FormulaPath& formulaPath);
 
+    /**
+     * @brief get the number of hits of a formula stored in the database
+     */
+    uint32_t getCount(const types::FormulaId& formulaId);
+
+    /**
+     * @brief query formula in database, seeking directly to its hit number
+     * limitMin
+     */
     virtual int queryFormula(const types::FormulaId& formulaId,
                              unsigned                limitMin,
                              unsigned                limitSize,
                              QueryCallback           queryCallback);
 
+    /**
+     * @brief query several formulae by seeking a single iterator through
+     * their keys in ascending order
+     */
+    virtual int queryFormulae(const std::vector<FormulaQuery>& formulaQueries,
+                              BatchQueryCallback queryCallback);
+
  private:
     leveldb::DB* mDatabase;
-    uint32_t mCounter;
+    /// Whether the database was created by this object, hence empty
+    bool mCreated;
+    /// Number of hits of the formulae inserted by this object
+    std::unordered_map<types::FormulaId, uint32_t> mCounts;
 };
 
 }  // namespace dbc
@@ -51,7 +51,7 @@ MemFormulaDb::queryFormula(const types::FormulaId &formulaId,
                            QueryCallback queryCallback) {
     auto ret = mData.find(formulaId);
     if (ret == mData.end()) return 0;
-    vector<FormulaInfo> formulaInfos = ret->second;
+    const vector<FormulaInfo>& formulaInfos = ret->second;
     if (limitMin >= formulaInfos.size()) return 0;
     auto it = formulaInfos.begin() + limitMin;
 
@@ -0,0 +1,156 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file MmapCrawlDb.cpp
+  * @brief Memory mapped read-only Crawl Database implementation
+  * @date 18 Oct 2026
+  */
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <stdexcept>
+using std::runtime_error;
+#include <string>
+using std::string;
+using std::to_string;
+#include <vector>
+using std::vector;
+
+#include "mws/dbc/MmapCrawlDb.hpp"
+
+namespace mws {
+namespace dbc {
+
+static const char MAGIC[8] = {'M', 'W', 'S', 'C', 'R', 'A', 'W', 'L'};
+static const uint32_t VERSION = 1;
+
+MmapCrawlDb::MmapCrawlDb() : mMapped(false), mData(NULL), mOffsets(NULL),
+    mNumIds(0), mFile(NULL) {
+}
+
+MmapCrawlDb::~MmapCrawlDb() {
+    if (mMapped) (void) mmap_unload(&mMmap);
+    if (mFile != NULL) (void) fclose(mFile);
+}
+
+void MmapCrawlDb::open(const char* path) throw (runtime_error) {
+    MmapCrawlDbFooter footer;
+
+    mPath = path;
+    if (mmap_load(mPath.c_str(), MAP_SHARED, &mMmap) != 0) {
+        throw runtime_error(mPath + ": cannot map file");
+    }
+    mMapped = true;
+
+    if (mMmap.size < sizeof(footer)) {
+        throw runtime_error(mPath + ": truncated crawl database");
+    }
+    const uint64_t footerPos = mMmap.size - sizeof(footer);
+    memcpy(&footer, mMmap.start_addr + footerPos, sizeof(footer));
+    if (memcmp(footer.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            footer.version != VERSION) {
+        throw runtime_error(mPath + ": not a crawl database");
+    }
+    if (footer.offsetsPos % sizeof(uint64_t) != 0 ||
+            footer.offsetsPos > footerPos ||
+            (footerPos - footer.offsetsPos) / sizeof(uint64_t) !=
+            (uint64_t) footer.numIds + 1) {
+        throw runtime_error(mPath + ": corrupted offset table");
+    }
+
+    mData = mMmap.start_addr;
+    mOffsets = (const uint64_t*) (mMmap.start_addr + footer.offsetsPos);
+    mNumIds = footer.numIds;
+    if (mOffsets[mNumIds] > footer.offsetsPos) {
+        throw runtime_error(mPath + ": corrupted offset table");
+    }
+}
+
+void MmapCrawlDb::create_new(const char* path, bool deleteIfExists)
+throw (runtime_error) {
+    mPath = path;
+    if (!deleteIfExists && access(path, F_OK) == 0) {
+        throw runtime_error(mPath + " already exists");
+    }
+    if ((mFile = fopen(path, "w")) == NULL) {
+        throw runtime_error(mPath + ": cannot create file");
+    }
+    // crawl ids start from 1, CRAWLID_NULL has no data
+    mWriteOffsets.assign(2, 0);
+}
+
+void MmapCrawlDb::save() throw (runtime_error) {
+    MmapCrawlDbFooter footer;
+    const char padding[sizeof(uint64_t)] = {0};
+
+    if (mFile == NULL) {
+        throw runtime_error(mPath + " is not open for writing");
+    }
+
+    const uint64_t dataSize = mWriteOffsets.back();
+    const size_t paddingSize = (sizeof(uint64_t) - dataSize % sizeof(uint64_t))
+            % sizeof(uint64_t);
+    footer.offsetsPos = dataSize + paddingSize;
+    footer.numIds = mWriteOffsets.size() - 1;
+    footer.version = VERSION;
+    memcpy(footer.magic, MAGIC, sizeof(MAGIC));
+
+    bool failed = fwrite(padding, 1, paddingSize, mFile) != paddingSize;
+    failed |= fwrite(mWriteOffsets.data(), sizeof(uint64_t),
+                     mWriteOffsets.size(), mFile) != mWriteOffsets.size();
+    failed |= fwrite(&footer, sizeof(footer), 1, mFile) != 1;
+    failed |= fclose(mFile) != 0;
+    mFile = NULL;
+    vector<uint64_t>().swap(mWriteOffsets);
+    if (failed) {
+        throw runtime_error(mPath + ": write failed");
+    }
+}
+
+CrawlId MmapCrawlDb::putData(const CrawlData& crawlData)
+throw (std::exception) {
+    if (mFile == NULL) {
+        throw runtime_error(mPath + " is not open for writing");
+    }
+    if (fwrite(crawlData.data(), 1, crawlData.size(), mFile) !=
+            crawlData.size()) {
+        throw runtime_error(mPath + ": write failed");
+    }
+    mWriteOffsets.push_back(mWriteOffsets.back() + crawlData.size());
+
+    return mWriteOffsets.size() - 2;
+}
+
+const CrawlData MmapCrawlDb::getData(const CrawlId& crawlId)
+throw (std::exception) {
+    if (crawlId == CRAWLID_NULL || crawlId >= mNumIds) {
+        throw runtime_error("No data corresponding to crawlId = " +
+                            to_string(crawlId));
+    }
+
+    return CrawlData(mData + mOffsets[crawlId],
+                     mOffsets[crawlId + 1] - mOffsets[crawlId]);
+}
+
+}  // namespace dbc
+}  // namespace mws
@@ -0,0 +1,118 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_DBC_MMAPCRAWLDB_HPP
+#define _MWS_DBC_MMAPCRAWLDB_HPP
+
+/**
+  * @file MmapCrawlDb.hpp
+  * @brief Memory mapped read-only Crawl Database API
+  * @date 18 Oct 2026
+  *
+  * The database is a flat file written once by mws-index:
+  *
+  *     data            crawl data of ids 1..n, one after another
+  *     padding         to 8 bytes
+  *     offsets         uint64_t[n + 2], the data of id i lies between
+  *                     offsets[i] and offsets[i + 1]
+  *     footer          MmapCrawlDbFooter
+  *
+  * Integers are stored in host byte order.
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common/utils/mmap.h"
+#include "mws/dbc/CrawlDb.hpp"
+
+namespace mws {
+namespace dbc {
+
+struct MmapCrawlDbFooter {
+    uint64_t offsetsPos;
+    uint32_t numIds;            ///< number of entries of offsets minus one
+    uint32_t version;
+    char     magic[8];
+};
+
+class MmapCrawlDb : public CrawlDb {
+ public:
+    MmapCrawlDb();
+    virtual ~MmapCrawlDb();
+
+    /**
+     * @brief map a database written by save() for reading
+     * @throw runtime_error if the file cannot be mapped or is malformed
+     */
+    void open(const char* path) throw (std::runtime_error);
+
+    /**
+     * @brief create a database to be filled by putData() and written by
+     * save()
+     */
+    void create_new(const char* path, bool deleteIfExists)
+    throw (std::runtime_error);
+
+    /**
+     * @brief write the offset table of a database opened by create_new()
+     */
+    void save() throw (std::runtime_error);
+
+    /**
+     * @brief insert crawled data, before save()
+     * @param crawlData data associated with the crawl element
+     * @return id of the crawl element
+     */
+    virtual CrawlId putData(const CrawlData& crawlData)
+    throw (std::exception);
+
+    /**
+     * @brief get crawled data of a database opened by open()
+     * @param crawlId id of the crawl element
+     * @return CrawlData corresponding to crawlId
+     * @throw NotFound exceptions
+     */
+    virtual const CrawlData getData(const CrawlId& crawlId)
+    throw (std::exception);
+
+ private:
+    std::string mPath;
+
+    // reading
+    mmap_handle_t mMmap;
+    bool mMapped;
+    const char* mData;
+    const uint64_t* mOffsets;
+    uint32_t mNumIds;
+
+    // writing
+    FILE* mFile;
+    std::vector<uint64_t> mWriteOffsets;
+};
+
+}  // namespace dbc
+}  // namespace mws
+
+#endif  // _MWS_DBC_MMAPCRAWLDB_HPP
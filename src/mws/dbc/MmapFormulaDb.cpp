@@ -0,0 +1,240 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file MmapFormulaDb.cpp
+  * @brief Memory mapped read-only Formula Database implementation
+  * @date 18 Oct 2026
+  */
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <stdexcept>
+using std::runtime_error;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "mws/dbc/MmapFormulaDb.hpp"
+
+namespace mws { namespace dbc {
+
+static const char MAGIC[8] = {'M', 'W', 'S', 'F', 'O', 'R', 'M', 'L'};
+static const uint32_t VERSION = 1;
+
+/// crawlId, xmlId size and xpath size
+static const size_t RECORD_HEADER_SIZE = 3 * sizeof(uint32_t);
+
+static inline void readRecordHeader(const char* record, uint32_t header[3]) {
+    memcpy(header, record, RECORD_HEADER_SIZE);
+}
+
+MmapFormulaDb::MmapFormulaDb() : mMapped(false), mHits(NULL),
+    mHitOffsets(NULL), mFirstHits(NULL), mNumIds(0), mTmpFile(NULL),
+    mTmpSize(0) {
+}
+
+MmapFormulaDb::~MmapFormulaDb() {
+    if (mMapped) (void) mmap_unload(&mMmap);
+    if (mTmpFile != NULL) {
+        (void) fclose(mTmpFile);
+        (void) unlink(mTmpPath.c_str());
+    }
+}
+
+void MmapFormulaDb::open(const char* path) throw (runtime_error) {
+    MmapFormulaDbFooter footer;
+
+    mPath = path;
+    if (mmap_load(mPath.c_str(), MAP_SHARED, &mMmap) != 0) {
+        throw runtime_error(mPath + ": cannot map file");
+    }
+    mMapped = true;
+
+    if (mMmap.size < sizeof(footer)) {
+        throw runtime_error(mPath + ": truncated formula database");
+    }
+    const uint64_t footerPos = mMmap.size - sizeof(footer);
+    memcpy(&footer, mMmap.start_addr + footerPos, sizeof(footer));
+    if (memcmp(footer.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            footer.version != VERSION) {
+        throw runtime_error(mPath + ": not a formula database");
+    }
+    if (footer.hitOffsetsPos % sizeof(uint64_t) != 0 ||
+            footer.hitOffsetsPos > footer.firstHitsPos ||
+            footer.firstHitsPos > footerPos ||
+            (footer.firstHitsPos - footer.hitOffsetsPos) / sizeof(uint64_t) !=
+            footer.numHits + 1 ||
+            (footerPos - footer.firstHitsPos) / sizeof(uint64_t) !=
+            (uint64_t) footer.numIds + 1) {
+        throw runtime_error(mPath + ": corrupted offset tables");
+    }
+
+    mHits = mMmap.start_addr;
+    mHitOffsets = (const uint64_t*) (mMmap.start_addr + footer.hitOffsetsPos);
+    mFirstHits = (const uint64_t*) (mMmap.start_addr + footer.firstHitsPos);
+    mNumIds = footer.numIds;
+    if (mHitOffsets[footer.numHits] > footer.hitOffsetsPos ||
+            mFirstHits[mNumIds] != footer.numHits) {
+        throw runtime_error(mPath + ": corrupted offset tables");
+    }
+}
+
+void MmapFormulaDb::create_new(const char* path, bool deleteIfExists)
+throw (runtime_error) {
+    mPath = path;
+    mTmpPath = mPath + ".tmp";
+    if (!deleteIfExists && access(path, F_OK) == 0) {
+        throw runtime_error(mPath + " already exists");
+    }
+    if ((mTmpFile = fopen(mTmpPath.c_str(), "w")) == NULL) {
+        throw runtime_error(mTmpPath + ": cannot create file");
+    }
+}
+
+void MmapFormulaDb::save() throw (runtime_error) {
+    MmapFormulaDbFooter footer;
+    const char padding[sizeof(uint64_t)] = {0};
+    mmap_handle_t tmpMmap = mmap_handle_t();
+    vector<uint64_t> hitOffsets;
+    vector<uint64_t> firstHits;
+    uint64_t pos = 0;
+    FILE* file;
+    bool failed;
+
+    if (mTmpFile == NULL) {
+        throw runtime_error(mPath + " is not open for writing");
+    }
+    failed = fclose(mTmpFile) != 0;
+    mTmpFile = NULL;
+    if (failed || (file = fopen(mPath.c_str(), "w")) == NULL) {
+        (void) unlink(mTmpPath.c_str());
+        throw runtime_error(mPath + ": cannot create file");
+    }
+    if (mTmpSize > 0 &&
+            mmap_load(mTmpPath.c_str(), MAP_SHARED, &tmpMmap) != 0) {
+        (void) fclose(file);
+        (void) unlink(mTmpPath.c_str());
+        throw runtime_error(mTmpPath + ": cannot map file");
+    }
+
+    for (const vector<uint64_t>& tmpHits : mTmpHits) {
+        firstHits.push_back(hitOffsets.size());
+        for (uint64_t tmpOffset : tmpHits) {
+            const char* record = tmpMmap.start_addr + tmpOffset;
+            uint32_t header[3];
+            readRecordHeader(record, header);
+            const size_t size = RECORD_HEADER_SIZE + header[1] + header[2];
+            failed |= fwrite(record, 1, size, file) != size;
+            hitOffsets.push_back(pos);
+            pos += size;
+        }
+    }
+    firstHits.push_back(hitOffsets.size());
+    footer.numHits = hitOffsets.size();
+    hitOffsets.push_back(pos);
+
+    const size_t paddingSize = (sizeof(uint64_t) - pos % sizeof(uint64_t))
+            % sizeof(uint64_t);
+    footer.hitOffsetsPos = pos + paddingSize;
+    footer.firstHitsPos = footer.hitOffsetsPos +
+            hitOffsets.size() * sizeof(uint64_t);
+    footer.numIds = firstHits.size() - 1;
+    footer.version = VERSION;
+    memcpy(footer.magic, MAGIC, sizeof(MAGIC));
+
+    failed |= fwrite(padding, 1, paddingSize, file) != paddingSize;
+    failed |= fwrite(hitOffsets.data(), sizeof(uint64_t), hitOffsets.size(),
+                     file) != hitOffsets.size();
+    failed |= fwrite(firstHits.data(), sizeof(uint64_t), firstHits.size(),
+                     file) != firstHits.size();
+    failed |= fwrite(&footer, sizeof(footer), 1, file) != 1;
+    failed |= fclose(file) != 0;
+
+    if (mTmpSize > 0) (void) mmap_unload(&tmpMmap);
+    (void) unlink(mTmpPath.c_str());
+    vector<vector<uint64_t> >().swap(mTmpHits);
+    mTmpSize = 0;
+    if (failed) {
+        throw runtime_error(mPath + ": write failed");
+    }
+}
+
+int
+MmapFormulaDb::insertFormula(const types::FormulaId&   formulaId,
+                             const CrawlId&     crawlId,
+                             const types::FormulaPath& formulaPath) {
+    const uint32_t header[3] = {
+        crawlId,
+        (uint32_t) formulaPath.xmlId.size(),
+        (uint32_t) formulaPath.xpath.size()
+    };
+
+    if (mTmpFile == NULL) return -1;
+    if (fwrite(header, 1, RECORD_HEADER_SIZE, mTmpFile) !=
+            RECORD_HEADER_SIZE ||
+            fwrite(formulaPath.xmlId.data(), 1, header[1], mTmpFile) !=
+            header[1] ||
+            fwrite(formulaPath.xpath.data(), 1, header[2], mTmpFile) !=
+            header[2]) {
+        return -1;
+    }
+
+    if (formulaId >= mTmpHits.size()) mTmpHits.resize(formulaId + 1);
+    mTmpHits[formulaId].push_back(mTmpSize);
+    mTmpSize += RECORD_HEADER_SIZE + header[1] + header[2];
+
+    return 0;
+}
+
+int
+MmapFormulaDb::queryFormula(const types::FormulaId &formulaId,
+                            unsigned limitMin,
+                            unsigned limitSize,
+                            QueryCallback queryCallback) {
+    if (formulaId >= mNumIds) return 0;
+
+    const uint64_t first = mFirstHits[formulaId];
+    const uint64_t count = mFirstHits[formulaId + 1] - first;
+    if (limitMin >= count) return 0;
+    const uint64_t end = first + std::min((uint64_t) limitMin + limitSize,
+                                          count);
+
+    types::FormulaPath formulaPath;
+    for (uint64_t i = first + limitMin; i < end; i++) {
+        const char* record = mHits + mHitOffsets[i];
+        uint32_t header[3];
+        readRecordHeader(record, header);
+        record += RECORD_HEADER_SIZE;
+        formulaPath.xmlId.assign(record, header[1]);
+        formulaPath.xpath.assign(record + header[1], header[2]);
+
+        if (queryCallback(header[0], formulaPath) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+} }
@@ -0,0 +1,131 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_DBC_MMAPFORMULADB_HPP
+#define _MWS_DBC_MMAPFORMULADB_HPP
+
+/**
+  * @file MmapFormulaDb.hpp
+  * @brief Memory mapped read-only Formula Database API
+  * @date 18 Oct 2026
+  *
+  * The database is a flat file written once by mws-index:
+  *
+  *     hits            hit records grouped by formula id, in insertion
+  *                     order within a formula
+  *     padding         to 8 bytes
+  *     hitOffsets      uint64_t[numHits + 1], offset of each hit record
+  *     firstHits       uint64_t[numIds + 1], the hits of formula f are
+  *                     hitOffsets[firstHits[f]] .. hitOffsets[firstHits[f+1]]
+  *     footer          MmapFormulaDbFooter
+  *
+  * A hit record is
+  *
+  *     crawlId (uint32_t) xmlId size (uint32_t) xpath size (uint32_t)
+  *     xmlId xpath
+  *
+  * Integers are stored in host byte order. The Nth hit of a formula is
+  * found in constant time.
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common/utils/mmap.h"
+#include "mws/dbc/FormulaDb.hpp"
+
+namespace mws { namespace dbc {
+
+struct MmapFormulaDbFooter {
+    uint64_t numHits;
+    uint64_t hitOffsetsPos;
+    uint64_t firstHitsPos;
+    uint32_t numIds;            ///< largest formula id plus one
+    uint32_t version;
+    char     magic[8];
+};
+
+class MmapFormulaDb : public FormulaDb {
+ public:
+    MmapFormulaDb();
+    virtual ~MmapFormulaDb();
+
+    /**
+     * @brief map a database written by save() for reading
+     * @throw runtime_error if the file cannot be mapped or is malformed
+     */
+    void open(const char* path) throw (std::runtime_error);
+
+    /**
+     * @brief create a database to be filled by insertFormula() and written
+     * by save(). Hits are buffered in a temporary file next to path.
+     */
+    void create_new(const char* path, bool deleteIfExists)
+    throw (std::runtime_error);
+
+    /**
+     * @brief group the hits inserted so far by formula and write them with
+     * their offset tables
+     */
+    void save() throw (std::runtime_error);
+
+    /**
+     * @brief insert formula in database, before save()
+     * @return 0 on success and -1 on failure.
+     */
+    virtual int insertFormula(const types::FormulaId&   formulaId,
+                              const CrawlId&     crawlId,
+                              const types::FormulaPath& formulaPath);
+
+    /**
+     * @brief query formula in a database opened by open()
+     * @return 0 on success and -1 on failure.
+     */
+    virtual int queryFormula(const types::FormulaId& formulaId,
+                             unsigned                limitMin,
+                             unsigned                limitSize,
+                             QueryCallback           queryCallback);
+
+ private:
+    std::string mPath;
+
+    // reading
+    mmap_handle_t mMmap;
+    bool mMapped;
+    const char* mHits;
+    const uint64_t* mHitOffsets;
+    const uint64_t* mFirstHits;
+    uint32_t mNumIds;
+
+    // writing
+    std::string mTmpPath;
+    FILE* mTmpFile;
+    uint64_t mTmpSize;
+    /// offsets in the temporary file of the hits of each formula
+    std::vector<std::vector<uint64_t> > mTmpHits;
+};
+
+} }
+
+#endif  // _MWS_DBC_MMAPFORMULADB_HPP
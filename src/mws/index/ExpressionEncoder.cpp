@@ -164,7 +164,11 @@ HarvestEncoder::_getConstantEncoding(const Meaning& meaning) {
 }
 
 QueryEncoder::QueryEncoder(MeaningDictionary *dictionary) :
-    ExpressionEncoder(dictionary) {
+    ExpressionEncoder(dictionary), _mmapMeaningDictionary(NULL) {
+}
+
+QueryEncoder::QueryEncoder(const MmapMeaningDictionary* dictionary) :
+    ExpressionEncoder(NULL), _mmapMeaningDictionary(dictionary) {
 }
 
 QueryEncoder::~QueryEncoder() {}
@@ -181,7 +185,9 @@ QueryEncoder::_getNamedVarOffset() const {
 
 MeaningId
 QueryEncoder::_getConstantEncoding(const Meaning& meaning) {
-    MeaningId id = _meaningDictionary->get(meaning);
+    MeaningId id = (_mmapMeaningDictionary != NULL) ?
+            _mmapMeaningDictionary->get(meaning) :
+            _meaningDictionary->get(meaning);
 
     if (id != MeaningDictionary::KEY_NOT_FOUND) {
         return CONSTANT_ID_MIN + id;
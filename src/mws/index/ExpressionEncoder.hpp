@@ -39,6 +39,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include "mws/index/encoded_token.h"
 #include "mws/index/IndexManager.hpp"
 #include "mws/index/MeaningDictionary.hpp"
+#include "mws/index/MmapMeaningDictionary.hpp"
 #include "mws/types/CmmlToken.hpp"
 
 /****************************************************************************/
@@ -86,11 +87,15 @@ class HarvestEncoder : public ExpressionEncoder {
 class QueryEncoder : public ExpressionEncoder {
  public:
     explicit QueryEncoder(MeaningDictionary* dictionary);
+    /// look up constants in a memory mapped dictionary instead
+    explicit QueryEncoder(const MmapMeaningDictionary* dictionary);
     virtual ~QueryEncoder();
  protected:
     virtual MeaningId _getAnonVarOffset() const;
     virtual MeaningId _getNamedVarOffset() const;
     virtual MeaningId _getConstantEncoding(const types::Meaning& meaning);
+
+    const MmapMeaningDictionary* _mmapMeaningDictionary;
 };
 
 }  // namespace index
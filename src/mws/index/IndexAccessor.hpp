@@ -40,9 +40,10 @@ public:
     class Iterator {
         inode_t* _node;
         int _index;
+        index_format_t _format;
 
-        Iterator(inode_t* node, int index)
-            : _node(node), _index(index) {
+        Iterator(inode_t* node, int index, index_format_t format)
+            : _node(node), _index(index), _format(format) {
         }
     public:
         Iterator& operator++(int) {
@@ -58,6 +59,7 @@ public:
             if (this == &rhs) return *this;
             _node = rhs._node;
             _index = rhs._index;
+            _format = rhs._format;
             return *this;
         }
 
@@ -68,19 +70,19 @@ public:
         return index->root;
     }
 
-    static Iterator getChildrenBegin(Node* node) {
+    static Iterator getChildrenBegin(Index* index, Node* node) {
         assert(node->type == INTERNAL_NODE);
-        return Iterator(node, 0);
+        return Iterator(node, 0, index->format);
     }
 
-    static Iterator getChildrenEnd(Node* node) {
+    static Iterator getChildrenEnd(Index* index, Node* node) {
         assert(node->type == INTERNAL_NODE);
-        return Iterator(node, node->size);
+        return Iterator(node, node->size, index->format);
     }
 
     static encoded_token_t getToken(const Iterator& it) {
         assert(it._node->type == INTERNAL_NODE);
-        return it._node->data[it._index].token;
+        return inode_get_token(it._node, it._format, it._index);
     }
 
     static Arity getArity(const Iterator& it) {
@@ -89,18 +91,18 @@ public:
 
     static Node* getNode(Index* index, const Iterator& it) {
         assert(it._node->type == INTERNAL_NODE);
-        memsector_off_t off = it._node->data[it._index].off;
+        memsector_off_t off = inode_get_off(index, it._node, it._index);
         assert(off != MEMSECTOR_OFF_NULL);
-        return (Node*) memsector_off2addr(index->alloc, off);
+        return (Node*) memsector_off2addr(index->alloc, index->off_shift, off);
     }
 
     static Node* getChild(Index* index, Node* node, encoded_token_t token) {
         assert(node->type == INTERNAL_NODE);
-        memsector_off_t off = inode_get_child(node, token);
+        memsector_off_t off = inode_get_child(index, node, token);
         if (off == MEMSECTOR_OFF_NULL) {
             return NULL;
         }
-        return (Node*) memsector_off2addr(index->alloc, off);
+        return (Node*) memsector_off2addr(index->alloc, index->off_shift, off);
     }
 
     static uint64_t getFormulaId(Node* node) {
@@ -114,6 +116,20 @@ public:
         assert(leaf->type == LEAF_NODE);
         return leaf->num_hits;
     }
+
+    static bool hasSubtreeCounts(Index* index) {
+        return index->subtree_counts;
+    }
+
+    /**
+     * @return hits of the leaves below a node, if hasSubtreeCounts()
+     */
+    static uint64_t getSubtreeHitsCount(Node* node) {
+        if (node->type == LEAF_NODE) {
+            return getHitsCount(node);
+        }
+        return inode_get_counts(node)->num_hits;
+    }
 };
 
 }  // namespace index
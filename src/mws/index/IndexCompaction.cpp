@@ -0,0 +1,312 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file IndexCompaction.cpp
+  * @brief Compaction of the segments of an index into a single one
+  * @date 18 Oct 2026
+  */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+using std::exception;
+#include <string>
+using std::string;
+#include <utility>
+using std::pair;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "common/utils/util.hpp"
+using common::utils::getFileContents;
+#include "mws/dbc/LevCrawlDb.hpp"
+#include "mws/dbc/LevFormulaDb.hpp"
+#include "mws/dbc/MmapCrawlDb.hpp"
+#include "mws/dbc/MmapFormulaDb.hpp"
+#include "mws/index/IndexMerger.hpp"
+#include "mws/index/IndexSegments.hpp"
+#include "mws/index/MeaningDictionary.hpp"
+#include "mws/index/MmapMeaningDictionary.hpp"
+#include "mws/index/memsector.h"
+#include "mws/index/IndexCompaction.hpp"
+
+#ifndef RENAME_EXCHANGE
+#define RENAME_EXCHANGE (1 << 1)
+#endif
+
+namespace mws { namespace index {
+
+namespace {
+
+struct Segment {
+    memsector_handle_t memsector;
+    bool loaded;
+    std::shared_ptr<SegmentDatabases> databases;
+
+    Segment() : loaded(false) {}
+    ~Segment() {
+        if (loaded) memsector_unload(&memsector);
+    }
+};
+
+}  // namespace
+
+static int loadSegment(const string& path, const SegmentDatabasesList& opened,
+                       Segment* segment) {
+    // LevelDB databases opened by the caller cannot be opened again
+    segment->databases = openSegmentDatabases(path, opened);
+    if (segment->databases == NULL) {
+        return -1;
+    }
+    if (memsector_load(&segment->memsector,
+                       (path + "/memsector.dat").c_str()) != 0) {
+        PRINT_WARN("%s: cannot load memsector\n", path.c_str());
+        return -1;
+    }
+    segment->loaded = true;
+
+    return 0;
+}
+
+/// Swap two directories atomically, if the system supports it
+static int exchangeDirectories(const string& path1, const string& path2) {
+#ifdef SYS_renameat2
+    return syscall(SYS_renameat2, AT_FDCWD, path1.c_str(),
+                   AT_FDCWD, path2.c_str(), RENAME_EXCHANGE);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/**
+ * @brief merge the segments of indexPath into compactPath
+ * @return 0 on success, -1 on failure
+ */
+static int mergeSegments(const string& indexPath,
+                         const vector<int>& deltas,
+                         const string& compactPath,
+                         const CompactionOptions& options) {
+    vector<Segment> segments(deltas.size() + 1);
+    MeaningDictionary meaningDictionary;
+    MeaningDictionary mergedMeaningDictionary;
+    std::filebuf fb;
+    std::istream is(&fb);
+    dbc::CrawlDb* crawlDb = NULL;
+    dbc::FormulaDb* formulaDb = NULL;
+    dbc::MmapCrawlDb* crawlMmapDb = NULL;
+    dbc::MmapFormulaDb* formulaMmapDb = NULL;
+    const string memsectorPath = compactPath + "/memsector.dat";
+    memsector_writer_t mswr;
+    index_format_t format;
+    uint32_t flags;
+    uint32_t offShift;
+    int ret = -1;
+
+    if (fb.open((indexPath + "/meaning.dat").c_str(), std::ios::in) == NULL ||
+            meaningDictionary.load(is) != 0) {
+        PRINT_WARN("%s: cannot load meaning dictionary\n", indexPath.c_str());
+        return -1;
+    }
+    fb.close();
+
+    for (size_t i = 0; i < segments.size(); i++) {
+        string path = (i == 0) ? indexPath :
+                getDeltaSegmentPath(indexPath, deltas[i - 1]);
+        if (loadSegment(path, options.databases, &segments[i]) != 0) {
+            return -1;
+        }
+    }
+
+    try {
+        // the databases are kept in the format of the base segment
+        if (!segments[0].databases->isLevelDb) {
+            crawlDb = crawlMmapDb = new dbc::MmapCrawlDb();
+            crawlMmapDb->create_new((compactPath + "/crawl.dat").c_str(),
+                                    /* deleteIfExists = */ true);
+            formulaDb = formulaMmapDb = new dbc::MmapFormulaDb();
+            formulaMmapDb->create_new((compactPath + "/formula.dat").c_str(),
+                                      /* deleteIfExists = */ true);
+        } else {
+            dbc::LevCrawlDb* crawlLevDb = new dbc::LevCrawlDb();
+            crawlDb = crawlLevDb;
+            crawlLevDb->create_new((compactPath + "/crawl.db").c_str(),
+                                   /* deleteIfExists = */ true);
+            dbc::LevFormulaDb* formulaLevDb = new dbc::LevFormulaDb();
+            formulaDb = formulaLevDb;
+            formulaLevDb->create_new((compactPath + "/formula.db").c_str(),
+                                     /* deleteIfExists = */ true);
+        }
+
+        // all segments share the meaning ids of meaningDictionary
+        IndexMerger merger(formulaDb, crawlDb, &mergedMeaningDictionary);
+        merger.setMaxWriteRate(options.maxWriteRate);
+        merger.setCancelCallback(options.isCancelled);
+        for (Segment& segment : segments) {
+            merger.addShard({&segment.memsector.index, &meaningDictionary,
+                             segment.databases->formulaDb,
+                             segment.databases->crawlDb});
+        }
+
+        // the compacted index keeps the layout of the base segment
+        format = segments[0].memsector.index.format;
+        flags = segments[0].memsector.index.subtree_counts ?
+                MEMSECTOR_FLAG_SUBTREE_COUNTS : 0;
+        offShift = 0;
+        while (merger.getMemsectorSize(format, offShift, flags != 0) >
+               MEMSECTOR_MAX_SIZE(offShift)) {
+            if (++offShift > MEMSECTOR_MAX_OFF_SHIFT) {
+                PRINT_WARN("Compacted index too large to export\n");
+                goto fail;
+            }
+        }
+        FAIL_ON(memsector_create_flags(&mswr, memsectorPath.c_str(),
+                                       MEMSECTOR_INITIAL_SIZE, format,
+                                       offShift, flags) != 0);
+        ret = merger.exportToMemsector(&mswr);
+        if (memsector_save(&mswr) != 0) {
+            ret = -1;
+        }
+        if (ret == 0 && crawlMmapDb != NULL) {
+            crawlMmapDb->save();
+            formulaMmapDb->save();
+        }
+    } catch (exception& e) {
+        PRINT_WARN("%s\n", e.what());
+        ret = -1;
+    }
+
+fail:
+    delete crawlDb;
+    delete formulaDb;
+    return ret;
+}
+
+int compactIndex(const string& indexPath, const CompactionOptions& options) {
+    const string compactPath = getIndexSiblingPath(indexPath, ".compact");
+    const string oldPath = getIndexSiblingPath(indexPath, ".old");
+    const string compactLockPath =
+            getIndexSiblingPath(indexPath, ".compact.lock");
+    vector<int> deltas;
+    vector<pair<string, string> > carriedOver;
+    int compactLock;
+    int lock = -1;
+
+    // one compaction at a time
+    compactLock = open(compactLockPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (compactLock < 0 || flock(compactLock, LOCK_EX | LOCK_NB) != 0) {
+        PRINT_WARN("Cannot lock %s\n", compactLockPath.c_str());
+        if (compactLock >= 0) close(compactLock);
+        return -1;
+    }
+
+    deltas = getDeltaSegments(indexPath);
+    if (deltas.empty()) {
+        close(compactLock);
+        return 0;
+    }
+
+    // left by an interrupted compaction, or by the previous one
+    FAIL_ON(removeDirectory(compactPath) != 0);
+    FAIL_ON(removeDirectory(oldPath) != 0);
+    FAIL_ON(mkdir(compactPath.c_str(), 0755) != 0);
+    FAIL_ON(mergeSegments(indexPath, deltas, compactPath, options) != 0);
+
+    // no delta is appended while the index directory is swapped
+    FAIL_ON((lock = lockIndex(indexPath)) < 0);
+    if (options.beforeSwap) options.beforeSwap();
+    for (int n : getDeltaSegments(indexPath)) {
+        if (n > deltas.back()) {
+            carriedOver.push_back(std::make_pair(
+                    getDeltaSegmentPath(indexPath, n),
+                    getDeltaSegmentPath(compactPath,
+                                        carriedOver.size() + 1)));
+        }
+    }
+    try {
+        // holds the meanings of the carried over deltas
+        const string meanings = getFileContents(indexPath + "/meaning.dat");
+        std::ofstream out((compactPath + "/meaning.dat").c_str(),
+                          std::ios::out | std::ios::binary);
+        out.write(meanings.data(), meanings.size());
+        out.close();
+        FAIL_ON(!out);
+        // written after meaning.dat, from the same meanings
+        std::istringstream in(meanings);
+        MeaningDictionary carriedOverMeanings;
+        FAIL_ON(carriedOverMeanings.load(in) != 0);
+        MmapMeaningDictionary::save(carriedOverMeanings,
+                                    (compactPath + "/meaning.idx").c_str());
+    } catch (exception& e) {
+        PRINT_WARN("%s\n", e.what());
+        goto fail;
+    }
+    for (size_t i = 0; i < carriedOver.size(); i++) {
+        if (rename(carriedOver[i].first.c_str(),
+                   carriedOver[i].second.c_str()) != 0) {
+            carriedOver.resize(i);
+            goto fail;
+        }
+    }
+
+    // the index directory is never missing, where the system allows it
+    if (exchangeDirectories(indexPath, compactPath) == 0) {
+        if (rename(compactPath.c_str(), oldPath.c_str()) != 0) {
+            PRINT_WARN("Cannot move the previous index to %s\n",
+                       oldPath.c_str());
+        }
+    } else {
+        FAIL_ON(errno != ENOSYS && errno != EINVAL);
+        FAIL_ON(rename(indexPath.c_str(), oldPath.c_str()) != 0);
+        if (rename(compactPath.c_str(), indexPath.c_str()) != 0) {
+            rename(oldPath.c_str(), indexPath.c_str());
+            goto fail;
+        }
+    }
+    unlockIndex(lock);
+    close(compactLock);
+
+    return deltas.size() + 1;
+
+fail:
+    PRINT_WARN("Compacting %s failed\n", indexPath.c_str());
+    // the index keeps the deltas it had
+    for (const pair<string, string>& paths : carriedOver) {
+        rename(paths.second.c_str(), paths.first.c_str());
+    }
+    if (lock >= 0) unlockIndex(lock);
+    removeDirectory(compactPath);
+    close(compactLock);
+    return -1;
+}
+
+}  // namespace index
+}  // namespace mws
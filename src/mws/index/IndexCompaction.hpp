@@ -0,0 +1,76 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_INDEX_INDEXCOMPACTION_HPP
+#define _MWS_INDEX_INDEXCOMPACTION_HPP
+
+/**
+  * @file IndexCompaction.hpp
+  * @brief Compaction of the segments of an index into a single one
+  * @date 18 Oct 2026
+  */
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+
+#include "mws/index/SegmentDatabases.hpp"
+
+namespace mws { namespace index {
+
+struct CompactionOptions {
+    /// Bytes written per second, 0 for no limit
+    uint64_t maxWriteRate;
+    /// Polled while merging, compaction is abandoned once it returns true
+    std::function<bool()> isCancelled;
+    /// Databases of the index opened by the caller, shared by the compaction
+    SegmentDatabasesList databases;
+    /**
+     * Called once the segments are merged, before any of them is moved.
+     * The caller closes its LevelDB databases of the index there, which
+     * would read the files of the compacted index once it is swapped in.
+     */
+    std::function<void()> beforeSwap;
+
+    CompactionOptions() : maxWriteRate(0) {}
+};
+
+/**
+ * @brief merge the base and delta segments of an index directory into a
+ * single segment, with IndexMerger. The compacted index is written to
+ * <index>.compact and swapped with the index directory, atomically where
+ * the system allows it. Delta segments appended meanwhile are carried
+ * over. The previous index is kept in <index>.old until the next
+ * compaction, for processes still reading it. LevelDB databases can only
+ * be opened by one process, so an index with LevelDB databases served by
+ * mwsd-load is compacted by mwsd-load itself.
+ * @param indexPath index directory
+ * @param options limits of the compaction
+ * @return number of segments merged, 0 if the index has no delta segment,
+ * or -1 on failure, in which case the index is left unchanged
+ */
+int compactIndex(const std::string& indexPath,
+                 const CompactionOptions& options);
+
+}  // namespace index
+}  // namespace mws
+
+#endif  // _MWS_INDEX_INDEXCOMPACTION_HPP
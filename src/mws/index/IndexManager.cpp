@@ -67,13 +67,54 @@ int
 IndexManager::indexContentMath(const types::CmmlToken* cmmlToken,
                                const std::string xmlId,
                                const CrawlId& crawlId) {
+    vector<EncodedFormula> formulae;
+
+    encodeContentMath(m_indexingOptions, m_meaningDictionary, cmmlToken,
+                      &formulae);
+
+    return indexEncodedFormulae(formulae, xmlId, crawlId);
+}
+
+int
+IndexManager::indexEncodedHarvest(const EncodedHarvest& harvest) {
+    int numSubExpressions = 0;
+
+    // Translate local meaning ids to ids of the index dictionary
+    const vector<MeaningId> meaningIds =
+            mergeMeaningDictionary(harvest.meaningDictionary,
+                                   m_meaningDictionary);
+
+    // Translate local crawl ids
+    vector<CrawlId> crawlIds(harvest.crawlData.size() + 1, dbc::CRAWLID_NULL);
+    for (size_t i = 0; i < harvest.crawlData.size(); i++) {
+        crawlIds[i + 1] = indexCrawlData(harvest.crawlData[i]);
+    }
+
+    for (const EncodedHarvest::Expression& expression : harvest.expressions) {
+        vector<EncodedFormula> formulae = expression.formulae;
+        for (EncodedFormula& formula : formulae) {
+            for (encoded_token_t& token : formula.tokens) {
+                token = translateEncodedToken(token, meaningIds);
+            }
+        }
+        assert(expression.crawlId < crawlIds.size());
+        numSubExpressions += indexEncodedFormulae(formulae, expression.xmlId,
+                                                  crawlIds[expression.crawlId]);
+    }
+
+    return numSubExpressions;
+}
+
+void
+IndexManager::encodeContentMath(const IndexingOptions& indexingOptions,
+                                MeaningDictionary* meaningDictionary,
+                                const types::CmmlToken* cmmlToken,
+                                vector<EncodedFormula>* formulae) {
     assert(cmmlToken != NULL);
-    // Using a stack to insert all subterms by
+    // Using a stack to encode all subterms by
     // going depth first through the CmmlToken
-    set<FormulaId> uniqueFormulaIds;
     stack<const CmmlToken*> subtermStack;
-    int numSubExpressions = 0;
-    HarvestEncoder encoder(m_meaningDictionary);
+    HarvestEncoder encoder(meaningDictionary);
 
     subtermStack.push(cmmlToken);
     while (!subtermStack.empty()) {
@@ -86,16 +127,28 @@ IndexManager::indexContentMath(const types::CmmlToken* cmmlToken,
             subtermStack.push(*rIt);
         }
 
-        vector<encoded_token_t> encodedFormula;
-        encoder.encode(m_indexingOptions, currentSubterm,
-                       &encodedFormula, NULL);
-        MwsIndexNode* leaf = m_index->insertData(encodedFormula);
+        EncodedFormula formula;
+        encoder.encode(indexingOptions, currentSubterm, &formula.tokens, NULL);
+        formula.xpath = currentSubterm->getXpath();
+        formulae->push_back(formula);
+    }
+}
+
+int
+IndexManager::indexEncodedFormulae(const vector<EncodedFormula>& formulae,
+                                   const std::string& xmlId,
+                                   const CrawlId& crawlId) {
+    set<FormulaId> uniqueFormulaIds;
+    int numSubExpressions = 0;
+
+    for (const EncodedFormula& formula : formulae) {
+        MwsIndexNode* leaf = m_index->insertData(formula.tokens);
         FormulaId formulaId = leaf->id;
         auto ret = uniqueFormulaIds.insert(formulaId);
         if (ret.second) {
             types::FormulaPath formulaPath;
             formulaPath.xmlId = xmlId;
-            formulaPath.xpath = currentSubterm->getXpath();
+            formulaPath.xpath = formula.xpath;
             m_formulaDb->insertFormula(leaf->id, crawlId, formulaPath);
             leaf->solutions++;
             numSubExpressions++;
@@ -106,4 +159,3 @@ IndexManager::indexContentMath(const types::CmmlToken* cmmlToken,
 }
 
 } }
-
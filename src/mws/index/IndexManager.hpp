@@ -28,10 +28,12 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   */
 
 #include <string>
+#include <vector>
 
 #include "mws/types/CmmlToken.hpp"
 #include "mws/dbc/FormulaDb.hpp"
 #include "mws/dbc/CrawlDb.hpp"
+#include "mws/index/MeaningDictionary.hpp"
 #include "mws/index/MwsIndexNode.hpp"
 
 namespace mws { namespace index {
@@ -40,6 +42,33 @@ struct IndexingOptions {
     bool renameCi;
 };
 
+/**
+ * @brief Subterm of a content math formula, encoded but not yet indexed
+ */
+struct EncodedFormula {
+    std::vector<encoded_token_t> tokens;
+    std::string xpath;
+};
+
+/**
+ * @brief Harvest encoded against its own MeaningDictionary, so that it can
+ * be produced independently of the index and merged later on.
+ *
+ * Crawl ids used by expressions are local: crawl id i refers to
+ * crawlData[i - 1], and CRAWLID_NULL means no associated data.
+ */
+struct EncodedHarvest {
+    struct Expression {
+        std::string xmlId;
+        dbc::CrawlId crawlId;
+        std::vector<EncodedFormula> formulae;
+    };
+
+    MeaningDictionary meaningDictionary;
+    std::vector<dbc::CrawlData> crawlData;
+    std::vector<Expression> expressions;
+};
+
 class IndexManager {
 private:
     dbc::FormulaDb* m_formulaDb;
@@ -72,6 +101,37 @@ public:
     int indexContentMath(const types::CmmlToken* cmmlToken,
                          const std::string xmlId,
                          const dbc::CrawlId& crawlId = dbc::CRAWLID_NULL);
+
+    /**
+     * @brief index a harvest encoded by encodeContentMath(). The meanings
+     * of the harvest are added to the MeaningDictionary in the order of
+     * their local ids, so merging harvests in order yields the same ids as
+     * indexing them sequentially.
+     * @param harvest encoded harvest
+     * @return Number of indexed subexpressions.
+     */
+    int indexEncodedHarvest(const EncodedHarvest& harvest);
+
+    /**
+     * @brief encode all subterms of a content math formula, depth first
+     * @param indexingOptions
+     * @param meaningDictionary dictionary used to encode constants
+     * @param cmmlToken ContentMathML node
+     * @param formulae output encoded subterms
+     */
+    static void encodeContentMath(const IndexingOptions& indexingOptions,
+                                  MeaningDictionary* meaningDictionary,
+                                  const types::CmmlToken* cmmlToken,
+                                  std::vector<EncodedFormula>* formulae);
+
+    const IndexingOptions& getIndexingOptions() const {
+        return m_indexingOptions;
+    }
+
+private:
+    int indexEncodedFormulae(const std::vector<EncodedFormula>& formulae,
+                             const std::string& xmlId,
+                             const dbc::CrawlId& crawlId);
 };
 
 } }
@@ -0,0 +1,438 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file IndexMerger.cpp
+  * @brief Merge of index shards into a single memsector
+  * @date 17 Oct 2026
+  */
+
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <stack>
+using std::stack;
+#include <utility>
+using std::pair;
+#include <vector>
+using std::vector;
+
+#include "mws/dbc/CrawlDb.hpp"
+using mws::dbc::CrawlId;
+#include "mws/types/FormulaPath.hpp"
+using mws::types::FormulaPath;
+#include "mws/index/IndexMerger.hpp"
+
+namespace mws { namespace index {
+
+IndexMerger::IndexMerger(dbc::FormulaDb* formulaDb,
+                         dbc::CrawlDb* crawlDb,
+                         MeaningDictionary* meaningDictionary) :
+    m_formulaDb(formulaDb), m_crawlDb(crawlDb),
+    m_meaningDictionary(meaningDictionary), m_lastFormulaId(0),
+    m_failed(false), m_maxWriteRate(0), m_dbBytesWritten(0) {
+    m_shape.computed = false;
+}
+
+void
+IndexMerger::addShard(const IndexShard& indexShard) {
+    Shard shard;
+    shard.shard = indexShard;
+    shard.meaningIds = mergeMeaningDictionary(*indexShard.meaningDictionary,
+                                              m_meaningDictionary);
+    m_shards.push_back(shard);
+    m_shape.computed = false;
+}
+
+void
+IndexMerger::setMaxWriteRate(uint64_t bytesPerSecond) {
+    m_maxWriteRate = bytesPerSecond;
+}
+
+void
+IndexMerger::setCancelCallback(const std::function<bool()>& isCancelled) {
+    m_isCancelled = isCancelled;
+}
+
+uint64_t
+IndexMerger::getMemsectorSize(index_format_t format, uint32_t offShift,
+                              bool subtreeCounts) const {
+    const uint64_t countsUnits = subtreeCounts ?
+            memsector_units(offShift, sizeof(inode_counts_t)) : 0;
+
+    if (!m_shape.computed || m_shape.format != format) {
+        computeShape(format);
+    }
+
+    uint64_t units = memsector_units(offShift, sizeof(memsector_header_t)) +
+            m_shape.numLeaves * memsector_units(offShift, leaf_size());
+    for (auto& kv : m_shape.numInodes) {
+        units += kv.second *
+                (countsUnits + memsector_units(offShift, kv.first));
+    }
+
+    return units << offShift;
+}
+
+int
+IndexMerger::exportToMemsector(memsector_writer_t* mswr) {
+    const vector<ShardNode> roots = getRoots();
+
+    m_failed = false;
+    m_dbBytesWritten = 0;
+    clock_gettime(CLOCK_MONOTONIC, &m_exportStart);
+    if (!roots.empty()) {
+        if (mswr_get_format(mswr) == INDEX_FORMAT_COMPACT) {
+            exportPostOrder(mswr, roots);
+        } else {
+            exportPreOrder(mswr, roots);
+        }
+    }
+
+    return m_failed ? -1 : 0;
+}
+
+vector<IndexMerger::ShardNode>
+IndexMerger::getRoots() const {
+    vector<ShardNode> roots;
+
+    for (size_t i = 0; i < m_shards.size(); i++) {
+        roots.push_back({i, m_shards[i].shard.index->root});
+    }
+
+    return roots;
+}
+
+static bool
+shardChildLess(const pair<encoded_token_t, const inode_t*>& lhs,
+               const pair<encoded_token_t, const inode_t*>& rhs) {
+    return memcmp(&lhs.first, &rhs.first, sizeof(encoded_token_t)) < 0;
+}
+
+vector<IndexMerger::MergedChild>
+IndexMerger::mergeChildren(const vector<ShardNode>& nodes) const {
+    // Children of all shards, keyed by tokens of the merged dictionary.
+    // Only an empty index has a leaf root, which contributes no children.
+    vector<vector<pair<encoded_token_t, const inode_t*> > > children;
+    vector<size_t> positions(nodes.size(), 0);
+    for (const ShardNode& shardNode : nodes) {
+        const Shard& shard = m_shards[shardNode.shard];
+        const index_handle_t* index = shard.shard.index;
+        vector<pair<encoded_token_t, const inode_t*> > shardChildren;
+
+        if (shardNode.node->type == INTERNAL_NODE) {
+            for (uint32_t i = 0; i < shardNode.node->size; i++) {
+                encoded_token_t token =
+                        inode_get_token(shardNode.node, index->format, i);
+                memsector_off_t off =
+                        inode_get_off(index, shardNode.node, i);
+                shardChildren.push_back(std::make_pair(
+                        translateEncodedToken(token, shard.meaningIds),
+                        (const inode_t*) memsector_off2addr(index->alloc,
+                                                            index->off_shift,
+                                                            off)));
+            }
+            std::sort(shardChildren.begin(), shardChildren.end(),
+                      shardChildLess);
+        }
+        children.push_back(shardChildren);
+    }
+
+    // k-way merge of the sorted children lists
+    vector<MergedChild> mergedChildren;
+    while (true) {
+        const encoded_token_t* minToken = NULL;
+        for (size_t k = 0; k < nodes.size(); k++) {
+            if (positions[k] < children[k].size()) {
+                const encoded_token_t& token = children[k][positions[k]].first;
+                if (minToken == NULL ||
+                        memcmp(&token, minToken, sizeof(token)) < 0) {
+                    minToken = &token;
+                }
+            }
+        }
+        if (minToken == NULL) break;
+
+        vector<ShardNode> group;
+        const encoded_token_t token = *minToken;
+        for (size_t k = 0; k < nodes.size(); k++) {
+            if (positions[k] < children[k].size() &&
+                    memcmp(&children[k][positions[k]].first, &token,
+                           sizeof(token)) == 0) {
+                group.push_back({nodes[k].shard,
+                                 children[k][positions[k]].second});
+                positions[k]++;
+            }
+        }
+        mergedChildren.push_back(std::make_pair(token, group));
+    }
+
+    return mergedChildren;
+}
+
+static bool
+isLeafGroup(const vector<IndexMerger::ShardNode>& nodes) {
+    for (const IndexMerger::ShardNode& shardNode : nodes) {
+        if (shardNode.node->type == INTERNAL_NODE) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+IndexMerger::computeShape(index_format_t format) const {
+    // groups of shard nodes merged into one node, still to be visited
+    stack<vector<ShardNode> > groups;
+
+    m_shape.computed = true;
+    m_shape.format = format;
+    m_shape.numInodes.clear();
+    m_shape.numLeaves = 0;
+    groups.push(getRoots());
+    while (!groups.empty()) {
+        vector<ShardNode> nodes;
+        nodes.swap(groups.top());
+        groups.pop();
+        if (nodes.empty()) continue;
+
+        if (isLeafGroup(nodes)) {
+            m_shape.numLeaves++;
+            continue;
+        }
+        vector<MergedChild> mergedChildren = mergeChildren(nodes);
+        m_shape.numInodes[inode_size(format, mergedChildren.size())]++;
+        for (MergedChild& child : mergedChildren) {
+            groups.push(vector<ShardNode>());
+            groups.top().swap(child.second);
+        }
+    }
+}
+
+void
+IndexMerger::exportPreOrder(memsector_writer_t* mswr,
+                            const vector<ShardNode>& roots) {
+    struct ExportFrame {
+        memsector_off_t off;
+        vector<MergedChild> children;
+        size_t nextChild;
+    };
+    // Nodes are written in depth first pre-order. The stack holds the path
+    // to the current node, with the merged children of each inode.
+    stack<ExportFrame> path;
+    const index_format_t format = mswr_get_format(mswr);
+    vector<MergedChild> mergedChildren;
+
+    memsector_off_t off = mergeNode(mswr, roots, &mergedChildren);
+    if (m_failed) return;
+    mswr_set_root(mswr, off);
+    if (!mergedChildren.empty()) {
+        path.push({off, vector<MergedChild>(), 0});
+        path.top().children.swap(mergedChildren);
+    }
+
+    while (!path.empty()) {
+        ExportFrame& frame = path.top();
+        if (frame.nextChild == frame.children.size()) {
+            // the subtree of the inode is complete
+            memsector_writer_set_subtree_counts(mswr, frame.off);
+            path.pop();
+            continue;
+        }
+
+        size_t i = frame.nextChild++;
+        off = mergeNode(mswr, frame.children[i].second, &mergedChildren);
+        if (m_failed) return;
+        // Merging may remap the memsector: resolve the parent afterwards
+        inode_t* inode = (inode_t*) mswr_off2addr(mswr, frame.off);
+        inode_set_off(inode, format, i, off);
+
+        if (!mergedChildren.empty()) {
+            path.push({off, vector<MergedChild>(), 0});
+            path.top().children.swap(mergedChildren);
+        }
+    }
+}
+
+void
+IndexMerger::exportPostOrder(memsector_writer_t* mswr,
+                             const vector<ShardNode>& roots) {
+    struct ExportFrame {
+        vector<MergedChild> children;
+        vector<memsector_off_t> childOffs;
+    };
+    // The stack holds the path to the current inode, with the offsets of
+    // the children written so far.
+    stack<ExportFrame> path;
+    vector<encoded_token_t> tokens;
+    memsector_off_t off;
+
+    if (isLeafGroup(roots)) {
+        off = mergeLeaves(mswr, roots);
+        if (!m_failed) mswr_set_root(mswr, off);
+        return;
+    }
+
+    path.push({mergeChildren(roots), {}});
+    while (true) {
+        ExportFrame& frame = path.top();
+        size_t i = frame.childOffs.size();
+        if (i < frame.children.size()) {
+            const vector<ShardNode>& nodes = frame.children[i].second;
+            if (isLeafGroup(nodes)) {
+                off = mergeLeaves(mswr, nodes);
+                if (m_failed) return;
+                frame.childOffs.push_back(off);
+            } else {
+                path.push({mergeChildren(nodes), {}});
+            }
+            continue;
+        }
+
+        tokens.clear();
+        for (const MergedChild& child : frame.children) {
+            tokens.push_back(child.first);
+        }
+        off = memsector_writer_write_inode(mswr, tokens.size(),
+                                           tokens.data(),
+                                           frame.childOffs.data());
+        if (off == MEMSECTOR_OFF_NULL) {
+            m_failed = true;
+            return;
+        }
+
+        path.pop();
+        if (path.empty()) break;
+        path.top().childOffs.push_back(off);
+    }
+    mswr_set_root(mswr, off);
+}
+
+memsector_off_t
+IndexMerger::mergeNode(memsector_writer_t* mswr,
+                       const vector<ShardNode>& nodes,
+                       vector<MergedChild>* mergedChildren) {
+    mergedChildren->clear();
+    if (isLeafGroup(nodes)) {
+        return mergeLeaves(mswr, nodes);
+    }
+
+    *mergedChildren = mergeChildren(nodes);
+    const index_format_t format = mswr_get_format(mswr);
+    memsector_off_t off =
+            memsector_writer_alloc_inode(mswr, mergedChildren->size());
+    if (off == MEMSECTOR_OFF_NULL) {
+        m_failed = true;
+        return off;
+    }
+    inode_t* inode = (inode_t*) mswr_off2addr(mswr, off);
+    for (size_t i = 0; i < mergedChildren->size(); i++) {
+        inode_set_token(inode, format, i, (*mergedChildren)[i].first);
+    }
+    inode_build_index(inode, format);
+
+    return off;
+}
+
+memsector_off_t
+IndexMerger::mergeLeaves(memsector_writer_t* mswr,
+                         const vector<ShardNode>& nodes) {
+    memsector_off_t off = memsector_writer_alloc(mswr, leaf_size());
+    if (off == MEMSECTOR_OFF_NULL) {
+        m_failed = true;
+        return off;
+    }
+    leaf_t* leaf = (leaf_t*) mswr_off2addr(mswr, off);
+    const uint32_t formulaId = ++m_lastFormulaId;
+    uint32_t numHits = 0;
+
+    for (const ShardNode& shardNode : nodes) {
+        const leaf_t* shardLeaf = (const leaf_t*) shardNode.node;
+        Shard* shard = &m_shards[shardNode.shard];
+
+        numHits += shardLeaf->num_hits;
+        int ret = shard->shard.formulaDb->queryFormula(shardLeaf->formula_id,
+                0, shardLeaf->num_hits,
+                [this, shard, formulaId](const CrawlId& crawlId,
+                                         const FormulaPath& formulaPath) {
+            m_dbBytesWritten += sizeof(formulaId) + sizeof(crawlId) +
+                    formulaPath.xmlId.size() + formulaPath.xpath.size();
+            return m_formulaDb->insertFormula(formulaId,
+                                              translateCrawlId(shard, crawlId),
+                                              formulaPath);
+        });
+        if (ret != 0) {
+            m_failed = true;
+        }
+    }
+    leaf->type = LEAF_NODE;
+    leaf->num_hits = numHits;
+    leaf->formula_id = formulaId;
+    throttle(mswr);
+
+    return off;
+}
+
+CrawlId
+IndexMerger::translateCrawlId(Shard* shard, CrawlId crawlId) {
+    if (crawlId == dbc::CRAWLID_NULL) {
+        return dbc::CRAWLID_NULL;
+    }
+
+    auto it = shard->crawlIds.find(crawlId);
+    if (it != shard->crawlIds.end()) {
+        return it->second;
+    }
+    const dbc::CrawlData crawlData = shard->shard.crawlDb->getData(crawlId);
+    CrawlId mergedCrawlId = m_crawlDb->putData(crawlData);
+    m_dbBytesWritten += crawlData.size();
+    shard->crawlIds.insert(std::make_pair(crawlId, mergedCrawlId));
+
+    return mergedCrawlId;
+}
+
+void
+IndexMerger::throttle(memsector_writer_t* mswr) {
+    if (m_isCancelled && m_isCancelled()) {
+        m_failed = true;
+        return;
+    }
+    if (m_maxWriteRate == 0) return;
+
+    // time at which the bytes written so far are due
+    const uint64_t written = mswr_size_inuse(mswr) + m_dbBytesWritten;
+    const double due = (double) written / m_maxWriteRate;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const double elapsed = (now.tv_sec - m_exportStart.tv_sec) +
+            (now.tv_nsec - m_exportStart.tv_nsec) / 1e9;
+    // sleeping in steps of at least 10ms
+    if (due > elapsed + 0.01) {
+        struct timespec delay;
+        delay.tv_sec = (time_t) (due - elapsed);
+        delay.tv_nsec = (long) ((due - elapsed - delay.tv_sec) * 1e9);
+        nanosleep(&delay, NULL);
+    }
+}
+
+}  // namespace index
+}  // namespace mws
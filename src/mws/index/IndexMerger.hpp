@@ -0,0 +1,166 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_INDEX_INDEXMERGER_HPP
+#define _MWS_INDEX_INDEXMERGER_HPP
+
+/**
+  * @file IndexMerger.hpp
+  * @brief Merge of index shards into a single memsector
+  * @date 17 Oct 2026
+  */
+
+#include <stdint.h>
+#include <time.h>
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "mws/dbc/CrawlDb.hpp"
+#include "mws/dbc/FormulaDb.hpp"
+#include "mws/index/index.h"
+#include "mws/index/memsector.h"
+#include "mws/index/MeaningDictionary.hpp"
+
+namespace mws { namespace index {
+
+/**
+ * @brief Index built independently by mws-index
+ */
+struct IndexShard {
+    const index_handle_t* index;
+    const MeaningDictionary* meaningDictionary;
+    dbc::FormulaDb* formulaDb;
+    dbc::CrawlDb* crawlDb;
+};
+
+/**
+ * @brief k-way merge of index shards. The sorted children of the shard
+ * inodes are merged level by level directly into the output memsector, so
+ * only the shards (mmapped) and one root-to-leaf path are held in memory.
+ * The path is kept on the heap, so formulae of any depth can be merged.
+ * Leaves get fresh formula ids, and the formula and crawl databases are
+ * rewritten accordingly.
+ */
+class IndexMerger {
+ public:
+    IndexMerger(dbc::FormulaDb* formulaDb,
+                dbc::CrawlDb* crawlDb,
+                MeaningDictionary* meaningDictionary);
+
+    /**
+     * @brief add a shard to be merged. Shards are merged in the order they
+     * were added.
+     */
+    void addShard(const IndexShard& shard);
+
+    /**
+     * @brief limit the rate at which the merged index is written, so that
+     * merging does not starve other users of the disk
+     * @param bytesPerSecond bytes of memsector and database entries written
+     * per second, 0 for no limit
+     */
+    void setMaxWriteRate(uint64_t bytesPerSecond);
+
+    /**
+     * @param isCancelled polled while merging, which fails once it returns
+     * true
+     */
+    void setCancelCallback(const std::function<bool()>& isCancelled);
+
+    /**
+     * @param format format of the merged index
+     * @param offShift offsets are in units of 1 << offShift bytes
+     * @param subtreeCounts internal nodes are preceded by their counts
+     * @return size of the memsector holding the merged index, or its upper
+     * bound with INDEX_FORMAT_COMPACT. The shards are walked once per
+     * format, so that trying several offShift values is cheap.
+     */
+    uint64_t getMemsectorSize(index_format_t format = INDEX_FORMAT_LATEST,
+                              uint32_t offShift = 0,
+                              bool subtreeCounts = false) const;
+
+    /**
+     * @brief merge the shards in a memsector
+     * @param mswr memsector writer handle
+     * @return 0 on success and -1 on failure.
+     * @throw I/O exceptions of the crawl databases
+     */
+    int exportToMemsector(memsector_writer_t* mswr);
+
+    struct ShardNode {
+        size_t shard;
+        const inode_t* node;
+    };
+
+ private:
+    typedef std::pair<encoded_token_t, std::vector<ShardNode> > MergedChild;
+
+    /// Number of inodes of each size, and of leaves, of the merged index
+    struct MergedShape {
+        bool computed;
+        index_format_t format;
+        std::map<uint32_t, uint64_t> numInodes;
+        uint64_t numLeaves;
+    };
+
+    struct Shard {
+        IndexShard shard;
+        std::vector<MeaningId> meaningIds;
+        std::unordered_map<dbc::CrawlId, dbc::CrawlId> crawlIds;
+    };
+
+    std::vector<ShardNode> getRoots() const;
+    std::vector<MergedChild>
+    mergeChildren(const std::vector<ShardNode>& nodes) const;
+    void computeShape(index_format_t format) const;
+    void exportPreOrder(memsector_writer_t* mswr,
+                        const std::vector<ShardNode>& roots);
+    void exportPostOrder(memsector_writer_t* mswr,
+                         const std::vector<ShardNode>& roots);
+    memsector_off_t mergeNode(memsector_writer_t* mswr,
+                              const std::vector<ShardNode>& nodes,
+                              std::vector<MergedChild>* mergedChildren);
+    memsector_off_t mergeLeaves(memsector_writer_t* mswr,
+                                const std::vector<ShardNode>& nodes);
+    dbc::CrawlId translateCrawlId(Shard* shard, dbc::CrawlId crawlId);
+    void throttle(memsector_writer_t* mswr);
+
+    dbc::FormulaDb* m_formulaDb;
+    dbc::CrawlDb* m_crawlDb;
+    MeaningDictionary* m_meaningDictionary;
+    std::vector<Shard> m_shards;
+    /// Computed by getMemsectorSize()
+    mutable MergedShape m_shape;
+    uint32_t m_lastFormulaId;
+    bool m_failed;
+    uint64_t m_maxWriteRate;
+    std::function<bool()> m_isCancelled;
+    /// Bytes of database entries written by exportToMemsector
+    uint64_t m_dbBytesWritten;
+    struct timespec m_exportStart;
+};
+
+}  // namespace index
+}  // namespace mws
+
+#endif  // _MWS_INDEX_INDEXMERGER_HPP
@@ -0,0 +1,136 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file IndexSegments.cpp
+  * @brief Layout of the delta segments appended to an index
+  * @date 18 Oct 2026
+  */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "mws/index/IndexSegments.hpp"
+
+namespace mws { namespace index {
+
+vector<int> getDeltaSegments(const string& indexPath) {
+    vector<int> segments;
+    DIR* dir = opendir(indexPath.c_str());
+    if (dir == NULL) return segments;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int n, length;
+        // skips delta-<n>.tmp, still being written
+        if (sscanf(entry->d_name, "delta-%d%n", &n, &length) == 1 &&
+                entry->d_name[length] == '\0' && n > 0) {
+            segments.push_back(n);
+        }
+    }
+    closedir(dir);
+    std::sort(segments.begin(), segments.end());
+
+    return segments;
+}
+
+string getDeltaSegmentPath(const string& indexPath, int n) {
+    return indexPath + "/delta-" + std::to_string(n);
+}
+
+string createDeltaSegment(const string& indexPath, string* deltaPath) {
+    vector<int> segments = getDeltaSegments(indexPath);
+    int n = segments.empty() ? 1 : segments.back() + 1;
+    *deltaPath = getDeltaSegmentPath(indexPath, n);
+    string segmentPath = *deltaPath + ".tmp";
+
+    if (removeDirectory(segmentPath) != 0 ||
+            mkdir(segmentPath.c_str(), 0755) != 0) {
+        return "";
+    }
+
+    return segmentPath;
+}
+
+static int removeEntry(const char* path, const struct stat*, int,
+                       struct FTW*) {
+    return remove(path);
+}
+
+int removeDirectory(const string& path) {
+    struct stat status;
+    if (lstat(path.c_str(), &status) != 0) {
+        return (errno == ENOENT) ? 0 : -1;
+    }
+
+    return nftw(path.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+string getRealPath(const string& path) {
+    char* resolved = realpath(path.c_str(), NULL);
+    if (resolved == NULL) return "";
+    string realPath = resolved;
+    free(resolved);
+
+    return realPath;
+}
+
+string getIndexSiblingPath(const string& indexPath, const string& suffix) {
+    string path = indexPath;
+    // next to "index/" is "index.lock", not "index/.lock"
+    while (path.size() > 1 && path[path.size() - 1] == '/') {
+        path.resize(path.size() - 1);
+    }
+
+    return path + suffix;
+}
+
+int lockIndex(const string& indexPath) {
+    string lockPath = getIndexSiblingPath(indexPath, ".lock");
+    int lock = open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (lock < 0) return -1;
+    if (flock(lock, LOCK_EX) != 0) {
+        close(lock);
+        return -1;
+    }
+
+    return lock;
+}
+
+void unlockIndex(int lock) {
+    flock(lock, LOCK_UN);
+    close(lock);
+}
+
+}  // namespace index
+}  // namespace mws
@@ -0,0 +1,87 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_INDEX_INDEXSEGMENTS_HPP
+#define _MWS_INDEX_INDEXSEGMENTS_HPP
+
+/**
+  * @file IndexSegments.hpp
+  * @brief Layout of the delta segments appended to an index
+  * @date 18 Oct 2026
+  *
+  * An index directory holds a base segment (memsector.dat and the crawl
+  * and formula databases) and the delta segments written by
+  * mws-index --append, each in a subdirectory delta-<n> with the same
+  * files. All segments are encoded with the meaning.dat of the index
+  * directory, to which the meanings of each delta are added. meaning.idx
+  * holds the same meanings, memory mapped by the daemon.
+  *
+  * Appending a delta and swapping in a compacted index are serialized by
+  * lockIndex(), whose lock file <index>.lock lives next to the index
+  * directory, which is replaced when compacting.
+  */
+
+#include <string>
+#include <vector>
+
+namespace mws { namespace index {
+
+/**
+ * @return numbers of the delta segments of an index directory, in the
+ * order they were appended
+ */
+std::vector<int> getDeltaSegments(const std::string& indexPath);
+
+/// @return directory of the delta segment number n of an index directory
+std::string getDeltaSegmentPath(const std::string& indexPath, int n);
+
+/**
+ * @brief create the directory delta-<n>.tmp where the next delta segment is
+ * written, before renaming it to delta-<n>. One left by a failed append is
+ * removed first. The caller holds lockIndex().
+ * @param deltaPath set to the path delta-<n> of the delta segment
+ * @return path of the directory, or "" on failure
+ */
+std::string createDeltaSegment(const std::string& indexPath,
+                               std::string* deltaPath);
+
+/// Remove a directory and its contents, if it exists
+int removeDirectory(const std::string& path);
+
+/// @return absolute path without symbolic links, or "" if it does not exist
+std::string getRealPath(const std::string& path);
+
+/// @return path <index><suffix> next to an index directory
+std::string getIndexSiblingPath(const std::string& indexPath,
+                                const std::string& suffix);
+
+/**
+ * @brief wait until no other process changes the segments of an index
+ * @return descriptor of the lock, or -1 on failure
+ */
+int lockIndex(const std::string& indexPath);
+
+/// Release a lock returned by lockIndex()
+void unlockIndex(int lock);
+
+}  // namespace index
+}  // namespace mws
+
+#endif  // _MWS_INDEX_INDEXSEGMENTS_HPP
@@ -31,6 +31,8 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   *
   */
 
+#include <vector>
+
 #include "common/types/IdDictionary.hpp"
 #include "mws/types/CmmlToken.hpp"
 #include "mws/index/encoded_token.h"
@@ -40,6 +42,39 @@ namespace mws { namespace index {
 typedef common::types::IdDictionary<types::Meaning, MeaningId>
 MeaningDictionary;
 
+/**
+ * @brief add the meanings of a dictionary to another one, in id order
+ * @param from dictionary whose meanings are added
+ * @param into dictionary where meanings are added
+ * @return translation table: meaning id i of from is id result[i] of into
+ */
+inline std::vector<MeaningId>
+mergeMeaningDictionary(const MeaningDictionary& from,
+                       MeaningDictionary* into) {
+    const std::vector<types::Meaning> meanings = from.getKeys();
+    std::vector<MeaningId> meaningIds(meanings.size() + 1);
+
+    for (size_t i = 0; i < meanings.size(); i++) {
+        meaningIds[i + 1] = into->put(meanings[i]);
+    }
+
+    return meaningIds;
+}
+
+/**
+ * @brief translate the constant of an encoded token using a table returned
+ * by mergeMeaningDictionary()
+ */
+inline encoded_token_t
+translateEncodedToken(encoded_token_t token,
+                      const std::vector<MeaningId>& meaningIds) {
+    if (token.id >= CONSTANT_ID_MIN) {
+        token.id = CONSTANT_ID_MIN + meaningIds[token.id - CONSTANT_ID_MIN];
+    }
+
+    return token;
+}
+
 }  // namespace types
 }  // namesapce mws
 
@@ -0,0 +1,207 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file MmapMeaningDictionary.cpp
+  * @brief Memory mapped read-only Meaning Dictionary implementation
+  * @date 18 Oct 2026
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <stdexcept>
+using std::runtime_error;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "mws/types/CmmlToken.hpp"
+using mws::types::Meaning;
+#include "mws/index/MmapMeaningDictionary.hpp"
+
+namespace mws { namespace index {
+
+static const char MAGIC[8] = {'M', 'W', 'S', 'M', 'E', 'A', 'N', 'S'};
+static const uint32_t VERSION = 1;
+static const MeaningId KEY_NOT_FOUND = MeaningDictionary::KEY_NOT_FOUND;
+
+/// FNV-1a
+static uint64_t hashKey(const char* key, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char) key[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+MmapMeaningDictionary::MmapMeaningDictionary() : mMapped(false),
+    mKeys(NULL), mOffsets(NULL), mSlots(NULL), mNumKeys(0), mSlotMask(0) {
+}
+
+MmapMeaningDictionary::~MmapMeaningDictionary() {
+    if (mMapped) (void) mmap_unload(&mMmap);
+}
+
+void MmapMeaningDictionary::open(const char* path) throw (runtime_error) {
+    MmapMeaningDictionaryFooter footer;
+
+    mPath = path;
+    if (mmap_load(mPath.c_str(), MAP_SHARED, &mMmap) != 0) {
+        throw runtime_error(mPath + ": cannot map file");
+    }
+    mMapped = true;
+
+    if (mMmap.size < sizeof(footer)) {
+        throw runtime_error(mPath + ": truncated meaning dictionary");
+    }
+    const uint64_t footerPos = mMmap.size - sizeof(footer);
+    memcpy(&footer, mMmap.start_addr + footerPos, sizeof(footer));
+    if (memcmp(footer.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            footer.version != VERSION) {
+        throw runtime_error(mPath + ": not a meaning dictionary");
+    }
+    if (footer.offsetsPos % sizeof(uint64_t) != 0 ||
+            footer.slotsPos - footer.offsetsPos !=
+            ((uint64_t) footer.numKeys + 1) * sizeof(uint64_t) ||
+            footer.slotsPos > footerPos ||
+            footerPos - footer.slotsPos !=
+            (uint64_t) footer.numSlots * sizeof(MeaningSlot) ||
+            footer.numSlots <= footer.numKeys ||
+            (footer.numSlots & (footer.numSlots - 1)) != 0) {
+        throw runtime_error(mPath + ": corrupted meaning dictionary");
+    }
+
+    mKeys = mMmap.start_addr;
+    mOffsets = (const uint64_t*) (mMmap.start_addr + footer.offsetsPos);
+    mSlots = (const MeaningSlot*) (mMmap.start_addr + footer.slotsPos);
+    mNumKeys = footer.numKeys;
+    mSlotMask = footer.numSlots - 1;
+    if (mOffsets[mNumKeys] > footer.offsetsPos) {
+        throw runtime_error(mPath + ": corrupted meaning dictionary");
+    }
+}
+
+void MmapMeaningDictionary::save(const MeaningDictionary& dictionary,
+                                 const char* path) throw (runtime_error) {
+    const vector<Meaning> keys = dictionary.getKeys();
+    MmapMeaningDictionaryFooter footer;
+    const char padding[sizeof(uint64_t)] = {0};
+    vector<uint64_t> offsets(1, 0);
+    uint32_t numSlots = 1;
+
+    while (numSlots < 2 * keys.size()) numSlots <<= 1;
+    const MeaningSlot emptySlot = {0, KEY_NOT_FOUND};
+    vector<MeaningSlot> slots(numSlots, emptySlot);
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        throw runtime_error(string(path) + ": cannot create file");
+    }
+    bool failed = false;
+    for (size_t i = 0; i < keys.size(); i++) {
+        const Meaning& key = keys[i];
+        failed |= fwrite(key.data(), 1, key.size(), file) != key.size();
+        offsets.push_back(offsets.back() + key.size());
+
+        const uint64_t hash = hashKey(key.data(), key.size());
+        uint32_t slot = hash & (numSlots - 1);
+        while (slots[slot].meaningId != KEY_NOT_FOUND) {
+            slot = (slot + 1) & (numSlots - 1);
+        }
+        slots[slot].hashTag = hash >> 32;
+        slots[slot].meaningId = i + 1;
+    }
+
+    const uint64_t keysSize = offsets.back();
+    const size_t paddingSize = (sizeof(uint64_t) - keysSize % sizeof(uint64_t))
+            % sizeof(uint64_t);
+    footer.offsetsPos = keysSize + paddingSize;
+    footer.slotsPos = footer.offsetsPos + offsets.size() * sizeof(uint64_t);
+    footer.numKeys = keys.size();
+    footer.numSlots = numSlots;
+    footer.version = VERSION;
+    footer.unused = 0;
+    memcpy(footer.magic, MAGIC, sizeof(MAGIC));
+
+    failed |= fwrite(padding, 1, paddingSize, file) != paddingSize;
+    failed |= fwrite(offsets.data(), sizeof(uint64_t), offsets.size(),
+                     file) != offsets.size();
+    failed |= fwrite(slots.data(), sizeof(MeaningSlot), slots.size(),
+                     file) != slots.size();
+    failed |= fwrite(&footer, sizeof(footer), 1, file) != 1;
+    failed |= fclose(file) != 0;
+    if (failed) {
+        throw runtime_error(string(path) + ": write failed");
+    }
+}
+
+bool MmapMeaningDictionary::isUpToDate(const char* path,
+                                       const char* dictionaryPath) {
+    struct stat status;
+    struct stat dictionaryStatus;
+
+    if (stat(path, &status) != 0 ||
+            stat(dictionaryPath, &dictionaryStatus) != 0) {
+        return false;
+    }
+    if (status.st_mtim.tv_sec != dictionaryStatus.st_mtim.tv_sec) {
+        return status.st_mtim.tv_sec > dictionaryStatus.st_mtim.tv_sec;
+    }
+
+    return status.st_mtim.tv_nsec >= dictionaryStatus.st_mtim.tv_nsec;
+}
+
+MeaningId MmapMeaningDictionary::get(const Meaning& meaning) const {
+    if (!mMapped) return KEY_NOT_FOUND;
+
+    const uint64_t hash = hashKey(meaning.data(), meaning.size());
+    const uint32_t hashTag = hash >> 32;
+    uint32_t slot = hash & mSlotMask;
+    // the table always has an empty slot, ending the probe
+    for (uint32_t probes = 0; probes <= mSlotMask; probes++) {
+        const MeaningId meaningId = mSlots[slot].meaningId;
+        if (meaningId == KEY_NOT_FOUND) break;
+        if (mSlots[slot].hashTag == hashTag && meaningId <= mNumKeys) {
+            const uint64_t begin = mOffsets[meaningId - 1];
+            const uint64_t end = mOffsets[meaningId];
+            if (end - begin == meaning.size() &&
+                    memcmp(mKeys + begin, meaning.data(),
+                           meaning.size()) == 0) {
+                return meaningId;
+            }
+        }
+        slot = (slot + 1) & mSlotMask;
+    }
+
+    return KEY_NOT_FOUND;
+}
+
+uint32_t MmapMeaningDictionary::size() const {
+    return mNumKeys;
+}
+
+}  // namespace index
+}  // namespace mws
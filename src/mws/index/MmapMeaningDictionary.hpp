@@ -0,0 +1,114 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_INDEX_MMAPMEANINGDICTIONARY_HPP
+#define _MWS_INDEX_MMAPMEANINGDICTIONARY_HPP
+
+/**
+  * @file MmapMeaningDictionary.hpp
+  * @brief Memory mapped read-only Meaning Dictionary API
+  * @date 18 Oct 2026
+  *
+  * The dictionary is a flat file (meaning.idx) written next to meaning.dat
+  * from the same MeaningDictionary, and looked up without parsing it:
+  *
+  *     keys            keys of ids 1..n, one after another
+  *     padding         to 8 bytes
+  *     offsets         uint64_t[n + 1], the key of id i lies between
+  *                     offsets[i - 1] and offsets[i]
+  *     slots           MeaningSlot[numSlots], hash table of the ids with
+  *                     linear probing, at most half full
+  *     footer          MmapMeaningDictionaryFooter
+  *
+  * Integers are stored in host byte order.
+  */
+
+#include <stdint.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "common/utils/mmap.h"
+#include "mws/index/MeaningDictionary.hpp"
+
+namespace mws { namespace index {
+
+struct MeaningSlot {
+    uint32_t hashTag;           ///< upper half of the hash of the key
+    uint32_t meaningId;         ///< KEY_NOT_FOUND for an empty slot
+};
+
+struct MmapMeaningDictionaryFooter {
+    uint64_t offsetsPos;
+    uint64_t slotsPos;
+    uint32_t numKeys;
+    uint32_t numSlots;          ///< power of 2
+    uint32_t version;
+    uint32_t unused;
+    char     magic[8];
+};
+
+class MmapMeaningDictionary {
+ public:
+    MmapMeaningDictionary();
+    ~MmapMeaningDictionary();
+
+    /**
+     * @brief map a dictionary written by save() for reading
+     * @throw runtime_error if the file cannot be mapped or is malformed
+     */
+    void open(const char* path) throw (std::runtime_error);
+
+    /**
+     * @brief write the meanings of a dictionary, with the same ids
+     * @throw runtime_error if the file cannot be written
+     */
+    static void save(const MeaningDictionary& dictionary, const char* path)
+    throw (std::runtime_error);
+
+    /**
+     * @return whether the file at path exists and was written after the
+     * saved MeaningDictionary at dictionaryPath, so they hold the same ids
+     */
+    static bool isUpToDate(const char* path, const char* dictionaryPath);
+
+    /// @return id of meaning, or MeaningDictionary::KEY_NOT_FOUND
+    MeaningId get(const types::Meaning& meaning) const;
+
+    uint32_t size() const;
+
+ private:
+    MmapMeaningDictionary(const MmapMeaningDictionary&);
+    MmapMeaningDictionary& operator=(const MmapMeaningDictionary&);
+
+    std::string mPath;
+    mmap_handle_t mMmap;
+    bool mMapped;
+    const char* mKeys;
+    const uint64_t* mOffsets;
+    const MeaningSlot* mSlots;
+    uint32_t mNumKeys;
+    uint32_t mSlotMask;
+};
+
+}  // namespace index
+}  // namespace mws
+
+#endif  // _MWS_INDEX_MMAPMEANINGDICTIONARY_HPP
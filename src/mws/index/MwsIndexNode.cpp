@@ -25,6 +25,8 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   * @date   03 May 2011
   */
 
+#include <new>
+#include <stack>
 #include <string>
 #include <vector>
 
@@ -48,15 +50,22 @@ namespace mws
 
 MwsIndexNode::MwsIndexNode() :
     id          ( ++MwsIndexNode::nextNodeId ),
-    solutions   ( 0 )
+    solutions   ( 0 ),
+    arena       ( new common::utils::Arena() )
+{ }
+
+
+MwsIndexNode::MwsIndexNode(common::utils::Arena* arena) :
+    id          ( ++MwsIndexNode::nextNodeId ),
+    solutions   ( 0 ),
+    arena       ( arena )
 { }
 
 
 MwsIndexNode::~MwsIndexNode()
 {
-    for (auto it = children.begin(); it != children.end(); it ++) {
-        delete it->second;
-    }
+    // Only roots are destructed: descendants are released with the arena
+    delete arena;
 }
 
 
@@ -69,10 +78,10 @@ MwsIndexNode::insertData(const vector<encoded_token_t>& encodedFormula) {
         auto mapIt = currentNode->children.find(encodedToken);
         // If no such node exists, we create it
         if (mapIt == currentNode->children.end()) {
-            pair<_MapType::iterator, bool> ret =
-                currentNode->children.insert(make_pair(encodedToken,
-                                                       new MwsIndexNode()));
-            currentNode = ret.first->second;
+            MwsIndexNode* child = new (arena->allocate(sizeof(MwsIndexNode)))
+                    MwsIndexNode(arena);
+            currentNode->children.insert(encodedToken, child, arena);
+            currentNode = child;
         } else {
             currentNode = mapIt->second;
         }
@@ -82,54 +91,148 @@ MwsIndexNode::insertData(const vector<encoded_token_t>& encodedFormula) {
 }
 
 uint64_t
-MwsIndexNode::getMemsectorSize() const {
-    uint64_t size = 0;
-
-    if (children.size() > 0) {
-        size += inode_size(children.size());
-        for (auto& kv : children) {
-            const MwsIndexNode* child = kv.second;
-            size += child->getMemsectorSize();
+MwsIndexNode::getMemsectorSize(index_format_t format,
+                               uint32_t offShift,
+                               bool subtreeCounts) const {
+    uint64_t size = memsector_units(offShift, sizeof(memsector_header_t));
+    const uint64_t countsUnits = subtreeCounts ?
+            memsector_units(offShift, sizeof(inode_counts_t)) : 0;
+    stack<const MwsIndexNode*> nodes;
+
+    nodes.push(this);
+    while (!nodes.empty()) {
+        const MwsIndexNode* node = nodes.top();
+        nodes.pop();
+
+        if (node->children.size() > 0) {
+            size += countsUnits +
+                    memsector_units(offShift,
+                                    inode_size(format, node->children.size()));
+            for (auto& kv : node->children) {
+                nodes.push(kv.second);
+            }
+        } else {
+            size += memsector_units(offShift, leaf_size());
         }
-    } else {
-        size += leaf_size();
     }
 
-    return size;
+    return size << offShift;
 }
 
 memsector_off_t
-MwsIndexNode::exportToMemsector(memsector_alloc_header_t* alloc) const {
+MwsIndexNode::exportNode(memsector_writer_t* mswr) const {
     memsector_off_t off;
 
     if (children.size() > 0) {  // internal node
-        off = inode_alloc(alloc, this->children.size());
-        inode_t *inode = (inode_t*) memsector_off2addr(alloc, off);
-        inode->type = INTERNAL_NODE;
-        inode->size = this->children.size();
-
-        int i = 0;
-        for (auto& kv : this->children) {
-            const MwsIndexNode* child = kv.second;
-            inode->data[i].token = kv.first;
-            inode->data[i].off = child->exportToMemsector(alloc);
-
-            i++;
+        index_format_t format = mswr_get_format(mswr);
+        off = memsector_writer_alloc_inode(mswr, children.size());
+        if (off == MEMSECTOR_OFF_NULL) return off;
+        inode_t *inode = (inode_t*) mswr_off2addr(mswr, off);
+        uint32_t i = 0;
+        for (auto& kv : children) {
+            inode_set_token(inode, format, i++, kv.first);
         }
+        inode_build_index(inode, format);
     } else {  // leaf node
-        off = leaf_alloc(alloc);
-        leaf_t *leaf = (leaf_t*) memsector_off2addr(alloc, off);
+        off = memsector_writer_alloc(mswr, leaf_size());
+        if (off == MEMSECTOR_OFF_NULL) return off;
+        leaf_t *leaf = (leaf_t*) mswr_off2addr(mswr, off);
         leaf->type = LEAF_NODE;
-        leaf->num_hits = this->solutions;
-        leaf->formula_id = this->id;
+        leaf->num_hits = solutions;
+        leaf->formula_id = id;
     }
 
     return off;
 }
 
-void
+int
 MwsIndexNode::exportToMemsector(memsector_writer_t* mswr) const {
-    this->exportToMemsector(mswr_get_alloc(mswr));
+    struct ExportFrame {
+        const MwsIndexNode* node;
+        memsector_off_t off;
+        uint32_t nextChild;
+    };
+    // Nodes are written in depth first pre-order. The stack holds the path
+    // to the current node, with the offset of each exported internal node.
+    stack<ExportFrame> path;
+
+    if (mswr_get_format(mswr) == INDEX_FORMAT_COMPACT) {
+        return exportPostOrder(mswr);
+    }
+
+    memsector_off_t off = exportNode(mswr);
+    if (off == MEMSECTOR_OFF_NULL) return -1;
+    mswr_set_root(mswr, off);
+    if (children.size() > 0) {
+        path.push({this, off, 0});
+    }
+
+    while (!path.empty()) {
+        ExportFrame& frame = path.top();
+        if (frame.nextChild == frame.node->children.size()) {
+            // the subtree of the node is complete
+            memsector_writer_set_subtree_counts(mswr, frame.off);
+            path.pop();
+            continue;
+        }
+
+        uint32_t i = frame.nextChild++;
+        auto child = frame.node->children.begin() + i;
+        off = child->second->exportNode(mswr);
+        if (off == MEMSECTOR_OFF_NULL) return -1;
+        // Exporting may remap the memsector: resolve the parent afterwards
+        inode_t* inode = (inode_t*) mswr_off2addr(mswr, frame.off);
+        inode_set_off(inode, mswr_get_format(mswr), i, off);
+
+        if (child->second->children.size() > 0) {
+            path.push({child->second, off, 0});
+        }
+    }
+
+    return 0;
+}
+
+int
+MwsIndexNode::exportPostOrder(memsector_writer_t* mswr) const {
+    struct ExportFrame {
+        const MwsIndexNode* node;
+        vector<memsector_off_t> childOffs;
+    };
+    // The stack holds the path to the current node, with the offsets of the
+    // children exported so far.
+    stack<ExportFrame> path;
+    vector<encoded_token_t> tokens;
+    memsector_off_t off;
+
+    path.push({this, {}});
+    while (true) {
+        ExportFrame& frame = path.top();
+        size_t i = frame.childOffs.size();
+        if (i < frame.node->children.size()) {
+            path.push({(frame.node->children.begin() + i)->second, {}});
+            continue;
+        }
+
+        if (frame.node->children.size() > 0) {
+            tokens.clear();
+            for (auto& kv : frame.node->children) {
+                tokens.push_back(kv.first);
+            }
+            off = memsector_writer_write_inode(mswr, tokens.size(),
+                                               tokens.data(),
+                                               frame.childOffs.data());
+        } else {
+            off = frame.node->exportNode(mswr);
+        }
+        if (off == MEMSECTOR_OFF_NULL) return -1;
+
+        path.pop();
+        if (path.empty()) break;
+        path.top().childOffs.push_back(off);
+    }
+    mswr_set_root(mswr, off);
+
+    return 0;
 }
 
 }
@@ -35,6 +35,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include <utility>
 #include <vector>
 
+#include "common/utils/Arena.hpp"
 #include "common/utils/util.hpp"
 #include "mws/types/CmmlToken.hpp"
 #include "mws/types/MwsAnswset.hpp"
@@ -59,15 +60,26 @@ class MwsIndexNode {
     const unsigned long long id;
     /// Number of solutions associated with this node
     unsigned int solutions;
+    /// Arena holding the descendants of the root and their children maps
+    common::utils::Arena* arena;
+
+    /**
+      * @brief Constructor of non-root nodes, which live in the arena of the
+      * root and are never destructed
+      */
+    explicit MwsIndexNode(common::utils::Arena* arena);
+
+    MwsIndexNode(const MwsIndexNode&) = delete;
+    MwsIndexNode& operator=(const MwsIndexNode&) = delete;
 
 public:
     /**
-      * @brief Default constructor of the MwsIndexSubst class
+      * @brief Constructor of the root of an index
       */
     MwsIndexNode();
 
     /**
-      * @brief Destructor of the MwsIndexSubst class
+      * @brief Destructor of the root of an index, releasing all its nodes
       */
     ~MwsIndexNode();
 
@@ -78,16 +90,38 @@ public:
     MwsIndexNode*
     insertData(const std::vector<encoded_token_t>& encodedFormula);
 
-    uint64_t getMemsectorSize() const;
+    /**
+     * @param format format of the index
+     * @param offShift offsets are in units of 1 << offShift bytes
+     * @param subtreeCounts internal nodes are preceded by their counts
+     * @return size of the memsector holding this index, or its upper bound
+     * with INDEX_FORMAT_COMPACT
+     */
+    uint64_t getMemsectorSize(index_format_t format = INDEX_FORMAT_LATEST,
+                              uint32_t offShift = 0,
+                              bool subtreeCounts = false) const;
 
     /**
-     * @brief exportToMemsector dump index data to a memsector index
+     * @brief exportToMemsector dump index data to a memsector index, in a
+     * single iterative pass growing the memsector as needed
      * @param mswr memsector writer handle
+     * @return 0 on success and -1 on failure.
      */
-    void exportToMemsector(memsector_writer_t* mswr) const;
+    int exportToMemsector(memsector_writer_t* mswr) const;
 
  protected:
-    memsector_off_t exportToMemsector(memsector_alloc_header_t* alloc) const;
+    /**
+     * @brief allocate this node in the memsector, without its children
+     * @return offset of the node or MEMSECTOR_OFF_NULL on failure
+     */
+    memsector_off_t exportNode(memsector_writer_t* mswr) const;
+
+    /**
+     * @brief export children before their parents, as INDEX_FORMAT_COMPACT
+     * nodes are written once the offsets of their children are known
+     * @return 0 on success and -1 on failure.
+     */
+    int exportPostOrder(memsector_writer_t* mswr) const;
 
     friend struct mws::index::TmpIndexAccessor;
     friend class mws::index::IndexManager;
@@ -0,0 +1,113 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file SegmentDatabases.cpp
+  * @brief Crawl and formula databases of an index segment
+  * @date 18 Oct 2026
+  */
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+using std::shared_ptr;
+#include <stdexcept>
+using std::exception;
+#include <string>
+using std::string;
+
+#include "common/utils/compiler_defs.h"
+#include "mws/dbc/LevCrawlDb.hpp"
+#include "mws/dbc/LevFormulaDb.hpp"
+#include "mws/dbc/MmapCrawlDb.hpp"
+#include "mws/dbc/MmapFormulaDb.hpp"
+#include "mws/index/IndexSegments.hpp"
+#include "mws/index/SegmentDatabases.hpp"
+
+namespace mws { namespace index {
+
+SegmentDatabases::SegmentDatabases() : crawlDb(NULL),
+                                       formulaDb(NULL),
+                                       device(0),
+                                       inode(0),
+                                       isLevelDb(false) {
+}
+
+SegmentDatabases::~SegmentDatabases() {
+    delete crawlDb;
+    delete formulaDb;
+}
+
+shared_ptr<SegmentDatabases> openSegmentDatabases(
+        const string& path, const SegmentDatabasesList& opened) {
+    shared_ptr<SegmentDatabases> databases(new SegmentDatabases());
+    struct stat st;
+
+    // a LevelDB is locked under the path it is opened with
+    databases->path = getRealPath(path);
+    if (databases->path.empty() ||
+            stat(databases->path.c_str(), &st) != 0) {
+        PRINT_WARN("Cannot find segment %s\n", path.c_str());
+        return shared_ptr<SegmentDatabases>();
+    }
+    databases->device = st.st_dev;
+    databases->inode = st.st_ino;
+    databases->isLevelDb =
+            access((databases->path + "/crawl.dat").c_str(), F_OK) != 0;
+
+    if (databases->isLevelDb) {
+        for (const shared_ptr<SegmentDatabases>& other : opened) {
+            if (other != NULL && other->isLevelDb &&
+                    other->path == databases->path &&
+                    other->device == databases->device &&
+                    other->inode == databases->inode) {
+                return other;
+            }
+        }
+    }
+
+    try {
+        if (databases->isLevelDb) {
+            dbc::LevCrawlDb* crawlDb = new dbc::LevCrawlDb();
+            databases->crawlDb = crawlDb;
+            crawlDb->open((databases->path + "/crawl.db").c_str());
+            dbc::LevFormulaDb* formulaDb = new dbc::LevFormulaDb();
+            databases->formulaDb = formulaDb;
+            formulaDb->open((databases->path + "/formula.db").c_str());
+        } else {
+            dbc::MmapCrawlDb* crawlDb = new dbc::MmapCrawlDb();
+            databases->crawlDb = crawlDb;
+            crawlDb->open((databases->path + "/crawl.dat").c_str());
+            dbc::MmapFormulaDb* formulaDb = new dbc::MmapFormulaDb();
+            databases->formulaDb = formulaDb;
+            formulaDb->open((databases->path + "/formula.dat").c_str());
+        }
+    } catch (const exception& e) {
+        PRINT_WARN("Initializing database of %s: %s\n", path.c_str(),
+                   e.what());
+        return shared_ptr<SegmentDatabases>();
+    }
+
+    return databases;
+}
+
+}  // namespace index
+}  // namespace mws
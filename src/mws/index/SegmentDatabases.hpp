@@ -0,0 +1,81 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_INDEX_SEGMENTDATABASES_HPP
+#define _MWS_INDEX_SEGMENTDATABASES_HPP
+
+/**
+  * @file SegmentDatabases.hpp
+  * @brief Crawl and formula databases of an index segment
+  * @date 18 Oct 2026
+  *
+  * A LevelDB database is locked by the process which opens it, under the
+  * path it was opened with, so it cannot be opened again while open. The
+  * databases of a segment are therefore shared by everything reading the
+  * segment in a process: the generations of an index loaded by the daemon
+  * and its compaction.
+  */
+
+#include <sys/types.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mws/dbc/CrawlDb.hpp"
+#include "mws/dbc/FormulaDb.hpp"
+
+namespace mws { namespace index {
+
+struct SegmentDatabases {
+    dbc::CrawlDb* crawlDb;
+    dbc::FormulaDb* formulaDb;
+    /// Segment directory, with symbolic links resolved
+    std::string path;
+    /// Identify the directory, which may be replaced under the same path
+    dev_t device;
+    ino_t inode;
+    /// false for the memory mapped databases of mws-index --mmap-databases
+    bool isLevelDb;
+
+    SegmentDatabases();
+    ~SegmentDatabases();
+ private:
+    SegmentDatabases(const SegmentDatabases&);
+    SegmentDatabases& operator=(const SegmentDatabases&);
+};
+
+typedef std::vector<std::shared_ptr<SegmentDatabases> > SegmentDatabasesList;
+
+/**
+ * @brief open the databases of a segment directory, memory mapped ones if
+ * it has crawl.dat, LevelDB ones otherwise. LevelDB databases of the same
+ * directory found in opened are shared instead of opened again.
+ * @param path segment directory
+ * @param opened databases already opened by the caller
+ * @return databases of the segment, or NULL on failure
+ */
+std::shared_ptr<SegmentDatabases> openSegmentDatabases(
+        const std::string& path, const SegmentDatabasesList& opened);
+
+}  // namespace index
+}  // namespace mws
+
+#endif  // _MWS_INDEX_SEGMENTDATABASES_HPP
@@ -27,6 +27,8 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   * @date   17 Apr 2014
   */
 
+#include <stack>
+
 #include "common/utils/compiler_defs.h"
 #include "mws/index/MwsIndexNode.hpp"
 #include "mws/types/FormulaPath.hpp"
@@ -43,11 +45,13 @@ struct TmpIndexAccessor {
         return index;
     }
 
-    static Iterator getChildrenBegin(Node* node) {
+    static Iterator getChildrenBegin(Index* index, Node* node) {
+        UNUSED(index);
         return node->children.begin();
     }
 
-    static Iterator getChildrenEnd(Node* node) {
+    static Iterator getChildrenEnd(Index* index, Node* node) {
+        UNUSED(index);
         return node->children.end();
     }
 
@@ -81,6 +85,31 @@ struct TmpIndexAccessor {
     static uint64_t getHitsCount(Node* node) {
         return node->solutions;
     }
+
+    static bool hasSubtreeCounts(Index* index) {
+        UNUSED(index);
+        return false;
+    }
+
+    /**
+     * @return hits of the leaves below a node, by visiting them
+     */
+    static uint64_t getSubtreeHitsCount(Node* node) {
+        std::stack<Node*> nodes;
+        uint64_t hits = 0;
+
+        nodes.push(node);
+        while (!nodes.empty()) {
+            Node* curr = nodes.top();
+            nodes.pop();
+            hits += curr->solutions;
+            for (auto& kv : curr->children) {
+                nodes.push(kv.second);
+            }
+        }
+
+        return hits;
+    }
 };
 
 }  // namespace index
@@ -0,0 +1,279 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @brief   Child lookup in blocked index nodes
+ * @file    index.c
+ * @date    17 Oct 2026
+ *
+ * License: GPLv3
+ */
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   define INODE_SEARCH_X86
+#   include <immintrin.h>
+#endif
+
+#include "common/utils/compiler_defs.h"
+#include "mws/index/index.h"
+
+/*--------------------------------------------------------------------------*/
+/* Local methods                                                            */
+/*--------------------------------------------------------------------------*/
+
+typedef uint32_t (*block_rank_t)(const inode_key_t* keys, uint32_t size,
+                                 inode_key_t key);
+
+/**
+ * @return number of keys smaller than key among the first size keys
+ */
+static inline
+uint32_t block_rank_scalar(const inode_key_t* keys, uint32_t size,
+                           inode_key_t key) {
+    uint32_t rank = 0;
+    uint32_t i;
+
+    for (i = 0; i < size; i++) {
+        rank += (keys[i] < key);
+    }
+
+    return rank;
+}
+
+#ifdef INODE_SEARCH_X86
+/*
+ * SSE2 and AVX2 only compare signed integers: keys are compared with their
+ * sign bit flipped. Lanes of smaller keys compare to -1, which is subtracted
+ * from the rank.
+ */
+
+static inline TARGET("sse2")
+uint32_t block_rank_sse2(const inode_key_t* keys, uint32_t size,
+                         inode_key_t key) {
+    const __m128i sign = _mm_set1_epi32(INT32_MIN);
+    const __m128i target = _mm_set1_epi32(key ^ INT32_MIN);
+    __m128i ranks = _mm_setzero_si128();
+    uint32_t i;
+
+    for (i = 0; i + 4 <= size; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i*) (keys + i));
+        block = _mm_xor_si128(block, sign);
+        ranks = _mm_sub_epi32(ranks, _mm_cmplt_epi32(block, target));
+    }
+    ranks = _mm_add_epi32(ranks, _mm_shuffle_epi32(ranks, 0x4E));
+    ranks = _mm_add_epi32(ranks, _mm_shuffle_epi32(ranks, 0xB1));
+
+    return _mm_cvtsi128_si32(ranks) +
+            block_rank_scalar(keys + i, size - i, key);
+}
+
+static inline TARGET("avx2")
+uint32_t block_rank_avx2(const inode_key_t* keys, uint32_t size,
+                         inode_key_t key) {
+    const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+    const __m256i target = _mm256_set1_epi32(key ^ INT32_MIN);
+    __m256i ranks = _mm256_setzero_si256();
+    __m128i ranks128;
+    uint32_t i;
+
+    // a handful of keys is faster to compare than to gather in a register
+    if (size < 8) return block_rank_scalar(keys, size, key);
+
+    for (i = 0; i + 8 <= size; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i*) (keys + i));
+        block = _mm256_xor_si256(block, sign);
+        ranks = _mm256_sub_epi32(ranks, _mm256_cmpgt_epi32(target, block));
+    }
+    if (i < size) {
+        // masked lanes are neither read nor counted
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(size - i), lanes);
+        __m256i block = _mm256_maskload_epi32((const int*) (keys + i), mask);
+        block = _mm256_xor_si256(block, sign);
+        ranks = _mm256_sub_epi32(ranks, _mm256_and_si256(
+                _mm256_cmpgt_epi32(target, block), mask));
+    }
+    ranks128 = _mm_add_epi32(_mm256_castsi256_si128(ranks),
+                             _mm256_extracti128_si256(ranks, 1));
+    ranks128 = _mm_add_epi32(ranks128, _mm_shuffle_epi32(ranks128, 0x4E));
+    ranks128 = _mm_add_epi32(ranks128, _mm_shuffle_epi32(ranks128, 0xB1));
+
+    return _mm_cvtsi128_si32(ranks128);
+}
+#endif  // INODE_SEARCH_X86
+
+/**
+ * Lookup shared by all instruction sets, inlined in each of them with its
+ * block_rank.
+ */
+static inline ALWAYS_INLINE
+memsector_off_t blocked_get_child(const inode_t* inode, encoded_token_t token,
+                                  block_rank_t block_rank) {
+    const inode_key_t key = encoded_token_key(token);
+    const inode_key_t* keys = inode_keys(inode);
+    const uint32_t size = inode->size;
+    uint32_t pos;
+
+    if (size <= INODE_BLOCK_KEYS) {
+        pos = block_rank(keys, size, key);
+    } else {
+        // B-tree levels are stored bottom up: locate them first
+        uint32_t level_start[8];
+        uint32_t level_size[8];
+        uint32_t num_levels = 0;
+        uint32_t start = 0;
+        uint32_t curr_size = size;
+        while (true) {
+            uint32_t num_blocks =
+                    (curr_size + INODE_BLOCK_KEYS - 1) / INODE_BLOCK_KEYS;
+            level_start[num_levels] = start;
+            level_size[num_levels] = curr_size;
+            num_levels++;
+            if (num_blocks == 1) break;
+            start += num_blocks * INODE_BLOCK_KEYS;
+            curr_size = num_blocks;
+        }
+
+        // descend from the root block, one cache line per level
+        pos = 0;
+        while (num_levels > 0) {
+            num_levels--;
+            pos = pos * INODE_BLOCK_KEYS +
+                    block_rank(keys + level_start[num_levels] +
+                               pos * INODE_BLOCK_KEYS,
+                               INODE_BLOCK_KEYS, key);
+            if (pos >= level_size[num_levels]) return MEMSECTOR_OFF_NULL;
+        }
+    }
+
+    if (pos < size && keys[pos] == key) {
+        return inode_offs(inode)[pos];
+    }
+
+    return MEMSECTOR_OFF_NULL;
+}
+
+static
+memsector_off_t blocked_get_child_scalar(const inode_t* inode,
+                                         encoded_token_t token) {
+    return blocked_get_child(inode, token, block_rank_scalar);
+}
+
+#ifdef INODE_SEARCH_X86
+static TARGET("sse2")
+memsector_off_t blocked_get_child_sse2(const inode_t* inode,
+                                       encoded_token_t token) {
+    return blocked_get_child(inode, token, block_rank_sse2);
+}
+
+static TARGET("avx2")
+memsector_off_t blocked_get_child_avx2(const inode_t* inode,
+                                       encoded_token_t token) {
+    return blocked_get_child(inode, token, block_rank_avx2);
+}
+#endif  // INODE_SEARCH_X86
+
+static inode_search_isa_t inode_search_isa = INODE_SEARCH_SCALAR;
+
+/**
+ * @brief select the widest instruction set of the CPU when loaded
+ */
+static void __attribute__ ((__constructor__))
+inode_search_init(void) {
+    if (inode_search_set_isa(INODE_SEARCH_AVX2) != 0 &&
+            inode_search_set_isa(INODE_SEARCH_SSE2) != 0) {
+        inode_search_set_isa(INODE_SEARCH_SCALAR);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* Implementation                                                           */
+/*--------------------------------------------------------------------------*/
+
+memsector_off_t (*inode_blocked_get_child)(const inode_t* inode,
+                                           encoded_token_t token) =
+        blocked_get_child_scalar;
+
+int inode_search_set_isa(inode_search_isa_t isa) {
+    switch (isa) {
+    case INODE_SEARCH_SCALAR:
+        inode_blocked_get_child = blocked_get_child_scalar;
+        break;
+#ifdef INODE_SEARCH_X86
+    case INODE_SEARCH_SSE2:
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("sse2")) return -1;
+        inode_blocked_get_child = blocked_get_child_sse2;
+        break;
+    case INODE_SEARCH_AVX2:
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2")) return -1;
+        inode_blocked_get_child = blocked_get_child_avx2;
+        break;
+#endif  // INODE_SEARCH_X86
+    default:
+        return -1;
+    }
+    inode_search_isa = isa;
+
+    return 0;
+}
+
+inode_search_isa_t inode_search_get_isa(void) {
+    return inode_search_isa;
+}
+
+static uint64_t inode_warm_up(const index_handle_t* index,
+                              const inode_t* inode, uint32_t depth,
+                              uint32_t* checksum) {
+    uint64_t num_nodes = 1;
+    uint32_t i;
+
+    *checksum += inode->type;
+    if (inode->type != INTERNAL_NODE) return num_nodes;
+
+    // tokens and offsets are read by the searches of the children
+    for (i = 0; i < inode->size; i++) {
+        encoded_token_t token = inode_get_token(inode, index->format, i);
+        memsector_off_t off = inode_get_off(index, inode, i);
+        *checksum += encoded_token_key(token);
+        if (depth > 0) {
+            const inode_t* child = (const inode_t*)
+                    memsector_off2addr(index->alloc, index->off_shift, off);
+            num_nodes += inode_warm_up(index, child, depth - 1, checksum);
+        }
+    }
+
+    return num_nodes;
+}
+
+uint64_t index_warm_up(const index_handle_t* index, uint32_t depth) {
+    // the reads must not be optimized away
+    volatile uint32_t sink;
+    uint32_t checksum = 0;
+    uint64_t num_nodes = inode_warm_up(index, index->root, depth, &checksum);
+
+    sink = checksum;
+    UNUSED(sink);
+
+    return num_nodes;
+}
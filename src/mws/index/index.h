@@ -40,10 +40,55 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include "mws/index/encoded_token.h"
 #include "mws/index/memsector_allocator.h"
 
+/*--------------------------------------------------------------------------*/
+/* Constants                                                                */
+/*--------------------------------------------------------------------------*/
+
+/// Number of keys in a block of a blocked inode, filling a cache line
+#define INODE_BLOCK_KEYS        16
+/// Alignment of the keys of wide blocked inodes
+#define INODE_BLOCK_ALIGNMENT   64
+/// Key used to pad the blocks of blocked inodes
+#define INODE_KEY_PADDING       UINT32_MAX
+
 /*--------------------------------------------------------------------------*/
 /* Type declarations                                                        */
 /*--------------------------------------------------------------------------*/
 
+/**
+ * @brief Layouts of internal index nodes
+ */
+typedef enum index_format_e {
+    /// Sorted (token, offset) pairs, searched with memcmp
+    INDEX_FORMAT_SORTED_PAIRS   = 1,
+    /// Sorted integer keys apart from offsets. The keys of nodes with more
+    /// than INODE_BLOCK_KEYS children are searched through a static B-tree
+    /// of cache line sized blocks, which holds the largest key of each block
+    /// of the level below.
+    INDEX_FORMAT_BLOCKED_KEYS   = 2,
+    /// Children written before their parent. Keys are stored as differences
+    /// to the first key and offsets as distances back from the node, both
+    /// with the fewest bytes that fit all children of the node.
+    INDEX_FORMAT_COMPACT        = 3
+} index_format_t;
+
+/// Format of newly written indexes
+#define INDEX_FORMAT_LATEST     INDEX_FORMAT_BLOCKED_KEYS
+
+/**
+ * @brief Encoded token as an integer ordered like the memcmp of the token
+ */
+typedef uint32_t inode_key_t;
+
+/**
+ * @brief Instruction sets of the lookup in INDEX_FORMAT_BLOCKED_KEYS inodes
+ */
+typedef enum inode_search_isa_e {
+    INODE_SEARCH_SCALAR,
+    INODE_SEARCH_SSE2,
+    INODE_SEARCH_AVX2
+} inode_search_isa_t;
+
 /**
  * @brief Index node types
  */
@@ -54,6 +99,14 @@ typedef enum node_type_e {
 
 /**
  * @brief Internal index node
+ *
+ * With INDEX_FORMAT_SORTED_PAIRS, data holds the sorted children. With
+ * INDEX_FORMAT_BLOCKED_KEYS, data is followed by the sorted keys of the
+ * children, the upper levels of their B-tree (if any) and their offsets.
+ * With INDEX_FORMAT_COMPACT, data is followed by a byte holding the widths
+ * of the key differences and offset distances, the first key (big endian),
+ * the key differences of the other children and the offset distances of all
+ * children.
  */
 struct inode_s {
     node_type_t type    : 2;  /* should be INTERNAL_NODE */
@@ -62,6 +115,15 @@ struct inode_s {
 } PACKED;
 typedef struct inode_s inode_t;
 
+/**
+ * @brief Hits in the subtree of an internal node, saturated to UINT32_MAX.
+ * Stored right before the node in indexes with subtree counts.
+ */
+struct inode_counts_s {
+    uint32_t num_hits;
+} PACKED;
+typedef struct inode_counts_s inode_counts_t;
+
 /**
  * @brief Leaf index node
  */
@@ -83,6 +145,11 @@ typedef struct index_header_s index_header_t;
 typedef struct index_handle_s {
     inode_t *root;
     memsector_alloc_header_t *alloc;
+    index_format_t format;
+    /// offsets are in units of 1 << off_shift bytes
+    uint32_t off_shift;
+    /// inodes are preceded by their inode_counts_t
+    bool subtree_counts;
 } index_handle_t;
 
 /*--------------------------------------------------------------------------*/
@@ -91,9 +158,219 @@ typedef struct index_handle_s {
 
 BEGIN_DECLS
 
+/**
+ * @brief lookup of a child of an INDEX_FORMAT_BLOCKED_KEYS inode, with the
+ * widest instruction set supported by the CPU (selected on startup)
+ * @return offset of the child or MEMSECTOR_OFF_NULL if there is none
+ */
+extern memsector_off_t (*inode_blocked_get_child)(const inode_t* inode,
+                                                  encoded_token_t token);
+
+/**
+ * @brief select the instruction set used by inode_blocked_get_child
+ * @return 0 on success, -1 if the CPU does not support it
+ */
+int inode_search_set_isa(inode_search_isa_t isa);
+
+/**
+ * @return instruction set used by inode_blocked_get_child
+ */
+inode_search_isa_t inode_search_get_isa(void);
+
+/**
+ * @brief read the nodes of the first levels of an index, so that the pages
+ * searched by every query are resident before the first one arrives
+ * @param depth number of levels below the root to read
+ * @return number of nodes read
+ */
+uint64_t index_warm_up(const index_handle_t* index, uint32_t depth);
+
+static inline
+inode_key_t encoded_token_key(encoded_token_t token) {
+    const uint8_t* bytes = (const uint8_t*) &token;
+
+    return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) |
+           ((uint32_t) bytes[2] << 8) | (uint32_t) bytes[3];
+}
+
+static inline
+encoded_token_t inode_key_token(inode_key_t key) {
+    uint8_t bytes[sizeof(encoded_token_t)];
+    encoded_token_t token;
+
+    bytes[0] = key >> 24;
+    bytes[1] = key >> 16;
+    bytes[2] = key >> 8;
+    bytes[3] = key;
+    memcpy(&token, bytes, sizeof(token));
+
+    return token;
+}
+
+/**
+ * @return number of key slots of a blocked inode, over all its B-tree levels
+ */
+static inline
+uint32_t inode_num_key_slots(uint32_t num_children) {
+    uint32_t level_size = num_children;
+    uint32_t num_slots = 0;
+
+    if (num_children <= INODE_BLOCK_KEYS) return num_children;
+    while (true) {
+        uint32_t num_blocks =
+                (level_size + INODE_BLOCK_KEYS - 1) / INODE_BLOCK_KEYS;
+        num_slots += num_blocks * INODE_BLOCK_KEYS;
+        if (num_blocks == 1) break;
+        level_size = num_blocks;
+    }
+
+    return num_slots;
+}
+
+/**
+ * @return keys of a blocked inode, aligned to INODE_BLOCK_ALIGNMENT if the
+ * inode is wide
+ */
+static inline
+inode_key_t* inode_keys(const inode_t* inode) {
+    uintptr_t keys = (uintptr_t) inode->data;
+
+    if (inode->size > INODE_BLOCK_KEYS) {
+        keys = (keys + INODE_BLOCK_ALIGNMENT - 1) &
+                ~(uintptr_t) (INODE_BLOCK_ALIGNMENT - 1);
+    }
+
+    return (inode_key_t*) keys;
+}
+
+/**
+ * @return number of bytes storing value in INDEX_FORMAT_COMPACT inodes
+ */
+static inline
+uint32_t inode_compact_width(uint32_t value) {
+    uint32_t width = 1;
+
+    while (width < sizeof(uint32_t) && (value >> (8 * width)) != 0) width++;
+
+    return width;
+}
+
+static inline
+uint32_t inode_compact_read(const uint8_t* bytes, uint32_t width) {
+    uint32_t value = 0;
+    uint32_t i;
+
+    for (i = 0; i < width; i++) value = (value << 8) | bytes[i];
+
+    return value;
+}
+
 static inline
-uint32_t inode_size(uint32_t num_children) {
-    return sizeof(inode_t) + num_children * sizeof(encoded_token_dict_entry_t);
+void inode_compact_write(uint8_t* bytes, uint32_t width, uint32_t value) {
+    while (width > 0) {
+        bytes[--width] = value;
+        value >>= 8;
+    }
+}
+
+static inline
+uint32_t inode_compact_key_width(const inode_t* inode) {
+    return (((const uint8_t*) inode->data)[0] & 3) + 1;
+}
+
+static inline
+uint32_t inode_compact_off_width(const inode_t* inode) {
+    return ((((const uint8_t*) inode->data)[0] >> 2) & 3) + 1;
+}
+
+static inline
+inode_key_t inode_compact_key(const inode_t* inode, uint32_t i) {
+    const uint8_t* first_key = (const uint8_t*) inode->data + 1;
+    uint32_t key_width = inode_compact_key_width(inode);
+
+    if (i == 0) return inode_compact_read(first_key, sizeof(inode_key_t));
+    return inode_compact_read(first_key, sizeof(inode_key_t)) +
+            inode_compact_read(first_key + sizeof(inode_key_t) +
+                               (i - 1) * key_width, key_width);
+}
+
+/**
+ * @return distance from the child i back to the inode, in offset units
+ */
+static inline
+uint32_t inode_compact_dist(const inode_t* inode, uint32_t i) {
+    uint32_t key_width = inode_compact_key_width(inode);
+    uint32_t off_width = inode_compact_off_width(inode);
+    const uint8_t* dists = (const uint8_t*) inode->data + 1 +
+            sizeof(inode_key_t) + (inode->size - 1) * key_width;
+
+    return inode_compact_read(dists + i * off_width, off_width);
+}
+
+static inline
+uint32_t inode_compact_size(uint32_t num_children, uint32_t key_width,
+                            uint32_t off_width) {
+    return sizeof(inode_t) + 1 + sizeof(inode_key_t) +
+            (num_children - 1) * key_width + num_children * off_width;
+}
+
+/**
+ * @brief write an INDEX_FORMAT_COMPACT inode of num_children > 0 children
+ * @param inode_off offset of the inode, after the offsets of its children
+ * @param key_width bytes of key differences, as from inode_compact_width()
+ * @param off_width bytes of offset distances
+ */
+static inline
+void inode_compact_init(inode_t* inode, memsector_off_t inode_off,
+                        uint32_t num_children, const encoded_token_t* tokens,
+                        const memsector_off_t* offs,
+                        uint32_t key_width, uint32_t off_width) {
+    uint8_t* bytes = (uint8_t*) inode->data;
+    inode_key_t first_key = encoded_token_key(tokens[0]);
+    uint32_t i;
+
+    inode->type = INTERNAL_NODE;
+    inode->size = num_children;
+    *bytes++ = (key_width - 1) | ((off_width - 1) << 2);
+    inode_compact_write(bytes, sizeof(inode_key_t), first_key);
+    bytes += sizeof(inode_key_t);
+    for (i = 1; i < num_children; i++) {
+        inode_compact_write(bytes, key_width,
+                            encoded_token_key(tokens[i]) - first_key);
+        bytes += key_width;
+    }
+    for (i = 0; i < num_children; i++) {
+        assert(offs[i] < inode_off);
+        inode_compact_write(bytes, off_width, inode_off - offs[i]);
+        bytes += off_width;
+    }
+}
+
+static inline
+memsector_off_t* inode_offs(const inode_t* inode) {
+    return (memsector_off_t*)
+            (inode_keys(inode) + inode_num_key_slots(inode->size));
+}
+
+/**
+ * @return size of an inode, or its upper bound with INDEX_FORMAT_COMPACT
+ */
+static inline
+uint32_t inode_size(index_format_t format, uint32_t num_children) {
+    if (format == INDEX_FORMAT_SORTED_PAIRS) {
+        return sizeof(inode_t) +
+                num_children * sizeof(encoded_token_dict_entry_t);
+    } else if (format == INDEX_FORMAT_COMPACT) {
+        return inode_compact_size(num_children, sizeof(inode_key_t),
+                                  sizeof(memsector_off_t));
+    } else {
+        // wide inodes hold the padding which aligns their keys
+        uint32_t padding = (num_children > INODE_BLOCK_KEYS) ?
+                INODE_BLOCK_ALIGNMENT - sizeof(inode_t) : 0;
+        return sizeof(inode_t) + padding +
+                inode_num_key_slots(num_children) * sizeof(inode_key_t) +
+                num_children * sizeof(memsector_off_t);
+    }
 }
 
 static inline
@@ -101,21 +378,132 @@ uint32_t leaf_size(void) {
     return sizeof(leaf_t);
 }
 
+/**
+ * @return counts of the subtree of an inode of an index with subtree counts
+ */
 static inline
-memsector_off_t inode_alloc(memsector_alloc_header_t* alloc,
-                            uint32_t num_children) {
-    return memsector_alloc(alloc, inode_size(num_children));
+inode_counts_t* inode_get_counts(const inode_t* inode) {
+    return (inode_counts_t*) inode - 1;
 }
 
 static inline
-memsector_off_t leaf_alloc(memsector_alloc_header_t* alloc) {
-    return memsector_alloc(alloc, leaf_size());
+encoded_token_t inode_get_token(const inode_t* inode, index_format_t format,
+                                uint32_t i) {
+    if (format == INDEX_FORMAT_SORTED_PAIRS) {
+        return inode->data[i].token;
+    } else if (format == INDEX_FORMAT_COMPACT) {
+        return inode_key_token(inode_compact_key(inode, i));
+    } else {
+        return inode_key_token(inode_keys(inode)[i]);
+    }
 }
 
+/**
+ * @param index index holding the inode
+ */
 static inline
-memsector_off_t inode_get_child(const inode_t* inode, encoded_token_t token) {
+memsector_off_t inode_get_off(const index_handle_t* index,
+                              const inode_t* inode, uint32_t i) {
+    if (index->format == INDEX_FORMAT_SORTED_PAIRS) {
+        return inode->data[i].off;
+    } else if (index->format == INDEX_FORMAT_COMPACT) {
+        return memsector_addr2off(index->alloc, index->off_shift, inode) -
+                inode_compact_dist(inode, i);
+    } else {
+        return inode_offs(inode)[i];
+    }
+}
+
+static inline
+void inode_set_token(inode_t* inode, index_format_t format,
+                     uint32_t i, encoded_token_t token) {
+    assert(format != INDEX_FORMAT_COMPACT);
+    if (format == INDEX_FORMAT_SORTED_PAIRS) {
+        inode->data[i].token = token;
+    } else {
+        inode_keys(inode)[i] = encoded_token_key(token);
+    }
+}
+
+static inline
+void inode_set_off(inode_t* inode, index_format_t format,
+                   uint32_t i, memsector_off_t off) {
+    assert(format != INDEX_FORMAT_COMPACT);
+    if (format == INDEX_FORMAT_SORTED_PAIRS) {
+        inode->data[i].off = off;
+    } else {
+        inode_offs(inode)[i] = off;
+    }
+}
+
+/**
+ * @brief build the search structure of an inode once all its tokens are set.
+ * INDEX_FORMAT_COMPACT inodes are written at once with inode_compact_init().
+ */
+static inline
+void inode_build_index(inode_t* inode, index_format_t format) {
+    inode_key_t* level = inode_keys(inode);
+    uint32_t level_size = inode->size;
+
+    if (format != INDEX_FORMAT_BLOCKED_KEYS) return;
+    if (level_size <= INODE_BLOCK_KEYS) return;
+    while (true) {
+        uint32_t num_blocks =
+                (level_size + INODE_BLOCK_KEYS - 1) / INODE_BLOCK_KEYS;
+        inode_key_t* next_level = level + num_blocks * INODE_BLOCK_KEYS;
+        uint32_t i;
+
+        for (i = level_size; i < num_blocks * INODE_BLOCK_KEYS; i++) {
+            level[i] = INODE_KEY_PADDING;
+        }
+        if (num_blocks == 1) break;
+        for (i = 0; i < num_blocks; i++) {
+            uint32_t last = (i + 1) * INODE_BLOCK_KEYS - 1;
+            next_level[i] = level[last < level_size ? last : level_size - 1];
+        }
+        level = next_level;
+        level_size = num_blocks;
+    }
+}
+
+static inline
+memsector_off_t inode_compact_get_child(const index_handle_t* index,
+                                        const inode_t* inode,
+                                        encoded_token_t token) {
+    inode_key_t key = encoded_token_key(token);
+    int32_t left = 0;
+    int32_t right = inode->size - 1;
+
+    while (left <= right) {
+        int32_t center = left + (right - left) / 2;
+        inode_key_t center_key = inode_compact_key(inode, center);
+        if (center_key > key) {
+            right = center - 1;
+        } else if (center_key == key) {
+            return inode_get_off(index, inode, center);
+        } else {
+            left = center + 1;
+        }
+    }
+
+    return MEMSECTOR_OFF_NULL;
+}
+
+/**
+ * @param index index holding the inode
+ */
+static inline
+memsector_off_t inode_get_child(const index_handle_t* index,
+                                const inode_t* inode,
+                                encoded_token_t token) {
     int32_t left, right;
 
+    if (index->format == INDEX_FORMAT_BLOCKED_KEYS) {
+        return inode_blocked_get_child(inode, token);
+    } else if (index->format == INDEX_FORMAT_COMPACT) {
+        return inode_compact_get_child(index, inode, token);
+    }
+
     left = 0;
     right = inode->size - 1;
 
@@ -135,18 +523,20 @@ memsector_off_t inode_get_child(const inode_t* inode, encoded_token_t token) {
 }
 
 static inline
-uint32_t inode_get_max_var(const inode_t* inode) {
+uint32_t inode_get_max_var(const inode_t* inode, index_format_t format) {
     uint32_t i = 0;
-    while (inode->data[i].token.id <= VAR_ID_MAX) i++;
+    while (i < inode->size &&
+           inode_get_token(inode, format, i).id <= VAR_ID_MAX) i++;
 
     return i;
 }
 
 static inline
-memsector_off_t inode_get_qvar(const inode_t* inode, uint32_t qvar_id) {
-    assert(inode->data[qvar_id].token.id == qvar_id);
+memsector_off_t inode_get_qvar(const index_handle_t* index,
+                               const inode_t* inode, uint32_t qvar_id) {
+    assert(inode_get_token(inode, index->format, qvar_id).id == qvar_id);
 
-    return inode->data[qvar_id].off;
+    return inode_get_off(index, inode, qvar_id);
 }
 
 END_DECLS
@@ -26,8 +26,13 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
  * License: GPLv3
  */
 
+#ifdef __linux__
+#define _GNU_SOURCE             // MAP_POPULATE
+#endif  // __linux__
+#include <errno.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include "common/utils/mmap.h"
 #include "mws/index/memsector.h"
@@ -39,9 +44,33 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 int memsector_create(memsector_writer_t *msw,
                      const char *path,
                      uint32_t size) {
-    size_t real_size = sizeof(memsector_header_t) + size;
+    return memsector_create_format(msw, path, size, INDEX_FORMAT_LATEST,
+                                   /* off_shift = */ 0);
+}
+
+int memsector_create_format(memsector_writer_t *msw,
+                            const char *path,
+                            uint32_t size,
+                            index_format_t format,
+                            uint32_t off_shift) {
+    return memsector_create_flags(msw, path, size, format, off_shift,
+                                  /* flags = */ 0);
+}
+
+int memsector_create_flags(memsector_writer_t *msw,
+                           const char *path,
+                           uint32_t size,
+                           index_format_t format,
+                           uint32_t off_shift,
+                           uint32_t flags) {
+    uint64_t real_size = sizeof(memsector_header_t) + size;
     int status;
 
+    if (off_shift > MEMSECTOR_MAX_OFF_SHIFT) return -1;
+    if (real_size > MEMSECTOR_MAX_SIZE(off_shift)) {
+        real_size = MEMSECTOR_MAX_SIZE(off_shift);
+    }
+
     /* create and mmap memsector file */
     status = mmap_create(path, real_size,
                          MAP_SHARED,
@@ -50,9 +79,16 @@ int memsector_create(memsector_writer_t *msw,
 
     /* initialize header */
     memsector_header_t ms;
-    ms.alloc_header.curr_offset = sizeof(memsector_header_t);
-    ms.alloc_header.end_offset = real_size;
+    memset(&ms, 0, sizeof(ms));
+    ms.alloc_header.curr_offset =
+            memsector_units(off_shift, sizeof(memsector_header_t));
+    ms.alloc_header.end_offset = msw->mmap_handle.size >> off_shift;
     ms.index_header_off = memsector_alloc_get_curr_off(&ms.alloc_header);
+    ms.signature = (flags != 0) ? MEMSECTOR_SIGNATURE :
+                                  MEMSECTOR_SIGNATURE_NO_FLAGS;
+    ms.index_format = format;
+    ms.off_shift = off_shift;
+    ms.flags = flags;
 
     /* copy header to memsector file */
     memcpy(msw->mmap_handle.start_addr, &ms, sizeof(memsector_header_t));
@@ -61,25 +97,246 @@ int memsector_create(memsector_writer_t *msw,
     return 0;
 }
 
+memsector_off_t memsector_writer_alloc(memsector_writer_t *msw,
+                                       uint32_t nbytes) {
+    memsector_alloc_header_t* alloc = mswr_get_alloc(msw);
+    const uint32_t off_shift = mswr_get_off_shift(msw);
+    const uint32_t nunits = memsector_units(off_shift, nbytes);
+
+    if (alloc->end_offset - alloc->curr_offset < nunits) {
+        /* double the file, to allocate in amortized constant time */
+        uint64_t needed = (uint64_t) (alloc->curr_offset + nunits) << off_shift;
+        uint64_t size = 2 * msw->mmap_handle.size;
+        if (size < needed) {
+            size = needed;
+        }
+        if (size > MEMSECTOR_MAX_SIZE(off_shift)) {
+            size = MEMSECTOR_MAX_SIZE(off_shift);
+        }
+        if (size < needed) return MEMSECTOR_OFF_NULL;
+
+        if (mmap_resize(&msw->mmap_handle, size, MAP_SHARED) != 0) {
+            return MEMSECTOR_OFF_NULL;
+        }
+        msw->ms_header = (memsector_header_t*) msw->mmap_handle.start_addr;
+        alloc = mswr_get_alloc(msw);
+        alloc->end_offset = msw->mmap_handle.size >> off_shift;
+    }
+
+    return memsector_alloc(alloc, off_shift, nbytes);
+}
+
+/**
+ * @return offset of the next internal node allocated
+ */
+static memsector_off_t inode_next_off(memsector_writer_t *msw) {
+    memsector_off_t off = memsector_alloc_get_curr_off(mswr_get_alloc(msw));
+
+    if (mswr_has_subtree_counts(msw)) {
+        off += memsector_units(mswr_get_off_shift(msw),
+                               sizeof(inode_counts_t));
+    }
+
+    return off;
+}
+
+/**
+ * Allocate an internal node, after its subtree counts if the memsector has
+ * them. These end right before the node, whatever the unit of offsets.
+ * @return offset of the node, MEMSECTOR_OFF_NULL on failure.
+ */
+static memsector_off_t inode_alloc(memsector_writer_t *msw, uint32_t nbytes) {
+    if (mswr_has_subtree_counts(msw) &&
+            memsector_writer_alloc(msw, sizeof(inode_counts_t)) ==
+            MEMSECTOR_OFF_NULL) {
+        return MEMSECTOR_OFF_NULL;
+    }
+
+    return memsector_writer_alloc(msw, nbytes);
+}
+
+memsector_off_t memsector_writer_alloc_inode(memsector_writer_t *msw,
+                                             uint32_t num_children) {
+    index_format_t format = mswr_get_format(msw);
+    memsector_off_t off;
+    inode_t* inode;
+
+    assert(format != INDEX_FORMAT_COMPACT);
+    off = inode_alloc(msw, inode_size(format, num_children));
+    if (off == MEMSECTOR_OFF_NULL) return off;
+
+    inode = (inode_t*) mswr_off2addr(msw, off);
+    inode->type = INTERNAL_NODE;
+    inode->size = num_children;
+
+    return off;
+}
+
+memsector_off_t memsector_writer_write_inode(memsector_writer_t *msw,
+                                             uint32_t num_children,
+                                             const encoded_token_t* tokens,
+                                             const memsector_off_t* offs) {
+    index_format_t format = mswr_get_format(msw);
+    memsector_off_t off;
+    memsector_off_t min_off;
+    uint32_t key_width, off_width;
+    uint32_t i;
+
+    if (format != INDEX_FORMAT_COMPACT) {
+        off = memsector_writer_alloc_inode(msw, num_children);
+        if (off == MEMSECTOR_OFF_NULL) return off;
+
+        inode_t* inode = (inode_t*) mswr_off2addr(msw, off);
+        for (i = 0; i < num_children; i++) {
+            inode_set_token(inode, format, i, tokens[i]);
+            inode_set_off(inode, format, i, offs[i]);
+        }
+        inode_build_index(inode, format);
+        memsector_writer_set_subtree_counts(msw, off);
+
+        return off;
+    }
+
+    /* the inode is allocated after its children */
+    off = inode_next_off(msw);
+    min_off = offs[0];
+    for (i = 1; i < num_children; i++) {
+        if (offs[i] < min_off) min_off = offs[i];
+    }
+    key_width = inode_compact_width(encoded_token_key(tokens[num_children - 1])
+                                    - encoded_token_key(tokens[0]));
+    off_width = inode_compact_width(off - min_off);
+
+    if (inode_alloc(msw, inode_compact_size(num_children, key_width,
+                                            off_width)) != off) {
+        return MEMSECTOR_OFF_NULL;
+    }
+    inode_compact_init((inode_t*) mswr_off2addr(msw, off), off, num_children,
+                       tokens, offs, key_width, off_width);
+    memsector_writer_set_subtree_counts(msw, off);
+
+    return off;
+}
+
+void memsector_writer_set_subtree_counts(memsector_writer_t *msw,
+                                         memsector_off_t off) {
+    index_handle_t index;
+    const inode_t* inode;
+    inode_counts_t* counts;
+    uint64_t num_hits = 0;
+    uint32_t i;
+
+    if (!mswr_has_subtree_counts(msw)) return;
+
+    index.root = NULL;
+    index.alloc = mswr_get_alloc(msw);
+    index.format = mswr_get_format(msw);
+    index.off_shift = mswr_get_off_shift(msw);
+    index.subtree_counts = true;
+
+    inode = (const inode_t*) mswr_off2addr(msw, off);
+    for (i = 0; i < inode->size; i++) {
+        const inode_t* child = (const inode_t*)
+                mswr_off2addr(msw, inode_get_off(&index, inode, i));
+        if (child->type == LEAF_NODE) {
+            num_hits += ((const leaf_t*) child)->num_hits;
+        } else {
+            num_hits += inode_get_counts(child)->num_hits;
+        }
+    }
+
+    counts = inode_get_counts(inode);
+    counts->num_hits = (num_hits < UINT32_MAX) ? num_hits : UINT32_MAX;
+}
+
 int memsector_save(memsector_writer_t *msw) {
+    /* release the space left over by growing */
+    if (mmap_resize(&msw->mmap_handle, mswr_size_inuse(msw), MAP_SHARED) != 0) {
+        return -1;
+    }
+    msw->ms_header = (memsector_header_t*) msw->mmap_handle.start_addr;
+    mswr_get_alloc(msw)->end_offset =
+            msw->mmap_handle.size >> mswr_get_off_shift(msw);
+
     return mmap_unload(&msw->mmap_handle);
 }
 
 int memsector_load(memsector_handle_t *ms, const char *path) {
+    return memsector_load_flags(ms, path, /* flags = */ 0);
+}
+
+static void memsector_advise(memsector_handle_t *ms, int flags) {
+    char* addr = ms->mmap_handle.start_addr;
+    size_t size = ms->mmap_handle.size;
+
+#ifdef MADV_WILLNEED
+    if ((flags & MEMSECTOR_LOAD_WILLNEED) &&
+            madvise(addr, size, MADV_WILLNEED) != 0) {
+        PRINT_WARN("madvise(MADV_WILLNEED): %s\n", strerror(errno));
+    }
+#endif  // MADV_WILLNEED
+#ifdef MADV_HUGEPAGE
+    if ((flags & MEMSECTOR_LOAD_HUGEPAGE) &&
+            madvise(addr, size, MADV_HUGEPAGE) != 0) {
+        PRINT_WARN("madvise(MADV_HUGEPAGE): %s\n", strerror(errno));
+    }
+#else
+    if (flags & MEMSECTOR_LOAD_HUGEPAGE) {
+        PRINT_WARN("MADV_HUGEPAGE is not supported\n");
+    }
+#endif  // MADV_HUGEPAGE
+    if ((flags & MEMSECTOR_LOAD_MLOCK) && mlock(addr, size) != 0) {
+        PRINT_WARN("mlock: %s\n", strerror(errno));
+    }
+}
+
+int memsector_load_flags(memsector_handle_t *ms, const char *path,
+                         int flags) {
     int status;
+    int mmap_flags = MAP_SHARED;
+
+#ifdef MAP_POPULATE
+    if (flags & MEMSECTOR_LOAD_POPULATE) mmap_flags |= MAP_POPULATE;
+#else
+    if (flags & MEMSECTOR_LOAD_POPULATE) {
+        PRINT_WARN("MAP_POPULATE is not supported\n");
+    }
+#endif  // MAP_POPULATE
 
     // mmap_handle
-    status = mmap_load(path, MAP_SHARED, &ms->mmap_handle);
+    status = mmap_load(path, mmap_flags, &ms->mmap_handle);
     if (status == -1) return -1;
+    memsector_advise(ms, flags);
 
     // alloc
     memsector_header_t* memsector_header =
             (memsector_header_t*) ms->mmap_handle.start_addr;
     ms->alloc = &memsector_header->alloc_header;
 
+    // index format, offset units and subtree counts
+    if (memsector_header->signature != MEMSECTOR_SIGNATURE &&
+            memsector_header->signature != MEMSECTOR_SIGNATURE_NO_FLAGS) {
+        ms->index.format = INDEX_FORMAT_SORTED_PAIRS;
+        ms->index.off_shift = 0;
+        ms->index.subtree_counts = false;
+    } else if ((memsector_header->index_format == INDEX_FORMAT_SORTED_PAIRS ||
+                memsector_header->index_format == INDEX_FORMAT_BLOCKED_KEYS ||
+                memsector_header->index_format == INDEX_FORMAT_COMPACT) &&
+               memsector_header->off_shift <= MEMSECTOR_MAX_OFF_SHIFT) {
+        ms->index.format = (index_format_t) memsector_header->index_format;
+        ms->index.off_shift = memsector_header->off_shift;
+        ms->index.subtree_counts =
+                memsector_header->signature == MEMSECTOR_SIGNATURE &&
+                (memsector_header->flags & MEMSECTOR_FLAG_SUBTREE_COUNTS);
+    } else {
+        mmap_unload(&ms->mmap_handle);
+        return -1;
+    }
+
     // index handle
     index_header_t* index_header = (index_header_t*)
-            memsector_off2addr(ms->alloc, memsector_header->index_header_off);
+            memsector_off2addr(ms->alloc, ms->index.off_shift,
+                               memsector_header->index_header_off);
     ms->index.alloc = ms->alloc;
     ms->index.root  = &index_header->root;
 
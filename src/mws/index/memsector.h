@@ -41,6 +41,33 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include "mws/index/encoded_token.h"
 #include "mws/index/index.h"
 
+/*--------------------------------------------------------------------------*/
+/* Constants                                                                */
+/*--------------------------------------------------------------------------*/
+
+/// Maximum size of a memsector, as offsets are 31 bit units of 1 << shift
+#define MEMSECTOR_MAX_SIZE(off_shift)   \
+    (((uint64_t) INT32_MAX + 1) << (off_shift))
+/// Largest unit of offsets, up to the alignment of blocked inode keys
+#define MEMSECTOR_MAX_OFF_SHIFT 6
+/// Initial size of memsectors which are grown while written
+#define MEMSECTOR_INITIAL_SIZE  (1 << 20)
+/// Signature of memsectors recording their index format ("MWSI")
+#define MEMSECTOR_SIGNATURE_NO_FLAGS    0x4D575349
+/// Signature of memsectors also recording flags ("MWS2")
+#define MEMSECTOR_SIGNATURE     0x4D575332
+/// Internal nodes are preceded by the counts of their subtree
+#define MEMSECTOR_FLAG_SUBTREE_COUNTS   0x1
+
+/// Read all pages of the memsector while mapping it (MAP_POPULATE)
+#define MEMSECTOR_LOAD_POPULATE         0x1
+/// Start reading the memsector in the background (MADV_WILLNEED)
+#define MEMSECTOR_LOAD_WILLNEED         0x2
+/// Back the memsector by huge pages where possible (MADV_HUGEPAGE)
+#define MEMSECTOR_LOAD_HUGEPAGE         0x4
+/// Keep the memsector resident (mlock)
+#define MEMSECTOR_LOAD_MLOCK            0x8
+
 /*--------------------------------------------------------------------------*/
 /* Type declarations                                                        */
 /*--------------------------------------------------------------------------*/
@@ -48,7 +75,14 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 struct memsector_header_s {
     memsector_alloc_header_t alloc_header;
     uint32_t index_header_off;
-    uint32_t signature; // TODO
+    /// MEMSECTOR_SIGNATURE, uninitialized in legacy memsectors
+    uint32_t signature;
+    /// index_format_t of the index, absent from legacy memsectors
+    uint32_t index_format;
+    /// offsets are in units of 1 << off_shift bytes, 0 if absent
+    uint32_t off_shift;
+    /// MEMSECTOR_FLAG_* set for the index, absent without MEMSECTOR_SIGNATURE
+    uint32_t flags;
 } PACKED;
 typedef struct memsector_header_s memsector_header_t;
 
@@ -70,6 +104,9 @@ typedef struct memsector_writer_s {
 BEGIN_DECLS
 
 /**
+ * The file grows as data is allocated with memsector_writer_alloc(), so
+ * size is only the initial size. The index is written in
+ * INDEX_FORMAT_LATEST.
  * @return 0 on success, -1 on failure.
  */
 int memsector_create(memsector_writer_t *msw,
@@ -77,15 +114,87 @@ int memsector_create(memsector_writer_t *msw,
                      uint32_t size);
 
 /**
+ * Same as memsector_create(), for an index written in the given format and
+ * with offsets in units of 1 << off_shift bytes.
+ * @return 0 on success, -1 on failure.
+ */
+int memsector_create_format(memsector_writer_t *msw,
+                            const char *path,
+                            uint32_t size,
+                            index_format_t format,
+                            uint32_t off_shift);
+
+/**
+ * Same as memsector_create_format(), for an index with the MEMSECTOR_FLAG_*
+ * flags. Without flags, the memsector has the MEMSECTOR_SIGNATURE_NO_FLAGS
+ * layout.
+ * @return 0 on success, -1 on failure.
+ */
+int memsector_create_flags(memsector_writer_t *msw,
+                           const char *path,
+                           uint32_t size,
+                           index_format_t format,
+                           uint32_t off_shift,
+                           uint32_t flags);
+
+/**
+ * Allocate in a memsector being written, growing its file if needed. The
+ * memsector may be remapped, invalidating addresses obtained before.
+ * @return offset of the allocated block, MEMSECTOR_OFF_NULL on failure.
+ */
+memsector_off_t memsector_writer_alloc(memsector_writer_t *msw,
+                                       uint32_t nbytes);
+
+/**
+ * Allocate an internal node in the format of the memsector and set its type
+ * and size. Its tokens and offsets are set with inode_set_token() and
+ * inode_set_off(), followed by inode_build_index() once all tokens are set,
+ * and memsector_writer_set_subtree_counts() once all children are written.
+ * INDEX_FORMAT_COMPACT nodes are written with memsector_writer_write_inode().
+ * @return offset of the node, MEMSECTOR_OFF_NULL on failure.
+ */
+memsector_off_t memsector_writer_alloc_inode(memsector_writer_t *msw,
+                                             uint32_t num_children);
+
+/**
+ * Write an internal node in the format of the memsector, with its sorted
+ * tokens and the offsets of its children, which are already written.
+ * @return offset of the node, MEMSECTOR_OFF_NULL on failure.
+ */
+memsector_off_t memsector_writer_write_inode(memsector_writer_t *msw,
+                                             uint32_t num_children,
+                                             const encoded_token_t* tokens,
+                                             const memsector_off_t* offs);
+
+/**
+ * Set the subtree counts of an internal node from those of its children,
+ * once they are all written. Nothing is done if the memsector has no
+ * subtree counts.
+ */
+void memsector_writer_set_subtree_counts(memsector_writer_t *msw,
+                                         memsector_off_t off);
+
+/**
+ * Trim the memsector file to the allocated data and unmap it.
  * @return 0 on success, -1 on failure.
  */
 int memsector_save(memsector_writer_t *msw);
 
 /**
+ * Load a memsector of any known index format.
  * @return 0 on success, -1 on failure.
  */
 int memsector_load(memsector_handle_t *ms, const char *path);
 
+/**
+ * Load a memsector of any known index format, controlling how its pages
+ * are made resident. Advice the system does not support is only reported.
+ * @param flags MEMSECTOR_LOAD_* flags or-ed together
+ * @return 0 on success, -1 on failure.
+ */
+int memsector_load_flags(memsector_handle_t *ms, const char *path,
+                         int flags);
+
 /**
  * @return 0 on success, -1 on failure.
  */
@@ -104,6 +213,45 @@ memsector_alloc_header_t *mswr_get_alloc(memsector_writer_t* mswr) {
     return &mswr->ms_header->alloc_header;
 }
 
+static inline
+uint32_t mswr_get_off_shift(const memsector_writer_t* mswr) {
+    return mswr->ms_header->off_shift;
+}
+
+static inline
+void* mswr_off2addr(memsector_writer_t* mswr, memsector_off_t off) {
+    /* the allocation header starts the mapping: offsets are from its start */
+    return (char*) mswr->mmap_handle.start_addr +
+            ((uint64_t) off << mswr_get_off_shift(mswr));
+}
+
+/**
+ * @return size in use in bytes
+ */
+static inline
+uint64_t mswr_size_inuse(memsector_writer_t* mswr) {
+    return memsector_size_inuse(mswr_get_alloc(mswr),
+                                mswr_get_off_shift(mswr));
+}
+
+static inline
+bool mswr_has_subtree_counts(const memsector_writer_t* mswr) {
+    return (mswr->ms_header->flags & MEMSECTOR_FLAG_SUBTREE_COUNTS) != 0;
+}
+
+static inline
+index_format_t mswr_get_format(const memsector_writer_t* mswr) {
+    return (index_format_t) mswr->ms_header->index_format;
+}
+
+/**
+ * Set the root node of the index, once it is written.
+ */
+static inline
+void mswr_set_root(memsector_writer_t* mswr, memsector_off_t off) {
+    mswr->ms_header->index_header_off = off;
+}
+
 static inline
 memsector_alloc_header_t* ms_get_alloc(memsector_handle_t* ms) {
     return ms->alloc;
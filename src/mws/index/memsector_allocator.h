@@ -41,11 +41,15 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 /*--------------------------------------------------------------------------*/
 
 /**
- * Compact offset pointer
+ * Compact offset pointer, in units of (1 << off_shift) bytes
  */
 typedef int32_t memsector_off_t;
 #define MEMSECTOR_OFF_NULL  (memsector_off_t) -1
 
+/**
+ * Allocation header, with offsets in units of (1 << off_shift) bytes. Larger
+ * units trade alignment padding for memsectors larger than 2 GiB.
+ */
 struct memsector_alloc_header_s {
     uint32_t curr_offset;
     uint32_t end_offset;
@@ -58,26 +62,48 @@ typedef struct memsector_alloc_header_s memsector_alloc_header_t;
 
 BEGIN_DECLS
 
+/**
+ * @return number of offset units spanned by nbytes
+ */
+static inline
+uint32_t memsector_units(uint32_t off_shift, uint64_t nbytes) {
+    return (nbytes + (1 << off_shift) - 1) >> off_shift;
+}
+
 static inline
 memsector_off_t memsector_alloc(memsector_alloc_header_t *alloc,
+                                uint32_t off_shift,
                                 uint32_t nbytes) {
-    assert(alloc->end_offset - alloc->curr_offset >= nbytes);
+    uint32_t nunits = memsector_units(off_shift, nbytes);
+    assert(alloc->end_offset - alloc->curr_offset >= nunits);
 
     memsector_off_t result = alloc->curr_offset;
-    alloc->curr_offset += nbytes;
+    alloc->curr_offset += nunits;
 
     return result;
 }
 
 static inline
 void* memsector_off2addr(const memsector_alloc_header_t* alloc,
+                         uint32_t off_shift,
                          memsector_off_t off) {
-    return (void*) (((char*)alloc) + off);
+    return (void*) (((char*)alloc) + ((uint64_t) off << off_shift));
 }
 
 static inline
-uint32_t memsector_size_inuse(const memsector_alloc_header_t* alloc) {
-    return alloc->curr_offset;
+memsector_off_t memsector_addr2off(const memsector_alloc_header_t* alloc,
+                                   uint32_t off_shift,
+                                   const void* addr) {
+    return ((const char*) addr - (const char*) alloc) >> off_shift;
+}
+
+/**
+ * @return size in use in bytes
+ */
+static inline
+uint64_t memsector_size_inuse(const memsector_alloc_header_t* alloc,
+                              uint32_t off_shift) {
+    return (uint64_t) alloc->curr_offset << off_shift;
 }
 
 static inline
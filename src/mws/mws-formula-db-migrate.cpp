@@ -0,0 +1,189 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file mws-formula-db-migrate.cpp
+  * @brief mws-formula-db-migrate executable: converts the formula.db of an
+  * index from the decimal key schema to the binary key schema
+  * @date 18 Oct 2026
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+using std::unique_ptr;
+#include <stdexcept>
+using std::exception;
+#include <string>
+using std::string;
+#include <utility>
+using std::pair;
+using std::make_pair;
+#include <vector>
+using std::vector;
+#include <leveldb/db.h>
+
+#include "common/types/Parcelable.hpp"
+using common::types::ParcelDecoder;
+#include "common/utils/compiler_defs.h"
+#include "common/utils/FlagParser.hpp"
+using common::utils::FlagParser;
+#include "mws/dbc/LevFormulaDb.hpp"
+using mws::dbc::CrawlId;
+using mws::dbc::LevFormulaDb;
+#include "mws/types/FormulaPath.hpp"
+using mws::types::FormulaId;
+using mws::types::FormulaPath;
+
+#include "build-gen/config.h"
+
+/// Hit of a formula, by its counter in the old database
+typedef pair<unsigned long, pair<CrawlId, FormulaPath> > OldHit;
+
+/**
+ * @brief insert the hits of a formula in the order they were first inserted
+ * @return number of hits inserted or -1 on failure
+ */
+static int insertHits(LevFormulaDb* formulaDb, FormulaId formulaId,
+                      vector<OldHit>* hits) {
+    // "12!10" sorted before "12!9" in the old database
+    std::sort(hits->begin(), hits->end(),
+              [](const OldHit& a, const OldHit& b) {
+        return a.first < b.first;
+    });
+    for (const OldHit& hit : *hits) {
+        if (formulaDb->insertFormula(formulaId, hit.second.first,
+                                     hit.second.second) != 0) {
+            return -1;
+        }
+    }
+    int inserted = hits->size();
+    hits->clear();
+
+    return inserted;
+}
+
+int main(int argc, char* argv[]) {
+    string index_dir;
+    string old_path, new_path, backup_path;
+    leveldb::DB* oldDb = NULL;
+    LevFormulaDb* formulaDb = NULL;
+    unique_ptr<leveldb::Iterator> it;
+    leveldb::Status status;
+    string version;
+    vector<OldHit> hits;
+    string group;
+    FormulaId formulaId = 0;
+    size_t numFormulae = 0, numHits = 0;
+    int ret;
+
+    FlagParser::addFlag('I', "index-path",              FLAG_REQ, ARG_REQ);
+
+    if ((ret = FlagParser::parse(argc, argv)) != 0) {
+        fprintf(stderr, "%s", FlagParser::getUsage().c_str());
+        goto failure;
+    }
+
+    index_dir = FlagParser::getArg('I');
+    old_path = index_dir + "/formula.db";
+    new_path = index_dir + "/formula.db.migrate";
+    backup_path = index_dir + "/formula.db.decimal";
+
+    status = leveldb::DB::Open(leveldb::Options(), old_path, &oldDb);
+    if (!status.ok()) {
+        PRINT_WARN("%s: %s\n", old_path.c_str(), status.ToString().c_str());
+        goto failure;
+    }
+    status = oldDb->Get(leveldb::ReadOptions(), LevFormulaDb::SCHEMA_KEY,
+                        &version);
+    if (status.ok()) {
+        printf("%s already uses schema version %s\n", old_path.c_str(),
+               version.c_str());
+        delete oldDb;
+        return EXIT_SUCCESS;
+    }
+
+    formulaDb = new LevFormulaDb();
+    try {
+        formulaDb->create_new(new_path.c_str(), /* deleteIfExists = */ true);
+    } catch (exception& e) {
+        PRINT_WARN("%s\n", e.what());
+        goto failure;
+    }
+
+    // keys "formulaId!counter" of a formula are adjacent
+    it.reset(oldDb->NewIterator(leveldb::ReadOptions()));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        const string key = it->key().ToString();
+        const size_t sep = key.find('!');
+        if (sep == string::npos) {
+            PRINT_WARN("Invalid key \"%s\"\n", key.c_str());
+            goto failure;
+        }
+        if (key.compare(0, sep + 1, group) != 0) {
+            if ((ret = insertHits(formulaDb, formulaId, &hits)) < 0) {
+                goto failure;
+            }
+            numHits += ret;
+            group = key.substr(0, sep + 1);
+            formulaId = strtoul(key.c_str(), NULL, 10);
+            numFormulae++;
+        }
+
+        const string value = it->value().ToString();
+        ParcelDecoder decoder(value.data(), value.size());
+        string crawlId_str;
+        FormulaPath formulaPath;
+        decoder.decode(&crawlId_str);
+        decoder.decode(&formulaPath);
+        hits.push_back(make_pair(strtoul(key.c_str() + sep + 1, NULL, 10),
+                                 make_pair(strtoul(crawlId_str.c_str(),
+                                                   NULL, 0),
+                                           formulaPath)));
+    }
+    if ((ret = insertHits(formulaDb, formulaId, &hits)) < 0) {
+        goto failure;
+    }
+    numHits += ret;
+    it.reset();
+    delete oldDb;
+    oldDb = NULL;
+    delete formulaDb;
+    formulaDb = NULL;
+
+    if (rename(old_path.c_str(), backup_path.c_str()) != 0 ||
+            rename(new_path.c_str(), old_path.c_str()) != 0) {
+        perror("rename");
+        goto failure;
+    }
+    printf("Migrated %zu hits of %zu formulae\n", numHits, numFormulae);
+    printf("The old database was kept in %s\n", backup_path.c_str());
+
+    return EXIT_SUCCESS;
+
+failure:
+    PRINT_WARN("Migrating %s failed\n", index_dir.c_str());
+    it.reset();
+    delete oldDb;
+    delete formulaDb;
+    return EXIT_FAILURE;
+}
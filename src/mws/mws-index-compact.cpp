@@ -0,0 +1,80 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file mws-index-compact.cpp
+  * @brief mws-index-compact executable: merges the delta segments appended
+  * by mws-index --append into the base segment of an index
+  * @date 18 Oct 2026
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+using std::string;
+
+#include "common/utils/FlagParser.hpp"
+using common::utils::FlagParser;
+#include "common/utils/compiler_defs.h"
+#include "mws/index/IndexCompaction.hpp"
+using mws::index::CompactionOptions;
+using mws::index::compactIndex;
+
+int main(int argc, char* argv[]) {
+    string index_path;
+    CompactionOptions options;
+    int ret;
+
+    FlagParser::addFlag('I', "index-path",              FLAG_REQ, ARG_REQ);
+    FlagParser::addFlag('r', "max-write-rate",          FLAG_OPT, ARG_REQ);
+
+    if ((ret = FlagParser::parse(argc, argv)) != 0) {
+        fprintf(stderr, "%s", FlagParser::getUsage().c_str());
+        goto failure;
+    }
+
+    index_path = FlagParser::getArg('I');
+    // in MiB per second
+    if (FlagParser::hasArg('r')) {
+        int maxWriteRate = atoi(FlagParser::getArg('r').c_str());
+        if (maxWriteRate < 1) {
+            fprintf(stderr, "Invalid write rate \"%s\"\n",
+                    FlagParser::getArg('r').c_str());
+            goto failure;
+        }
+        options.maxWriteRate = (uint64_t) maxWriteRate << 20;
+    }
+
+    ret = compactIndex(index_path, options);
+    if (ret < 0) {
+        goto failure;
+    } else if (ret == 0) {
+        printf("%s has no delta segment to compact\n", index_path.c_str());
+    } else {
+        printf("Compacted %d segments of %s\n", ret, index_path.c_str());
+        printf("Send SIGHUP to mwsd-load to answer queries from it\n");
+    }
+
+    return EXIT_SUCCESS;
+
+failure:
+    return EXIT_FAILURE;
+}
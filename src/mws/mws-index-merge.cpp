@@ -0,0 +1,221 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @file mws-index-merge.cpp
+  * @brief mws-index-merge executable: merges indexes built by mws-index from
+  * separate harvest shards into a single index
+  * @date 17 Oct 2026
+  */
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <stdexcept>
+using std::exception;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/FlagParser.hpp"
+using common::utils::FlagParser;
+#include "mws/dbc/LevCrawlDb.hpp"
+#include "mws/dbc/LevFormulaDb.hpp"
+#include "mws/index/IndexMerger.hpp"
+using mws::index::IndexMerger;
+using mws::index::IndexShard;
+#include "mws/index/memsector.h"
+#include "mws/index/MeaningDictionary.hpp"
+using mws::index::MeaningDictionary;
+#include "mws/index/MmapMeaningDictionary.hpp"
+using mws::index::MmapMeaningDictionary;
+
+#include "build-gen/config.h"
+
+using namespace mws;
+
+struct LoadedShard {
+    memsector_handle_t memsector;
+    MeaningDictionary meaningDictionary;
+    dbc::LevFormulaDb formulaDb;
+    dbc::LevCrawlDb crawlDb;
+};
+
+static int loadShard(const string& path, LoadedShard* shard) {
+    std::filebuf fb;
+    std::istream is(&fb);
+
+    try {
+        shard->formulaDb.open((path + "/formula.db").c_str());
+        shard->crawlDb.open((path + "/crawl.db").c_str());
+    } catch (exception& e) {
+        PRINT_WARN("%s: %s\n", path.c_str(), e.what());
+        return -1;
+    }
+    if (memsector_load(&shard->memsector,
+                       (path + "/memsector.dat").c_str()) != 0) {
+        PRINT_WARN("%s: cannot load memsector\n", path.c_str());
+        return -1;
+    }
+    if (fb.open((path + "/meaning.dat").c_str(), std::ios::in) == NULL ||
+            shard->meaningDictionary.load(is) != 0) {
+        PRINT_WARN("%s: cannot load meaning dictionary\n", path.c_str());
+        return -1;
+    }
+    fb.close();
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    string output_dir;
+    string memsector_path;
+    uint32_t off_shift;
+    index_format_t index_format = INDEX_FORMAT_LATEST;
+    uint32_t memsector_flags = 0;
+    memsector_writer_t mwsr;
+    vector<string> shard_paths;
+    vector<LoadedShard*> shards;
+    dbc::LevCrawlDb crawlDb;
+    dbc::LevFormulaDb formulaDb;
+    MeaningDictionary meaningDictionary;
+    IndexMerger merger(&formulaDb, &crawlDb, &meaningDictionary);
+    std::filebuf fb;
+    std::ostream os(&fb);
+    int ret;
+
+    FlagParser::addFlag('o', "output-directory",        FLAG_REQ, ARG_REQ);
+    FlagParser::addFlag('I', "include-index-path",      FLAG_REQ, ARG_REQ);
+    FlagParser::addFlag('f', "index-format",            FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('s', "subtree-counts",          FLAG_OPT, ARG_NONE);
+
+    if ((ret = FlagParser::parse(argc, argv)) != 0) {
+        fprintf(stderr, "%s", FlagParser::getUsage().c_str());
+        goto failure;
+    }
+
+    output_dir = FlagParser::getArg('o');
+    shard_paths = FlagParser::getArgs('I');
+    if (FlagParser::hasArg('f')) {
+        // "blocked" is searched faster, "compact" is smaller
+        if (FlagParser::getArg('f') == "blocked") {
+            index_format = INDEX_FORMAT_BLOCKED_KEYS;
+        } else if (FlagParser::getArg('f') == "compact") {
+            index_format = INDEX_FORMAT_COMPACT;
+        } else {
+            fprintf(stderr, "Invalid index format \"%s\"\n",
+                    FlagParser::getArg('f').c_str());
+            goto failure;
+        }
+    }
+    // counts the hits of qvar-only queries without walking to the leaves,
+    // for 4 bytes per internal node
+    if (FlagParser::hasArg('s')) {
+        memsector_flags |= MEMSECTOR_FLAG_SUBTREE_COUNTS;
+    }
+
+    if (access(output_dir.c_str(), 0) != 0) {
+        mkdir(output_dir.c_str(), 0755);
+    }
+
+    try {
+        crawlDb.create_new((output_dir + "/crawl.db").c_str(),
+                           /* deleteIfExists = */ false);
+        formulaDb.create_new((output_dir + "/formula.db").c_str(),
+                             /* deleteIfExists = */ false);
+    } catch (exception& e) {
+        PRINT_WARN("%s\n", e.what());
+        goto failure;
+    }
+
+    for (const string& path : shard_paths) {
+        LoadedShard* shard = new LoadedShard();
+        shards.push_back(shard);
+        if (loadShard(path, shard) != 0) {
+            goto failure;
+        }
+        merger.addShard(IndexShard({&shard->memsector.index,
+                                    &shard->meaningDictionary,
+                                    &shard->formulaDb,
+                                    &shard->crawlDb}));
+        printf("Loaded shard %s\n", path.c_str());
+    }
+
+    // widen the unit of offsets only for merged indexes beyond 2 GiB
+    off_shift = 0;
+    while (merger.getMemsectorSize(index_format, off_shift,
+                                   memsector_flags != 0) >
+           MEMSECTOR_MAX_SIZE(off_shift)) {
+        if (++off_shift > MEMSECTOR_MAX_OFF_SHIFT) {
+            PRINT_WARN("Merged index too large to export\n");
+            goto failure;
+        }
+    }
+    if (off_shift > 0) {
+        printf("Exporting index with offsets in units of %d bytes\n",
+               1 << off_shift);
+    }
+
+    memsector_path = output_dir + "/memsector.dat";
+    if (memsector_create_flags(&mwsr, memsector_path.c_str(),
+                               MEMSECTOR_INITIAL_SIZE, index_format,
+                               off_shift, memsector_flags) != 0) {
+        PRINT_WARN("Cannot create memsector in %s\n", output_dir.c_str());
+        goto failure;
+    }
+    try {
+        ret = merger.exportToMemsector(&mwsr);
+    } catch (exception& e) {
+        PRINT_WARN("%s\n", e.what());
+        ret = -1;
+    }
+    if (memsector_save(&mwsr) != 0) {
+        ret = -1;
+    }
+    if (ret != 0) {
+        PRINT_WARN("Merging shards failed\n");
+        goto failure;
+    }
+    printf("Merged %d shards\n", (int) shards.size());
+
+    fb.open((output_dir + "/meaning.dat").c_str(), std::ios::out);
+    meaningDictionary.save(os);
+    fb.close();
+    try {
+        MmapMeaningDictionary::save(meaningDictionary,
+                                    (output_dir + "/meaning.idx").c_str());
+    } catch (exception& e) {
+        PRINT_WARN("%s\n", e.what());
+        goto failure;
+    }
+
+    for (LoadedShard* shard : shards) {
+        memsector_unload(&shard->memsector);
+        delete shard;
+    }
+
+    return EXIT_SUCCESS;
+
+failure:
+    return EXIT_FAILURE;
+}
@@ -25,19 +25,29 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   * @date 18 Jan 2014
   */
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include <stdexcept>
 using std::exception;
 #include <string>
 using std::string;
 #include <fstream>
+#include <vector>
+using std::vector;
 
 #include "common/utils/FlagParser.hpp"
 using common::utils::FlagParser;
 #include "mws/dbc/LevCrawlDb.hpp"
 #include "mws/dbc/LevFormulaDb.hpp"
+#include "mws/dbc/MmapCrawlDb.hpp"
+#include "mws/dbc/MmapFormulaDb.hpp"
+#include "mws/index/IndexSegments.hpp"
 #include "mws/index/MwsIndexNode.hpp"
 #include "mws/index/memsector.h"
 #include "mws/index/MeaningDictionary.hpp"
+#include "mws/index/MmapMeaningDictionary.hpp"
+using mws::index::MmapMeaningDictionary;
 using mws::index::MeaningDictionary;
 #include "mws/xmlparser/processMwsHarvest.hpp"
 using mws::parser::loadMwsHarvestFromDirectory;
@@ -51,10 +61,25 @@ int main(int argc, char* argv[]) {
     memsector_writer_t mwsr;
     string harvest_path;
     int ret;
-    int64_t memsector_size;
+    string memsector_path;
+    uint32_t off_shift;
+    index_format_t index_format = INDEX_FORMAT_LATEST;
+    uint32_t memsector_flags = 0;
+    string harvestExtension = "harvest";
+    bool recursive;
+    int numJobs = 1;
+    bool mmapDatabases;
+    bool append;
+    string segment_dir;
+    string delta_dir;
+    int index_lock = -1;
+    string meaning_path;
+    string meaning_index_path;
 
     dbc::CrawlDb*             crawlDb;
     dbc::FormulaDb*           formulaDb;
+    dbc::MmapCrawlDb*         crawlMmapDb = NULL;
+    dbc::MmapFormulaDb*       formulaMmapDb = NULL;
     MwsIndexNode*             data;
     MeaningDictionary* meaningDictionary;
     index::IndexManager*      indexManager;
@@ -67,22 +92,56 @@ int main(int argc, char* argv[]) {
     FlagParser::addFlag('r', "recursive",               FLAG_OPT, ARG_NONE);
     FlagParser::addFlag('e', "harvest-file-extension",  FLAG_OPT, ARG_REQ);
     FlagParser::addFlag('c', "enable-ci-renaming",   FLAG_OPT, ARG_NONE);
-
-    string harvestExtension = "harvest";
-    if (FlagParser::hasArg('e')) {
-        harvestExtension = FlagParser::getArg('e');
-    }
-
-    bool recursive = FlagParser::hasArg('r');
+    FlagParser::addFlag('j', "jobs",                    FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('f', "index-format",            FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('s', "subtree-counts",          FLAG_OPT, ARG_NONE);
+    FlagParser::addFlag('m', "mmap-databases",          FLAG_OPT, ARG_NONE);
+    FlagParser::addFlag('a', "append",                  FLAG_OPT, ARG_NONE);
 
     if ((ret = FlagParser::parse(argc, argv)) != 0) {
         fprintf(stderr, "%s", FlagParser::getUsage().c_str());
         goto failure;
     }
 
+    if (FlagParser::hasArg('e')) {
+        harvestExtension = FlagParser::getArg('e');
+    }
+    recursive = FlagParser::hasArg('r');
+    if (FlagParser::hasArg('j')) {
+        numJobs = atoi(FlagParser::getArg('j').c_str());
+        if (numJobs < 1) {
+            fprintf(stderr, "Invalid number of jobs \"%s\"\n",
+                    FlagParser::getArg('j').c_str());
+            goto failure;
+        }
+    }
+    if (FlagParser::hasArg('f')) {
+        // "blocked" is searched faster, "compact" is smaller
+        if (FlagParser::getArg('f') == "blocked") {
+            index_format = INDEX_FORMAT_BLOCKED_KEYS;
+        } else if (FlagParser::getArg('f') == "compact") {
+            index_format = INDEX_FORMAT_COMPACT;
+        } else {
+            fprintf(stderr, "Invalid index format \"%s\"\n",
+                    FlagParser::getArg('f').c_str());
+            goto failure;
+        }
+    }
+    // counts the hits of qvar-only queries without walking to the leaves,
+    // for 4 bytes per internal node
+    if (FlagParser::hasArg('s')) {
+        memsector_flags |= MEMSECTOR_FLAG_SUBTREE_COUNTS;
+    }
+
     harvest_path = FlagParser::getArg('I');
     output_dir   = FlagParser::getArg('o');
     indexingOptions.renameCi = FlagParser::hasArg('c');
+    // read-only flat files instead of LevelDB for crawl and formula data
+    mmapDatabases = FlagParser::hasArg('m');
+    // delta segment of the index in output_dir, instead of a new index
+    append = FlagParser::hasArg('a');
+    meaning_path = output_dir + "/meaning.dat";
+    meaning_index_path = output_dir + "/meaning.idx";
 
     // if the path exists
     if (access(output_dir.c_str(), 0) == 0) {
@@ -96,48 +155,140 @@ int main(int argc, char* argv[]) {
             fprintf(stderr, "The path you entered is a file");
             goto failure;
         }
+    } else if (append) {
+        fprintf(stderr, "No index to append to in %s\n", output_dir.c_str());
+        goto failure;
     } else {
         mkdir(output_dir.c_str(), 0755);
     }
 
+    meaningDictionary = new MeaningDictionary();
+    if (append) {
+        // the index is not swapped by a compaction while appending
+        if ((index_lock = index::lockIndex(output_dir)) < 0) {
+            fprintf(stderr, "Cannot lock %s\n", output_dir.c_str());
+            goto failure;
+        }
+        std::filebuf meaning_fb;
+        std::istream is(&meaning_fb);
+        if (meaning_fb.open(meaning_path.c_str(), std::ios::in) == NULL ||
+                meaningDictionary->load(is) != 0) {
+            fprintf(stderr, "Cannot load %s\n", meaning_path.c_str());
+            goto failure;
+        }
+        meaning_fb.close();
+
+        // published by renaming, once complete
+        segment_dir = index::createDeltaSegment(output_dir, &delta_dir);
+        if (segment_dir.empty()) {
+            fprintf(stderr, "Cannot create a delta segment in %s\n",
+                    output_dir.c_str());
+            goto failure;
+        }
+    } else {
+        segment_dir = output_dir;
+    }
+
     try {
-        dbc::LevCrawlDb* crawlLevDb = new dbc::LevCrawlDb();
-        crawlLevDb->create_new((output_dir + "/crawl.db").c_str(),
-                               /* deleteIfExists = */ false);
-        crawlDb = crawlLevDb;
-        dbc::LevFormulaDb* formulaLevDb = new dbc::LevFormulaDb();
-        formulaLevDb->create_new((output_dir + "/formula.db").c_str(),
-                                 /* deleteIfExists = */ false);
-        formulaDb = formulaLevDb;
+        if (mmapDatabases) {
+            crawlMmapDb = new dbc::MmapCrawlDb();
+            crawlMmapDb->create_new((segment_dir + "/crawl.dat").c_str(),
+                                    /* deleteIfExists = */ false);
+            crawlDb = crawlMmapDb;
+            formulaMmapDb = new dbc::MmapFormulaDb();
+            formulaMmapDb->create_new((segment_dir + "/formula.dat").c_str(),
+                                      /* deleteIfExists = */ false);
+            formulaDb = formulaMmapDb;
+        } else {
+            dbc::LevCrawlDb* crawlLevDb = new dbc::LevCrawlDb();
+            crawlLevDb->create_new((segment_dir + "/crawl.db").c_str(),
+                                   /* deleteIfExists = */ false);
+            crawlDb = crawlLevDb;
+            dbc::LevFormulaDb* formulaLevDb = new dbc::LevFormulaDb();
+            formulaLevDb->create_new((segment_dir + "/formula.db").c_str(),
+                                     /* deleteIfExists = */ false);
+            formulaDb = formulaLevDb;
+        }
     } catch (exception& e) {
         PRINT_WARN("%s\n", e.what());
         goto failure;
     }
 
     data = new MwsIndexNode();
-    meaningDictionary = new MeaningDictionary();
 
     indexManager = new index::IndexManager(formulaDb, crawlDb, data,
                                            meaningDictionary, indexingOptions);
     loadMwsHarvestFromDirectory(indexManager, AbsPath(harvest_path),
-                                harvestExtension, recursive);
+                                harvestExtension, recursive, numJobs);
+    if (mmapDatabases) {
+        try {
+            crawlMmapDb->save();
+            formulaMmapDb->save();
+        } catch (exception& e) {
+            PRINT_WARN("%s\n", e.what());
+            goto failure;
+        }
+    }
 
-    memsector_size = data->getMemsectorSize();
-    memsector_create(&mwsr, (output_dir + "/memsector.dat").c_str(),
-                     memsector_size);
+    // widen the unit of offsets only for indexes beyond 2 GiB
+    off_shift = 0;
+    while (data->getMemsectorSize(index_format, off_shift,
+                                 memsector_flags != 0) >
+           MEMSECTOR_MAX_SIZE(off_shift)) {
+        if (++off_shift > MEMSECTOR_MAX_OFF_SHIFT) {
+            PRINT_WARN("Index too large to export\n");
+            goto failure;
+        }
+    }
+    if (off_shift > 0) {
+        printf("Exporting index with offsets in units of %d bytes\n",
+               1 << off_shift);
+    }
 
-    data->exportToMemsector(&mwsr);
-    memsector_save(&mwsr);
+    memsector_path = segment_dir + "/memsector.dat";
+    if (memsector_create_flags(&mwsr, memsector_path.c_str(),
+                               MEMSECTOR_INITIAL_SIZE, index_format,
+                               off_shift, memsector_flags) != 0 ||
+            data->exportToMemsector(&mwsr) != 0 ||
+            memsector_save(&mwsr) != 0) {
+        PRINT_WARN("Cannot export index to %s\n", memsector_path.c_str());
+        goto failure;
+    }
+    // a LevelDB is locked while open, so the databases are closed before
+    // the segment is published and can be opened by mwsd-load
+    delete indexManager;
+    delete crawlDb;
+    delete formulaDb;
 
-    fb.open((output_dir + "/meaning.dat").c_str(), std::ios::out);
+    // meanings are only added, so the other segments stay valid
+    fb.open((meaning_path + ".tmp").c_str(), std::ios::out);
     meaningDictionary->save(os);
     fb.close();
+    try {
+        MmapMeaningDictionary::save(*meaningDictionary,
+                                    (meaning_index_path + ".tmp").c_str());
+    } catch (exception& e) {
+        PRINT_WARN("%s\n", e.what());
+        goto failure;
+    }
+    // meaning.idx is written after meaning.dat, so it is not older
+    if (rename((meaning_path + ".tmp").c_str(), meaning_path.c_str()) != 0 ||
+            rename((meaning_index_path + ".tmp").c_str(),
+                   meaning_index_path.c_str()) != 0) {
+        PRINT_WARN("Cannot save %s\n", meaning_path.c_str());
+        goto failure;
+    }
+    if (append) {
+        if (rename(segment_dir.c_str(), delta_dir.c_str()) != 0) {
+            PRINT_WARN("Cannot publish %s\n", delta_dir.c_str());
+            goto failure;
+        }
+        printf("Appended delta segment %s\n", delta_dir.c_str());
+        index::unlockIndex(index_lock);
+    }
 
-    delete crawlDb;
-    delete formulaDb;
     delete data;
     delete meaningDictionary;
-    delete indexManager;
 
     return EXIT_SUCCESS;
 
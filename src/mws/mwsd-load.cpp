@@ -30,6 +30,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include <unistd.h>
 #include <signal.h>
 
+#include <sstream>
 #include <string>
 using std::string;
 #include <vector>
@@ -44,14 +45,17 @@ using common::utils::FlagParser;
 #include "build-gen/config.h"
 
 static volatile sig_atomic_t sigQuit = 0;
+static volatile sig_atomic_t sigReload = 0;
 
 static void catch_sigint(int sig) {
     if (sig == SIGINT || sig == SIGTERM) sigQuit = 1;
+    // SIGHUP swaps in the index rebuilt at the index path
+    if (sig == SIGHUP) sigReload = 1;
 }
 
 int main(int argc, char* argv[]) {
     sigset_t              mask, old_mask;
-    struct sigaction      sa, old_sa1, old_sa2;
+    struct sigaction      sa, old_sa1, old_sa2, old_sa3;
     int                   ret;
     mws::daemon::Config config;
     mws::daemon::IndexDaemon daemon;
@@ -62,6 +66,18 @@ int main(int argc, char* argv[]) {
     FlagParser::addFlag('I', "index-path",           FLAG_REQ, ARG_REQ);
     FlagParser::addFlag('i', "pid-file",             FLAG_OPT, ARG_REQ);
     FlagParser::addFlag('l', "log-file",             FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('w', "query-workers",        FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('q', "query-queue-depth",    FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('C', "query-cache-size",     FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('M', "match-list-cache-size", FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('T', "match-list-ttl",       FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('p', "populate-index",       FLAG_OPT, ARG_NONE);
+    FlagParser::addFlag('a', "index-advice",         FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('L', "lock-index",           FLAG_OPT, ARG_NONE);
+    FlagParser::addFlag('k', "warm-up-depth",        FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('W', "warm-up-queries",      FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('S', "compact-segments",     FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('R', "compaction-write-rate", FLAG_OPT, ARG_REQ);
 #ifndef __APPLE__
     FlagParser::addFlag('d', "daemonize",            FLAG_OPT, ARG_NONE);
 #endif  // !__APPLE__
@@ -86,6 +102,130 @@ int main(int argc, char* argv[]) {
         config.mwsPort = DEFAULT_MWS_PORT;
     }
 
+    // query-workers
+    if (FlagParser::hasArg('w')) {
+        int numQueryWorkers = atoi(FlagParser::getArg('w').c_str());
+        if (numQueryWorkers > 0) {
+            config.numQueryWorkers = numQueryWorkers;
+        } else {
+            PRINT_WARN("Invalid number of query workers \"%s\"\n",
+                       FlagParser::getArg('w').c_str());
+            goto failure;
+        }
+    }
+
+    // query-queue-depth
+    if (FlagParser::hasArg('q')) {
+        int queryQueueDepth = atoi(FlagParser::getArg('q').c_str());
+        if (queryQueueDepth > 0) {
+            config.queryQueueDepth = queryQueueDepth;
+        } else {
+            PRINT_WARN("Invalid query queue depth \"%s\"\n",
+                       FlagParser::getArg('q').c_str());
+            goto failure;
+        }
+    }
+
+    // query-cache-size (in MiB)
+    if (FlagParser::hasArg('C')) {
+        int queryCacheSize = atoi(FlagParser::getArg('C').c_str());
+        if (queryCacheSize >= 0) {
+            config.queryCacheSize = (size_t) queryCacheSize << 20;
+        } else {
+            PRINT_WARN("Invalid query cache size \"%s\"\n",
+                       FlagParser::getArg('C').c_str());
+            goto failure;
+        }
+    }
+
+    // match-list-cache-size (in MiB)
+    if (FlagParser::hasArg('M')) {
+        int matchListCacheSize = atoi(FlagParser::getArg('M').c_str());
+        if (matchListCacheSize >= 0) {
+            config.matchListCacheSize = (size_t) matchListCacheSize << 20;
+        } else {
+            PRINT_WARN("Invalid match list cache size \"%s\"\n",
+                       FlagParser::getArg('M').c_str());
+            goto failure;
+        }
+    }
+
+    // match-list-ttl (in seconds)
+    if (FlagParser::hasArg('T')) {
+        int matchListTtl = atoi(FlagParser::getArg('T').c_str());
+        if (matchListTtl > 0) {
+            config.matchListTtl = matchListTtl;
+        } else {
+            PRINT_WARN("Invalid match list TTL \"%s\"\n",
+                       FlagParser::getArg('T').c_str());
+            goto failure;
+        }
+    }
+
+    // populate-index, index-advice, lock-index
+    if (FlagParser::hasArg('p')) {
+        config.indexLoadFlags |= MEMSECTOR_LOAD_POPULATE;
+    }
+    if (FlagParser::hasArg('a')) {
+        std::istringstream advice(FlagParser::getArg('a'));
+        string name;
+        while (std::getline(advice, name, ',')) {
+            if (name == "willneed") {
+                config.indexLoadFlags |= MEMSECTOR_LOAD_WILLNEED;
+            } else if (name == "hugepage") {
+                config.indexLoadFlags |= MEMSECTOR_LOAD_HUGEPAGE;
+            } else {
+                PRINT_WARN("Invalid index advice \"%s\", expected "
+                           "willneed or hugepage\n", name.c_str());
+                goto failure;
+            }
+        }
+    }
+    if (FlagParser::hasArg('L')) {
+        config.indexLoadFlags |= MEMSECTOR_LOAD_MLOCK;
+    }
+
+    // warm-up-depth
+    if (FlagParser::hasArg('k')) {
+        int warmUpDepth = atoi(FlagParser::getArg('k').c_str());
+        if (warmUpDepth >= 0) {
+            config.warmUpDepth = warmUpDepth;
+        } else {
+            PRINT_WARN("Invalid warm-up depth \"%s\"\n",
+                       FlagParser::getArg('k').c_str());
+            goto failure;
+        }
+    }
+
+    // warm-up-queries
+    if (FlagParser::hasArg('W')) {
+        config.warmUpQueriesPath = FlagParser::getArg('W');
+    }
+
+    // compact-segments
+    if (FlagParser::hasArg('S')) {
+        int compactSegments = atoi(FlagParser::getArg('S').c_str());
+        if (compactSegments > 0) {
+            config.compactSegments = compactSegments;
+        } else {
+            PRINT_WARN("Invalid number of segments \"%s\"\n",
+                       FlagParser::getArg('S').c_str());
+            goto failure;
+        }
+    }
+
+    // compaction-write-rate, in MiB per second
+    if (FlagParser::hasArg('R')) {
+        int compactionWriteRate = atoi(FlagParser::getArg('R').c_str());
+        if (compactionWriteRate > 0) {
+            config.compactionWriteRate = (uint64_t) compactionWriteRate << 20;
+        } else {
+            PRINT_WARN("Invalid compaction write rate \"%s\"\n",
+                       FlagParser::getArg('R').c_str());
+            goto failure;
+        }
+    }
+
     config.useExperimentalQueryEngine = FlagParser::hasArg('x');
 
     // index-path
@@ -129,14 +269,9 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // Starting the daemon
-    ret = daemon.startAsync(config);
-    if (ret != 0) {
-        PRINT_WARN("Failure while starting the daemon\n");
-        goto failure;
-    }
-
-    // Preparing the Signal Action
+    // Preparing the Signal Action, before any thread is started so that
+    // all of them inherit the mask. Signals sent while the index is loaded
+    // and warmed up are then handled by sigsuspend below, on this thread.
     sa.sa_handler = catch_sigint;
     sigemptyset(&sa.sa_mask);
     sa.sa_flags = 0;
@@ -144,6 +279,7 @@ int main(int argc, char* argv[]) {
     sigemptyset(&mask);
     sigaddset(&mask, SIGINT);
     sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
     // Block the signals and actions
     if (sigprocmask(SIG_BLOCK, &mask, &old_mask) == -1)
         PRINT_WARN("sigprocmask - SIG_BLOCK");
@@ -151,17 +287,37 @@ int main(int argc, char* argv[]) {
         PRINT_WARN("sigaction - open");
     if (sigaction(SIGTERM, &sa, &old_sa2) == -1)
         PRINT_WARN("sigaction - open");
+    if (sigaction(SIGHUP, &sa, &old_sa3) == -1)
+        PRINT_WARN("sigaction - open");
 
-    // Waiting for SIGINT / SIGTERM
-    while (!sigQuit)
+    // Starting the daemon, the index is warmed up before listening
+    ret = daemon.startAsync(config);
+    if (ret != 0) {
+        PRINT_WARN("Failure while starting the daemon\n");
+        goto failure;
+    }
+    PRINT_LOG("Ready to answer queries on port %d\n", config.mwsPort);
+
+    // Waiting for SIGINT / SIGTERM, reloading the index on SIGHUP
+    while (!sigQuit) {
         sigsuspend(&old_mask);
+        if (sigReload && !sigQuit) {
+            sigReload = 0;
+            PRINT_LOG("Reloading index from %s\n", config.dataPath.c_str());
+            if (daemon.reload() == 0) {
+                PRINT_LOG("Reloaded index\n");
+            }
+        }
+    }
 
     // UNBLOCK the signals and actions
     if (sigprocmask(SIG_SETMASK, &old_mask, NULL) == -1)
         PRINT_WARN("sigprocmask - SIG_SETMASK");
     if (sigaction(SIGINT, &old_sa1, NULL) == -1)
         PRINT_WARN("sigaction - close");
-    if (sigaction(SIGINT, &old_sa2, NULL) == -1)
+    if (sigaction(SIGTERM, &old_sa2, NULL) == -1)
+        PRINT_WARN("sigaction - close");
+    if (sigaction(SIGHUP, &old_sa3, NULL) == -1)
         PRINT_WARN("sigaction - close");
 
     daemon.stop();
@@ -68,6 +68,8 @@ int main(int argc, char* argv[]) {
     FlagParser::addFlag('c', "enable-ci-renaming",      FLAG_OPT, ARG_NONE);
     FlagParser::addFlag('e', "harvest-file-extension",  FLAG_OPT, ARG_REQ);
     FlagParser::addFlag('f', "delete-old-data",         FLAG_OPT, ARG_NONE);
+    FlagParser::addFlag('w', "query-workers",           FLAG_OPT, ARG_REQ);
+    FlagParser::addFlag('q', "query-queue-depth",       FLAG_OPT, ARG_REQ);
 #ifndef __APPLE__
     FlagParser::addFlag('d', "daemonize",            FLAG_OPT, ARG_NONE);
 #endif  // !__APPLE__
@@ -111,6 +113,30 @@ int main(int argc, char* argv[]) {
         config.mwsPort = DEFAULT_MWS_PORT;
     }
 
+    // query-workers
+    if (FlagParser::hasArg('w')) {
+        int numQueryWorkers = atoi(FlagParser::getArg('w').c_str());
+        if (numQueryWorkers > 0) {
+            config.numQueryWorkers = numQueryWorkers;
+        } else {
+            fprintf(stderr, "Invalid number of query workers \"%s\"\n",
+                    FlagParser::getArg('w').c_str());
+            goto failure;
+        }
+    }
+
+    // query-queue-depth
+    if (FlagParser::hasArg('q')) {
+        int queryQueueDepth = atoi(FlagParser::getArg('q').c_str());
+        if (queryQueueDepth > 0) {
+            config.queryQueueDepth = queryQueueDepth;
+        } else {
+            fprintf(stderr, "Invalid query queue depth \"%s\"\n",
+                    FlagParser::getArg('q').c_str());
+            goto failure;
+        }
+    }
+
     // data-path
     if (FlagParser::hasArg('D')) {
         config.dataPath = FlagParser::getArg('D');
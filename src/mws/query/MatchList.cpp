@@ -0,0 +1,131 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief MatchList implementation
+  * @file MatchList.cpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <algorithm>
+#include <vector>
+using std::vector;
+
+#include "mws/dbc/CrawlDb.hpp"
+using mws::dbc::CrawlData;
+#include "mws/types/FormulaPath.hpp"
+using mws::types::FormulaId;
+using mws::types::FormulaPath;
+#include "mws/query/MatchList.hpp"
+
+namespace mws {
+namespace query {
+
+dbc::FormulaQuery pageFormulaQuery(FormulaId formulaId, unsigned int found,
+                                   unsigned int offset, unsigned int size) {
+    dbc::FormulaQuery formulaQuery;
+
+    formulaQuery.formulaId = formulaId;
+    if (offset < found) {
+        formulaQuery.limitMin = 0;
+        formulaQuery.limitSize = size + offset - found;
+    } else {
+        formulaQuery.limitMin = offset - found;
+        formulaQuery.limitSize = size;
+    }
+
+    return formulaQuery;
+}
+
+void queryPageAnswers(dbc::DbQueryManager* dbQueryManager,
+                      const vector<dbc::FormulaQuery>& formulaQueries,
+                      MwsAnswset* result) {
+    dbc::DbAnswerCallback callback =
+            [result](const FormulaPath& formulaPath,
+                     const CrawlData& crawlData) {
+        mws::types::Answer* answer = new mws::types::Answer();
+        answer->data = crawlData;
+        answer->uri = formulaPath.xmlId;
+        answer->xpath = formulaPath.xpath;
+        result->answers.push_back(answer);
+        return 0;
+    };
+
+    if (!formulaQueries.empty()) {
+        dbQueryManager->query(formulaQueries, callback);
+    }
+}
+
+MatchList::MatchList() : _total(0) {
+}
+
+void MatchList::add(FormulaId formulaId, unsigned int found) {
+    _formulaIds.push_back(formulaId);
+    _found.push_back(found);
+}
+
+void MatchList::setTotal(unsigned int total) {
+    _total = total;
+}
+
+unsigned int MatchList::getTotal() const {
+    return _total;
+}
+
+MwsAnswset* MatchList::getPage(dbc::DbQueryManager* dbQueryManager,
+                               unsigned int offset, unsigned int size) const {
+    MwsAnswset* result = new MwsAnswset;
+
+    // hits past the total were not counted
+    if (offset + size > _total) {
+        size = (offset < _total) ? _total - offset : 0;
+    }
+
+    // the formula holding the first hit of the page is the last one
+    // starting at or before it
+    size_t i = std::upper_bound(_found.begin(), _found.end(), offset) -
+            _found.begin();
+    if (i > 0) i--;
+
+    vector<dbc::FormulaQuery> formulaQueries;
+    for (; i < _found.size() && _found[i] < offset + size; i++) {
+        unsigned int end = (i + 1 < _found.size()) ? _found[i + 1] : _total;
+        if (end > offset) {
+            formulaQueries.push_back(pageFormulaQuery(_formulaIds[i],
+                                                      _found[i], offset,
+                                                      size));
+        }
+    }
+    queryPageAnswers(dbQueryManager, formulaQueries, result);
+    result->total = _total;
+
+    return result;
+}
+
+size_t MatchList::getMemoryUsage() const {
+    return sizeof(MatchList) +
+            _formulaIds.capacity() * sizeof(FormulaId) +
+            _found.capacity() * sizeof(unsigned int);
+}
+
+}  // namespace query
+}  // namespace mws
@@ -0,0 +1,105 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_QUERY_MATCHLIST_HPP
+#define _MWS_QUERY_MATCHLIST_HPP
+
+/**
+  * @brief File containing the header of the MatchList class.
+  *
+  * @file MatchList.hpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "mws/dbc/DbQueryManager.hpp"
+#include "mws/types/FormulaPath.hpp"
+#include "mws/types/MwsAnswset.hpp"
+
+namespace mws {
+namespace query {
+
+/**
+  * @brief Formulae matching a query, in the order SearchContext finds them,
+  * from which any page of results is answered without walking the index.
+  */
+class MatchList {
+ public:
+    MatchList();
+
+    /**
+      * @brief Append a matching formula
+      * @param formulaId is the id of the formula.
+      * @param found is the number of hits of the formulae before it.
+      */
+    void add(types::FormulaId formulaId, unsigned int found);
+
+    /// @param total is the number of hits of all formulae, up to the limit
+    /// they were counted to.
+    void setTotal(unsigned int total);
+    unsigned int getTotal() const;
+
+    /**
+      * @brief Answer a page of results, as SearchContext::getResult does
+      * @param offset is the offset where to start returning the solutions.
+      * @param size is the maximum number of solutions to return.
+      * @return an answer set with the corresponding results.
+      */
+    MwsAnswset* getPage(dbc::DbQueryManager* dbQueryManager,
+                        unsigned int offset, unsigned int size) const;
+
+    /// @return bytes held by the list, approximately
+    size_t getMemoryUsage() const;
+
+ private:
+    std::vector<types::FormulaId> _formulaIds;
+    /// Hits of the formulae before each formula, ascending
+    std::vector<unsigned int> _found;
+    unsigned int _total;
+};
+
+/**
+  * @brief Hits of a formula falling in a page
+  * @param formulaId is the id of the formula.
+  * @param found is the number of hits of the formulae before it.
+  * @param offset is the offset where the page starts.
+  * @param size is the size of the page.
+  */
+dbc::FormulaQuery pageFormulaQuery(types::FormulaId formulaId,
+                                   unsigned int found,
+                                   unsigned int offset, unsigned int size);
+
+/**
+  * @brief Append to result the answers of the formulae of a page, read from
+  * the databases in one batch
+  */
+void queryPageAnswers(dbc::DbQueryManager* dbQueryManager,
+                      const std::vector<dbc::FormulaQuery>& formulaQueries,
+                      MwsAnswset* result);
+
+}  // namespace query
+}  // namespace mws
+
+#endif  // _MWS_QUERY_MATCHLIST_HPP
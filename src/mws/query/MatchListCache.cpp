@@ -0,0 +1,182 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief MatchListCache implementation
+  * @file MatchListCache.cpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include <memory>
+using std::shared_ptr;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "mws/query/MatchListCache.hpp"
+
+namespace mws {
+namespace query {
+
+MatchListCache::MatchListCache(size_t capacity, time_t ttl) :
+    _capacity(capacity), _ttl(ttl), _size(0), _hits(0), _misses(0) {
+    pthread_mutex_init(&_lock, NULL);
+}
+
+MatchListCache::~MatchListCache() {
+    clear();
+    pthread_mutex_destroy(&_lock);
+}
+
+bool MatchListCache::isEnabled() const {
+    return _capacity > 0;
+}
+
+time_t MatchListCache::now() const {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec;
+}
+
+string MatchListCache::makeKey(const vector<encoded_token_t>& encodedQuery,
+                               unsigned int maxTotal) {
+    const uint32_t limit = maxTotal;
+    string key(sizeof(limit) + encodedQuery.size() * sizeof(encoded_token_t),
+               '\0');
+
+    memcpy(&key[0], &limit, sizeof(limit));
+    if (!encodedQuery.empty()) {
+        memcpy(&key[sizeof(limit)], encodedQuery.data(),
+               encodedQuery.size() * sizeof(encoded_token_t));
+    }
+
+    return key;
+}
+
+void MatchListCache::erase(EntryList::iterator it) {
+    _index.erase(it->key);
+    _size -= it->size;
+    _entries.erase(it);
+}
+
+shared_ptr<const MatchList>
+MatchListCache::get(const vector<encoded_token_t>& encodedQuery,
+                    unsigned int maxTotal) {
+    shared_ptr<const MatchList> matches;
+
+    if (!isEnabled()) return matches;
+
+    const string key = makeKey(encodedQuery, maxTotal);
+    const time_t currentTime = now();
+    pthread_mutex_lock(&_lock);
+    auto it = _index.find(key);
+    if (it != _index.end() && it->second->expires <= currentTime) {
+        erase(it->second);
+        it = _index.end();
+    }
+    if (it != _index.end()) {
+        // move to the front of the recency list
+        _entries.splice(_entries.begin(), _entries, it->second);
+        matches = it->second->matches;
+        _hits++;
+    } else {
+        _misses++;
+    }
+    pthread_mutex_unlock(&_lock);
+
+    return matches;
+}
+
+void MatchListCache::put(const vector<encoded_token_t>& encodedQuery,
+                         unsigned int maxTotal,
+                         const shared_ptr<const MatchList>& matches) {
+    Entry entry;
+
+    if (!isEnabled()) return;
+
+    const time_t currentTime = now();
+    entry.key = makeKey(encodedQuery, maxTotal);
+    entry.matches = matches;
+    entry.size = 2 * entry.key.size() + sizeof(Entry) +
+            matches->getMemoryUsage();
+    entry.expires = currentTime + _ttl;
+    if (entry.size > _capacity) return;
+
+    pthread_mutex_lock(&_lock);
+    auto it = _index.find(entry.key);
+    if (it != _index.end()) erase(it->second);
+    // expired match lists go first, then the least recently used ones
+    for (auto curr = _entries.begin(); curr != _entries.end();) {
+        auto next = curr;
+        next++;
+        if (curr->expires <= currentTime) erase(curr);
+        curr = next;
+    }
+    while (!_entries.empty() && _size + entry.size > _capacity) {
+        erase(--_entries.end());
+    }
+    _entries.push_front(entry);
+    _index[entry.key] = _entries.begin();
+    _size += entry.size;
+    pthread_mutex_unlock(&_lock);
+}
+
+void MatchListCache::clear() {
+    pthread_mutex_lock(&_lock);
+    _entries.clear();
+    _index.clear();
+    _size = 0;
+    pthread_mutex_unlock(&_lock);
+}
+
+uint64_t MatchListCache::getHits() const {
+    pthread_mutex_lock(&_lock);
+    uint64_t hits = _hits;
+    pthread_mutex_unlock(&_lock);
+
+    return hits;
+}
+
+uint64_t MatchListCache::getMisses() const {
+    pthread_mutex_lock(&_lock);
+    uint64_t misses = _misses;
+    pthread_mutex_unlock(&_lock);
+
+    return misses;
+}
+
+size_t MatchListCache::getSize() const {
+    pthread_mutex_lock(&_lock);
+    size_t size = _size;
+    pthread_mutex_unlock(&_lock);
+
+    return size;
+}
+
+}  // namespace query
+}  // namespace mws
@@ -0,0 +1,127 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_QUERY_MATCHLISTCACHE_HPP
+#define _MWS_QUERY_MATCHLISTCACHE_HPP
+
+/**
+  * @brief File containing the header of the MatchListCache class.
+  *
+  * @file MatchListCache.hpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mws/index/encoded_token.h"
+#include "mws/query/MatchList.hpp"
+
+namespace mws {
+namespace query {
+
+/**
+  * @brief Least recently used match lists, keyed by encoded query and the
+  * number of hits counted, which expire some time after being listed. Safe
+  * to share between query threads.
+  */
+class MatchListCache {
+ public:
+    /**
+      * @param capacity maximum number of bytes held by cached match lists,
+      * 0 to disable the cache
+      * @param ttl seconds after which a match list expires
+      */
+    MatchListCache(size_t capacity, time_t ttl);
+    virtual ~MatchListCache();
+
+    bool isEnabled() const;
+
+    /**
+      * @brief Look up the match list of a query
+      * @param encodedQuery query as encoded by the QueryEncoder
+      * @param maxTotal number of hits the match list counts up to
+      * @return the match list, or NULL on a miss.
+      */
+    std::shared_ptr<const MatchList>
+    get(const std::vector<encoded_token_t>& encodedQuery,
+        unsigned int maxTotal);
+
+    /**
+      * @brief Cache the match list of a query, evicting expired and least
+      * recently used match lists to make room.
+      */
+    void put(const std::vector<encoded_token_t>& encodedQuery,
+             unsigned int maxTotal,
+             const std::shared_ptr<const MatchList>& matches);
+
+    /// Drop every cached match list, when the index they come from changes
+    void clear();
+
+    uint64_t getHits() const;
+    uint64_t getMisses() const;
+    /// @return number of bytes held by cached match lists
+    size_t getSize() const;
+
+ protected:
+    /// @return seconds of a monotonic clock
+    virtual time_t now() const;
+
+ private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const MatchList> matches;
+        size_t size;
+        time_t expires;
+    };
+    typedef std::list<Entry> EntryList;
+
+    static std::string makeKey(const std::vector<encoded_token_t>& encodedQuery,
+                               unsigned int maxTotal);
+    void erase(EntryList::iterator it);
+
+    const size_t _capacity;
+    const time_t _ttl;
+    size_t _size;
+    uint64_t _hits;
+    uint64_t _misses;
+    /// Most recently used first
+    EntryList _entries;
+    std::unordered_map<std::string, EntryList::iterator> _index;
+    mutable pthread_mutex_t _lock;
+
+    MatchListCache(const MatchListCache&);
+    MatchListCache& operator=(const MatchListCache&);
+};
+
+}  // namespace query
+}  // namespace mws
+
+#endif  // _MWS_QUERY_MATCHLISTCACHE_HPP
@@ -0,0 +1,196 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief QueryCache implementation
+  * @file QueryCache.cpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <pthread.h>
+#include <string.h>
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "mws/query/QueryCache.hpp"
+using mws::types::Answer;
+
+namespace mws {
+namespace query {
+
+static MwsAnswset* copyAnswset(const MwsAnswset& answset) {
+    MwsAnswset* copy = new MwsAnswset();
+
+    copy->total = answset.total;
+    copy->qvarNames = answset.qvarNames;
+    copy->qvarXpaths = answset.qvarXpaths;
+    copy->answers.reserve(answset.answers.size());
+    for (const Answer* answer : answset.answers) {
+        copy->answers.push_back(new Answer(*answer));
+    }
+
+    return copy;
+}
+
+/// @return bytes held by answset, approximately
+static size_t answsetSize(const MwsAnswset& answset) {
+    size_t size = sizeof(MwsAnswset);
+
+    for (const Answer* answer : answset.answers) {
+        size += sizeof(Answer*) + sizeof(Answer) + answer->uri.size() +
+                answer->xpath.size() + answer->data.size();
+    }
+    for (size_t i = 0; i < answset.qvarNames.size(); i++) {
+        size += 2 * sizeof(string) + answset.qvarNames[i].size() +
+                answset.qvarXpaths[i].size();
+    }
+
+    return size;
+}
+
+QueryCache::QueryCache(size_t capacity) : _capacity(capacity), _size(0),
+    _hits(0), _misses(0) {
+    pthread_mutex_init(&_lock, NULL);
+}
+
+QueryCache::~QueryCache() {
+    clear();
+    pthread_mutex_destroy(&_lock);
+}
+
+string QueryCache::makeKey(const vector<encoded_token_t>& encodedQuery,
+                           const MwsQuery& query) {
+    const uint32_t page[] = {
+        (uint32_t) query.attrResultLimitMin,
+        (uint32_t) query.attrResultMaxSize,
+        (uint32_t) query.attrResultTotalReqNr,
+    };
+    string key(sizeof(page) + encodedQuery.size() * sizeof(encoded_token_t),
+               '\0');
+
+    memcpy(&key[0], page, sizeof(page));
+    if (!encodedQuery.empty()) {
+        memcpy(&key[sizeof(page)], encodedQuery.data(),
+               encodedQuery.size() * sizeof(encoded_token_t));
+    }
+
+    return key;
+}
+
+MwsAnswset* QueryCache::get(const vector<encoded_token_t>& encodedQuery,
+                            const MwsQuery& query) {
+    MwsAnswset* answset = NULL;
+
+    if (_capacity == 0) return NULL;
+
+    const string key = makeKey(encodedQuery, query);
+    pthread_mutex_lock(&_lock);
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        // move to the front of the recency list
+        _entries.splice(_entries.begin(), _entries, it->second);
+        answset = copyAnswset(*it->second->answset);
+        _hits++;
+    } else {
+        _misses++;
+    }
+    pthread_mutex_unlock(&_lock);
+
+    return answset;
+}
+
+void QueryCache::put(const vector<encoded_token_t>& encodedQuery,
+                     const MwsQuery& query, const MwsAnswset& answset) {
+    Entry entry;
+
+    if (_capacity == 0) return;
+
+    entry.key = makeKey(encodedQuery, query);
+    entry.size = 2 * entry.key.size() + sizeof(Entry) + answsetSize(answset);
+    if (entry.size > _capacity) return;
+    entry.answset = copyAnswset(answset);
+
+    pthread_mutex_lock(&_lock);
+    auto it = _index.find(entry.key);
+    if (it != _index.end()) {
+        // answered concurrently by another thread
+        _entries.splice(_entries.begin(), _entries, it->second);
+        delete entry.answset;
+    } else {
+        evict(entry.size);
+        _entries.push_front(entry);
+        _index[entry.key] = _entries.begin();
+        _size += entry.size;
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+void QueryCache::evict(size_t size) {
+    while (!_entries.empty() && _size + size > _capacity) {
+        Entry& entry = _entries.back();
+        _index.erase(entry.key);
+        _size -= entry.size;
+        delete entry.answset;
+        _entries.pop_back();
+    }
+}
+
+void QueryCache::clear() {
+    pthread_mutex_lock(&_lock);
+    for (Entry& entry : _entries) {
+        delete entry.answset;
+    }
+    _entries.clear();
+    _index.clear();
+    _size = 0;
+    pthread_mutex_unlock(&_lock);
+}
+
+uint64_t QueryCache::getHits() const {
+    pthread_mutex_lock(&_lock);
+    uint64_t hits = _hits;
+    pthread_mutex_unlock(&_lock);
+
+    return hits;
+}
+
+uint64_t QueryCache::getMisses() const {
+    pthread_mutex_lock(&_lock);
+    uint64_t misses = _misses;
+    pthread_mutex_unlock(&_lock);
+
+    return misses;
+}
+
+size_t QueryCache::getSize() const {
+    pthread_mutex_lock(&_lock);
+    size_t size = _size;
+    pthread_mutex_unlock(&_lock);
+
+    return size;
+}
+
+}  // namespace query
+}  // namespace mws
@@ -0,0 +1,117 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_QUERY_QUERYCACHE_HPP
+#define _MWS_QUERY_QUERYCACHE_HPP
+
+/**
+  * @brief File containing the header of the QueryCache class.
+  *
+  * @file QueryCache.hpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mws/index/encoded_token.h"
+#include "mws/types/MwsAnswset.hpp"
+#include "mws/types/MwsQuery.hpp"
+
+namespace mws {
+namespace query {
+
+/**
+  * @brief Least recently used answer sets, keyed by encoded query and the
+  * page of results requested. Safe to share between query threads.
+  */
+class QueryCache {
+ public:
+    /**
+      * @param capacity maximum number of bytes held by cached answer sets,
+      * 0 to disable the cache
+      */
+    explicit QueryCache(size_t capacity);
+    ~QueryCache();
+
+    /**
+      * @brief Look up the answer set of a query
+      * @param encodedQuery query as encoded by the QueryEncoder
+      * @param query query requesting the page of results
+      * @return copy of the cached answer set, to be deleted by the caller,
+      * or NULL on a miss. Queries which differ only in the names of their
+      * qvars share an encoding, so the qvars of the copy are those of the
+      * query which was cached.
+      */
+    MwsAnswset* get(const std::vector<encoded_token_t>& encodedQuery,
+                    const MwsQuery& query);
+
+    /**
+      * @brief Cache a copy of the answer set of a query, evicting least
+      * recently used answer sets to make room.
+      */
+    void put(const std::vector<encoded_token_t>& encodedQuery,
+             const MwsQuery& query, const MwsAnswset& answset);
+
+    /// Drop every cached answer set, when the index they come from changes
+    void clear();
+
+    uint64_t getHits() const;
+    uint64_t getMisses() const;
+    /// @return number of bytes held by cached answer sets
+    size_t getSize() const;
+
+ private:
+    struct Entry {
+        std::string key;
+        MwsAnswset* answset;
+        size_t size;
+    };
+    typedef std::list<Entry> EntryList;
+
+    static std::string makeKey(const std::vector<encoded_token_t>& encodedQuery,
+                               const MwsQuery& query);
+    void evict(size_t size);
+
+    const size_t _capacity;
+    size_t _size;
+    uint64_t _hits;
+    uint64_t _misses;
+    /// Most recently used first
+    EntryList _entries;
+    std::unordered_map<std::string, EntryList::iterator> _index;
+    mutable pthread_mutex_t _lock;
+
+    QueryCache(const QueryCache&);
+    QueryCache& operator=(const QueryCache&);
+};
+
+}  // namespace query
+}  // namespace mws
+
+#endif  // _MWS_QUERY_QUERYCACHE_HPP
@@ -28,6 +28,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   *
   */
 
+#include <algorithm>
 #include <list>
 using std::list;
 #include <map>
@@ -43,11 +44,7 @@ using std::vector;
 using mws::index::TmpIndexAccessor;
 #include "mws/index/IndexAccessor.hpp"
 using mws::index::IndexAccessor;
-#include "mws/types/FormulaPath.hpp"
-using mws::types::FormulaPath;
-using mws::types::FormulaId;
-#include "mws/dbc/CrawlDb.hpp"
-using mws::dbc::CrawlData;
+#include "mws/query/MatchList.hpp"
 #include "mws/query/SearchContext.hpp"
 
 namespace mws {
@@ -69,9 +66,9 @@ struct qvarCtxt {
         int totalArrity = 1;
         while (totalArrity > 0) {
             typename Accessor::Iterator begin =
-                    Accessor::getChildrenBegin(node);
+                    Accessor::getChildrenBegin(index, node);
             typename Accessor::Iterator end =
-                    Accessor::getChildrenEnd(node);
+                    Accessor::getChildrenEnd(index, node);
             if (begin == end) {
                 backtrackIterators.clear();
                 return NULL;
@@ -107,9 +104,9 @@ struct qvarCtxt {
                 Accessor::getNode(index, backtrackIterators.back().first);
         while (totalArrity) {
             typename Accessor::Iterator begin =
-                    Accessor::getChildrenBegin(currentNode);
+                    Accessor::getChildrenBegin(index, currentNode);
             typename Accessor::Iterator end =
-                    Accessor::getChildrenEnd(currentNode);
+                    Accessor::getChildrenEnd(index, currentNode);
             backtrackIterators.push_back(std::make_pair(begin, end));
             // Updating currentNode and arrity
             currentNode = Accessor::getNode(index, begin);
@@ -158,6 +155,16 @@ SearchContext(const vector<encoded_token_t>& encodedFormula) {
     }
 
     mQvarCount = qvarCount;
+
+    vector<int> qvarOccurrences(qvarCount, 0);
+    for (const NodeTriple& triple : expr) {
+        if (triple.isQvar) qvarOccurrences[triple.arity]++;
+    }
+    unconstrainedFrom = expr.size();
+    while (unconstrainedFrom > 0 && expr[unconstrainedFrom - 1].isQvar &&
+           qvarOccurrences[expr[unconstrainedFrom - 1].arity] == 1) {
+        unconstrainedFrom--;
+    }
 }
 
 
@@ -166,30 +173,21 @@ SearchContext::~SearchContext()
     // Nothing to do here
 }
 
-template<class A /* Accessor */>
-MwsAnswset*
-SearchContext::getResult(typename A::Index* index,
-                         dbc::DbQueryManager* dbQueryManger,
-                         unsigned int offset,
-                         unsigned int size,
-                         unsigned int maxTotal) {
+template<class A /* Accessor */, class MatchHandler>
+unsigned int
+SearchContext::walk(typename A::Index* index,
+                    unsigned int windowBegin,
+                    unsigned int windowEnd,
+                    unsigned int maxTotal,
+                    MatchHandler onMatch) {
     // Table containing resolved Qvar and backtrack points
     vector<qvarCtxt<A> > qvarTable;
 
-    MwsAnswset* result = new MwsAnswset;
     size_t currentToken = 0;            // index for the expression vector
     unsigned int  found = 0;            // # of found matches
     int lastSolvedQvar = -1;            // last qvar that was solved
     typename A::Node* currentNode = A::getRootNode(index);
-
-    // Checking the arguments
-    if (offset + size > maxTotal) {
-        if (maxTotal <= offset) {
-            size = 0;
-        } else {
-            size = maxTotal - offset;
-        }
-    }
+    const bool countSubtrees = A::hasSubtreeCounts(index);
 
     // Initializing the qvarTable
     qvarTable.resize(mQvarCount);
@@ -201,7 +199,15 @@ SearchContext::getResult(typename A::Index* index,
 
         // Evaluating current token and deciding if to go ahead or backtrack
         if (currentToken < expr.size()) {
-            if (expr[currentToken].isQvar) {
+            uint64_t subtreeHits = (countSubtrees &&
+                                    currentToken >= unconstrainedFrom) ?
+                    A::getSubtreeHitsCount(currentNode) : 0;
+            if (subtreeHits > 0 && (found >= windowEnd ||
+                                    found + subtreeHits <= windowBegin)) {
+                // Counting the solutions below, none of which is returned
+                found = std::min<uint64_t>(found + subtreeHits, maxTotal);
+                backtrack = true;
+            } else if (expr[currentToken].isQvar) {
                 int qvarId = expr[currentToken].arity;
                 if (qvarTable[qvarId].isSolved) {
                     for (auto it = qvarTable[qvarId].backtrackIterators.begin();
@@ -233,31 +239,9 @@ SearchContext::getResult(typename A::Index* index,
             }
         } else {
             // Handling the solutions
-            if (found < size + offset &&
-                found + A::getHitsCount(currentNode) > offset)
-            {
-                unsigned dbOffset;
-                unsigned dbMaxSize;
-                if (offset < found) {
-                    dbOffset = 0;
-                    dbMaxSize = size + offset - found;
-                } else {
-                    dbOffset = offset - found;
-                    dbMaxSize = size;
-                }
-                dbc::DbAnswerCallback callback =
-                        [result](const FormulaPath& formulaPath,
-                                 const CrawlData& crawlData) {
-                    mws::types::Answer* answer = new mws::types::Answer();
-                    answer->data = crawlData;
-                    answer->uri = formulaPath.xmlId;
-                    answer->xpath = formulaPath.xpath;
-                    result->answers.push_back(answer);
-                    return 0;
-                };
-
-                dbQueryManger->query(A::getFormulaId(currentNode), dbOffset,
-                                     dbMaxSize, callback);
+            if (found < windowEnd &&
+                found + A::getHitsCount(currentNode) > windowBegin) {
+                onMatch(currentNode, found);
             }
 
             found += A::getHitsCount(currentNode);
@@ -289,11 +273,53 @@ SearchContext::getResult(typename A::Index* index,
             currentToken++;
         }
     }
-    result->total = found;
+
+    return found;
+}
+
+template<class A /* Accessor */>
+MwsAnswset*
+SearchContext::getResult(typename A::Index* index,
+                         dbc::DbQueryManager* dbQueryManger,
+                         unsigned int offset,
+                         unsigned int size,
+                         unsigned int maxTotal) {
+    MwsAnswset* result = new MwsAnswset;
+
+    // Checking the arguments
+    if (offset + size > maxTotal) {
+        if (maxTotal <= offset) {
+            size = 0;
+        } else {
+            size = maxTotal - offset;
+        }
+    }
+
+    // the hits of the page are read from the databases at once
+    vector<dbc::FormulaQuery> formulaQueries;
+    result->total = walk<A>(index, offset, offset + size, maxTotal,
+                            [&](typename A::Node* node, unsigned int found) {
+        formulaQueries.push_back(pageFormulaQuery(A::getFormulaId(node),
+                                                  found, offset, size));
+    });
+    queryPageAnswers(dbQueryManger, formulaQueries, result);
 
     return result;
 }
 
+template<class A /* Accessor */>
+MatchList*
+SearchContext::getMatches(typename A::Index* index, unsigned int maxTotal) {
+    MatchList* matches = new MatchList;
+
+    matches->setTotal(walk<A>(index, 0, maxTotal, maxTotal,
+                              [&](typename A::Node* node, unsigned int found) {
+        matches->add(A::getFormulaId(node), found);
+    }));
+
+    return matches;
+}
+
 // Declare specializations
 
 template MwsAnswset*
@@ -312,5 +338,15 @@ unsigned int offset,
 unsigned int size,
 unsigned int maxTotal);
 
+template MatchList*
+SearchContext::
+getMatches<TmpIndexAccessor>(TmpIndexAccessor::Index* index,
+unsigned int maxTotal);
+
+template MatchList*
+SearchContext::
+getMatches<IndexAccessor>(IndexAccessor::Index* index,
+unsigned int maxTotal);
+
 }  // namespace query
 }  // namespace mws
@@ -39,6 +39,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "mws/dbc/DbQueryManager.hpp"
 #include "mws/index/encoded_token.h"
+#include "mws/query/MatchList.hpp"
 #include "mws/types/CmmlToken.hpp"
 #include "mws/types/MwsAnswset.hpp"
 
@@ -58,6 +59,9 @@ class SearchContext {
     /// Qvar points in the Cmml Dfs Vector from where to backtrack. The
     /// vector starts with -1 to mark the beginning
     std::vector<int> backtrackPoints;
+    /// Start of the trailing qvars occurring only once, which match any
+    /// subterms: all leaves below the node they start at are solutions
+    size_t unconstrainedFrom;
 
 public:
     /**
@@ -89,6 +93,31 @@ public:
                                unsigned int aSize,
                                unsigned int aMaxTotal);
 
+    /**
+      * @brief Method to list the formulae matching the search context, from
+      * which any page of results can be answered.
+      * @param aNode is the index node where to start.
+      * @param aMaxTotal is the maximum number of solutions to count.
+      * @return the matching formulae, in the order getResult returns them.
+      */
+    template<class Accessor>
+    MatchList* getMatches(typename Accessor::Index* aNode,
+                          unsigned int aMaxTotal);
+
+private:
+    /**
+      * @brief Walk the solutions, calling onMatch(leaf, found) for the
+      * leaves with hits in [windowBegin, windowEnd), where found is the
+      * number of hits before the leaf. Subtrees with no hits in the window
+      * are only counted, if the index stores subtree counts.
+      * @return the number of hits, up to maxTotal.
+      */
+    template<class Accessor, class MatchHandler>
+    unsigned int walk(typename Accessor::Index* index,
+                      unsigned int windowBegin,
+                      unsigned int windowEnd,
+                      unsigned int maxTotal,
+                      MatchHandler onMatch);
 };
 
 }  // namespace query
@@ -0,0 +1,69 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief querySegments implementation
+  * @file SegmentedQuery.cpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <algorithm>
+
+#include "mws/query/SegmentedQuery.hpp"
+
+namespace mws {
+namespace query {
+
+MwsAnswset* querySegments(size_t numSegments,
+                          unsigned int offset, unsigned int size,
+                          unsigned int maxTotal,
+                          const SegmentQuery& querySegment) {
+    MwsAnswset* result = new MwsAnswset;
+    unsigned int end = (offset + size > maxTotal) ? maxTotal : offset + size;
+    unsigned int total = 0;
+
+    for (size_t i = 0; i < numSegments && total < maxTotal; i++) {
+        // hits of the previous segments
+        unsigned int before = total;
+        unsigned int segmentOffset = std::max(offset, before) - before;
+        unsigned int segmentEnd = std::max(end, before) - before;
+        unsigned int segmentSize = (segmentEnd > segmentOffset) ?
+                segmentEnd - segmentOffset : 0;
+
+        MwsAnswset* segmentResult = querySegment(i, segmentOffset,
+                                                 segmentSize,
+                                                 maxTotal - before);
+        total += segmentResult->total;
+        result->answers.insert(result->answers.end(),
+                               segmentResult->answers.begin(),
+                               segmentResult->answers.end());
+        // the answers now belong to result
+        segmentResult->answers.clear();
+        delete segmentResult;
+    }
+    result->total = std::min(total, maxTotal);
+
+    return result;
+}
+
+}  // namespace query
+}  // namespace mws
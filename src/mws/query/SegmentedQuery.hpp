@@ -0,0 +1,74 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_QUERY_SEGMENTEDQUERY_HPP
+#define _MWS_QUERY_SEGMENTEDQUERY_HPP
+
+/**
+  * @brief Answering queries on an index made of several segments
+  *
+  * @file SegmentedQuery.hpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <stddef.h>
+
+#include <functional>
+
+#include "mws/types/MwsAnswset.hpp"
+
+namespace mws {
+namespace query {
+
+/**
+  * @brief Answer a page of results of one segment
+  * @param segment is the position of the segment.
+  * @param offset is the offset where to start returning the solutions.
+  * @param size is the maximum number of solutions to return.
+  * @param maxTotal is the maximum number of solutions to count.
+  * @return an answer set allocated with new, as SearchContext::getResult
+  */
+typedef std::function<MwsAnswset*(size_t segment, unsigned int offset,
+                                  unsigned int size, unsigned int maxTotal)>
+SegmentQuery;
+
+/**
+  * @brief Answer a page of results of segments whose hits are concatenated
+  * in segment order: the hits of a segment follow those of the previous
+  * ones. Segments past the page are only counted, and none is queried
+  * once maxTotal hits are counted.
+  * @param numSegments is the number of segments.
+  * @param offset is the offset where to start returning the solutions.
+  * @param size is the maximum number of solutions to return.
+  * @param maxTotal is the maximum number of solutions to count.
+  * @param querySegment answers the part of the page in a segment.
+  * @return an answer set with the corresponding results.
+  */
+MwsAnswset* querySegments(size_t numSegments,
+                          unsigned int offset, unsigned int size,
+                          unsigned int maxTotal,
+                          const SegmentQuery& querySegment);
+
+}  // namespace query
+}  // namespace mws
+
+#endif  // _MWS_QUERY_SEGMENTEDQUERY_HPP
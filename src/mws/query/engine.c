@@ -88,8 +88,8 @@ typedef struct query_ctxt_s {
     /* var solve stack */
     uint32_t solving_var_id;
 
-    /* index allocator */
-    const memsector_alloc_header_t* alloc;
+    /* index, with its allocator and layout of nodes */
+    const index_handle_t* index;
 
     /* result callback */
     result_callback_t result_cb;
@@ -162,8 +162,8 @@ void query_ctxt_init(query_ctxt_t* RESTRICT      query_ctxt,
     query_ctxt->curr_index_inode = index->root;
     query_ctxt->index_stack.size = 0;
 
-    // initialize memsector alloc
-    query_ctxt->alloc = index->alloc;
+    // initialize index
+    query_ctxt->index = index;
 
     // initialize result callback data
     query_ctxt->result_cb = result_cb;
@@ -236,10 +236,13 @@ int process_query_token(query_ctxt_t* RESTRICT query_ctxt) {
             token_stack_push(&query_ctxt->index_stack, index_token);
         } else {  // regular index
             const inode_t* curr = query_ctxt->curr_index_inode;
-            memsector_off_t off = inode_get_child(curr, query_token);
+            memsector_off_t off =
+                    inode_get_child(query_ctxt->index, curr, query_token);
             if (off != MEMSECTOR_OFF_NULL) {  // move to corresponding child
                 const inode_t* child =
-                        (inode_t*) memsector_off2addr(query_ctxt->alloc, off);
+                        (inode_t*) memsector_off2addr(
+                                query_ctxt->index->alloc,
+                                query_ctxt->index->off_shift, off);
 
                 query_ctxt->curr_index_inode = child;
 
@@ -255,7 +258,8 @@ int process_query_token(query_ctxt_t* RESTRICT query_ctxt) {
 
                 // hvars
                 uint32_t hvar_id_max =
-                        inode_get_max_var(query_ctxt->curr_index_inode);
+                        inode_get_max_var(query_ctxt->curr_index_inode,
+                                          query_ctxt->index->format);
                 uint32_t hvar_id;
                 for (hvar_id = 0; hvar_id < hvar_id_max; hvar_id++) {
                     query_ctxt->solving_var_id = hvar_id;
@@ -294,16 +298,16 @@ int match_var_to_index(query_ctxt_t* RESTRICT query_ctxt, uint32_t arity) {
         return match_var_to_stack(query_ctxt, &query_ctxt->index_stack);
     } else {  // regular index
         uint32_t i;
-        uint32_t size = query_ctxt->curr_index_inode->size;
-        const encoded_token_dict_entry_t* data =
-                query_ctxt->curr_index_inode->data;
+        const inode_t* inode = query_ctxt->curr_index_inode;
+        uint32_t size = inode->size;
 
         for (i = 0; i < size; ++i) {
-            const encoded_token_dict_entry_t* entry = &data[i];
+            const encoded_token_t entry_token =
+                    inode_get_token(inode, query_ctxt->index->format, i);
             int pushed_var_tokens = 0;
             token_stack_t var_stack;
             var_stack.size = 0;
-            token_stack_push(&var_stack, entry->token);
+            token_stack_push(&var_stack, entry_token);
 
             while (!token_stack_empty(&var_stack)) {
                 encoded_token_t token = token_stack_pop(&var_stack);
@@ -343,12 +347,15 @@ int match_var_to_index(query_ctxt_t* RESTRICT query_ctxt, uint32_t arity) {
             // advance in the index
             const inode_t* curr = query_ctxt->curr_index_inode;
             const inode_t* child = (inode_t*)
-                    memsector_off2addr(query_ctxt->alloc, entry->off);
+                    memsector_off2addr(query_ctxt->index->alloc,
+                                       query_ctxt->index->off_shift,
+                                       inode_get_off(query_ctxt->index, inode,
+                                                     i));
             query_ctxt->curr_index_inode = child;
 
             // continue
             ret = match_var_to_index(query_ctxt,
-                                     arity + entry->token.arity - 1);
+                                     arity + entry_token.arity - 1);
             if (ret != QUERY_CONTINUE) return ret;
 
 revert_index:
@@ -22,7 +22,7 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #define _MWS_VECTORMAP_HPP
 
 /**
-  * @brief  Map with vector container
+  * @brief  Map with arena-backed array container
   * @file   VectorMap.hpp
   * @author Corneliu-Claudiu Prodescu <c.prodescu@jacobs-university.de>
   * @date   07 Jul 2011
@@ -32,41 +32,61 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   */
 
 // System includes
-#include <utility>                     // STL utilities (std::air)
-#include <vector>                      // STL vector container
+#include <stdint.h>
+#include <string.h>
+#include <utility>                     // STL utilities (std::pair)
 
+#include "common/utils/Arena.hpp"
 #include "common/utils/util.hpp"
 namespace mws
 {
 
-template<class T>
+template<class K>
 struct Comparator
 {
-    static inline int compare(const T& t1, const T& t2) {
+    static inline int compare(const K& t1, const K& t2) {
         return memcmp(&t1, &t2, sizeof(t1));
     }
 };
 
 
+/**
+  * @brief Sorted map stored as an array allocated from an Arena. A single
+  * element is stored inline; larger maps use an array whose capacity is the
+  * next power of two, so no capacity needs to be stored. K and V must be
+  * trivially copyable, as elements are never constructed or destructed.
+  */
 template<class K, class V>
 class VectorMap
 {
     // Typedefs
 public:
-    typedef std::pair<K, V>                                   key_value;
-    typedef typename std::vector< key_value >::iterator       iterator;
-    typedef typename std::vector< key_value >::const_iterator const_iterator;
-private:
-    typedef typename std::vector< key_value >                 _VectorContainer;
+    struct key_value {
+        K first;
+        V second;
+    };
+    typedef key_value*                                        iterator;
+    typedef const key_value*                                  const_iterator;
 
     // Data Members
 private:
-    _VectorContainer                                          _data;
+    union {
+        key_value   _single;
+        key_value*  _array;
+    };
+    uint32_t        _size;
     // Methods
     ALLOW_TESTER_ACCESS;
+
+    static inline bool isPowerOfTwo(uint32_t n) {
+        return (n & (n - 1)) == 0;
+    }
 public:
+    VectorMap() : _size(0) {
+    }
+
     inline size_t size() const {
-        return _data.size();
+        return _size;
     }
     /**
       * @brief Method to find an element by key.
@@ -77,22 +97,23 @@ public:
     inline iterator
     find(const K& key)
     {
+        iterator data = begin();
         int left, right;
 
         left = 0;
-        right = _data.size() - 1;
+        right = _size - 1;
 
         while(left <= right)
         {
             size_t center = left + (right - left) / 2;
-            int    result = Comparator<K>::compare(_data[center].first, key);
+            int    result = Comparator<K>::compare(data[center].first, key);
             if (result > 0)
             {
                 right = center - 1;
             }
             else if (result == 0)
             {
-                return _data.begin() + center;
+                return data + center;
             }
             else
             {
@@ -100,51 +121,64 @@ public:
             }
         }
 
-        return _data.end();
+        return end();
     }
 
     /**
       * @brief Method to insert a key-value pair into the Map. If the key
       * already exists, nothing is inserted.
-      * @param keyValue is the pair to be inserted.
+      * @param key is the key to be inserted.
+      * @param value is the value to be inserted.
+      * @param arena where the elements are allocated
       * @return a pair containing an iterator to the inserted (or existing) key
       * and a boolean showing if a new pair was inserted.
       */
     inline std::pair<iterator, bool>
-    insert(const key_value& keyValue)
+    insert(const K& key, const V& value, common::utils::Arena* arena)
     {
         iterator it;
 
-        it = find(keyValue.first);
-        // If the element is not present, we need to insert it
-        if (it == end())
+        it = find(key);
+        // If the element is present, we return it
+        if (it != end())
         {
-            size_t i;
+            return std::make_pair(it, false);
+        }
 
-            // Inserting the data
-            _data.push_back(keyValue);
+        if (_size == 0)
+        {
+            _single.first = key;
+            _single.second = value;
+            _size = 1;
+            return std::make_pair(begin(), true);
+        }
 
-            // Re-ordering the vector
-            i = _data.size() - 1;
-            while ((i > 0) &&
-                   (Comparator<K>::compare(_data[i].first,_data[i-1].first) < 0))
+        // Growing the array when full (the inline element counts as full)
+        if (isPowerOfTwo(_size))
+        {
+            key_value* array = (key_value*)
+                    arena->allocate(2 * _size * sizeof(key_value));
+            memcpy(array, begin(), _size * sizeof(key_value));
+            if (_size > 1)
             {
-                key_value tmp;
-
-                tmp        = _data[i];
-                _data[i]   = _data[i-1];
-                _data[i-1] = tmp;
-
-                i--;
+                arena->release(_array, _size * sizeof(key_value));
             }
-        
-            return make_pair(_data.begin() + i, true);
+            _array = array;
         }
-        // Otherwise we return
-        else
+
+        // Shifting greater elements to make room for the new one
+        size_t i = _size;
+        while ((i > 0) &&
+               (Comparator<K>::compare(_array[i-1].first, key) > 0))
         {
-            return make_pair(it, false);
+            _array[i] = _array[i-1];
+            i--;
         }
+        _array[i].first = key;
+        _array[i].second = value;
+        _size++;
+
+        return std::make_pair(_array + i, true);
     }
 
     /**
@@ -154,7 +188,7 @@ public:
     inline iterator
     begin()
     {
-        return _data.begin();
+        return (_size <= 1) ? &_single : _array;
     }
 
     /**
@@ -164,17 +198,17 @@ public:
     inline iterator
     end()
     {
-        return _data.end();
+        return begin() + _size;
     }
 
     inline const_iterator
     begin() const {
-        return _data.begin();
+        return (_size <= 1) ? &_single : _array;
     }
 
     inline const_iterator
     end() const {
-        return _data.end();
+        return begin() + _size;
     }
 };
 
@@ -0,0 +1,56 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief   AnswsetWriter implementation
+  * @file    AnswsetWriter.cpp
+  * @date    18 Oct 2026
+  *
+  */
+
+#include <stdio.h>
+
+#include <string>
+using std::string;
+
+#include "mws/xmlparser/AnswsetWriter.hpp"
+
+namespace mws {
+namespace xmlparser {
+
+int AnswsetWriter::writeAll(FILE* file) {
+    string piece;
+    int total_bytes_written = 0;
+    int ret;
+
+    while ((ret = writeNext(&piece)) == 1) {
+        if (fwrite(piece.data(), sizeof(char), piece.size(), file)
+                != piece.size()) {
+            return -1;
+        }
+        total_bytes_written += piece.size();
+        piece.clear();
+    }
+
+    return (ret == 0) ? total_bytes_written : -1;
+}
+
+}  // namespace xmlparser
+}  // namespace mws
@@ -0,0 +1,69 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_XMLPARSER_ANSWSETWRITER_HPP
+#define _MWS_XMLPARSER_ANSWSETWRITER_HPP
+
+/**
+  * @brief   File containing the header of the AnswsetWriter class
+  *
+  * @file    AnswsetWriter.hpp
+  * @date    18 Oct 2026
+  *
+  * License: GPL v3
+  *
+  */
+
+#include <stdio.h>
+
+#include <string>
+
+#include "mws/types/MwsAnswset.hpp"    // MWS Answer Set datatype header
+
+namespace mws {
+namespace xmlparser {
+
+/**
+  * @brief Serializer of a MwsAnswset writing its document one piece at a
+  * time (the header, an answer, the footer), so that it can be sent while
+  * it is being written.
+  */
+class AnswsetWriter {
+ public:
+    virtual ~AnswsetWriter() {}
+
+    /**
+      * @brief Append the next piece of the document to out.
+      * @return 1 if a piece was appended, 0 once the document is complete
+      * and -1 in case of failure.
+      */
+    virtual int writeNext(std::string* out) = 0;
+
+    /**
+      * @brief Write the rest of the document to a file.
+      * @return the number of bytes written to file or -1 in case of failure.
+      */
+    int writeAll(FILE* file);
+};
+
+}  // namespace xmlparser
+}  // namespace mws
+
+#endif  // _MWS_XMLPARSER_ANSWSETWRITER_HPP
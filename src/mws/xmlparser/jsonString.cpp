@@ -0,0 +1,129 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief   JSON string serializer implementation
+  * @file    jsonString.cpp
+  * @date    18 Oct 2026
+  *
+  */
+
+#include <stddef.h>
+
+#if defined(__SSE2__)
+#   define JSON_ESCAPE_SSE2
+#   include <emmintrin.h>
+#endif
+
+#include <string>
+using std::string;
+
+#include "mws/xmlparser/jsonString.hpp"
+
+namespace mws {
+namespace xmlparser {
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static inline bool needsEscape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\' || c == '/';
+}
+
+#ifdef JSON_ESCAPE_SSE2
+/**
+ * @return mask of the bytes among the 16 at str which need escaping
+ */
+static inline int escapeMask(const char* str) {
+    const __m128i block = _mm_loadu_si128((const __m128i*) str);
+    // bytes are unsigned: c < 0x20 iff min(c, 0x1f) == c
+    __m128i escape = _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(0x1f)),
+                                    block);
+    escape = _mm_or_si128(escape,
+                          _mm_cmpeq_epi8(block, _mm_set1_epi8('"')));
+    escape = _mm_or_si128(escape,
+                          _mm_cmpeq_epi8(block, _mm_set1_epi8('\\')));
+    escape = _mm_or_si128(escape,
+                          _mm_cmpeq_epi8(block, _mm_set1_epi8('/')));
+
+    return _mm_movemask_epi8(escape);
+}
+#endif  // JSON_ESCAPE_SSE2
+
+/**
+ * @brief Write the escape sequence of c at dst
+ * @return end of the escape sequence
+ */
+static inline char* writeEscaped(char* dst, unsigned char c) {
+    *dst++ = '\\';
+    switch (c) {
+    case '"':   *dst++ = '"';   break;
+    case '\\':  *dst++ = '\\';  break;
+    case '/':   *dst++ = '/';   break;
+    case '\b':  *dst++ = 'b';   break;
+    case '\t':  *dst++ = 't';   break;
+    case '\n':  *dst++ = 'n';   break;
+    case '\f':  *dst++ = 'f';   break;
+    case '\r':  *dst++ = 'r';   break;
+    default:
+        *dst++ = 'u';
+        *dst++ = '0';
+        *dst++ = '0';
+        *dst++ = HEX_DIGITS[c >> 4];
+        *dst++ = HEX_DIGITS[c & 0xf];
+        break;
+    }
+
+    return dst;
+}
+
+void appendJsonString(string* out, const char* str, size_t size) {
+    const char* end = str + size;
+    const char* curr = str;
+    char escaped[6];
+
+    // only escape sequences grow out beyond this
+    out->reserve(out->size() + size + 2);
+    out->push_back('"');
+    while (curr < end) {
+        // bytes up to the next one to escape are copied as they are
+        const char* run = curr;
+#ifdef JSON_ESCAPE_SSE2
+        while (end - curr >= 16) {
+            int mask = escapeMask(curr);
+            if (mask != 0) {
+                curr += __builtin_ctz(mask);
+                break;
+            }
+            curr += 16;
+        }
+#endif
+        while (curr < end && !needsEscape(*curr)) {
+            curr++;
+        }
+        out->append(run, curr - run);
+        if (curr < end) {
+            out->append(escaped, writeEscaped(escaped, *curr++) - escaped);
+        }
+    }
+    out->push_back('"');
+}
+
+}  // namespace xmlparser
+}  // namespace mws
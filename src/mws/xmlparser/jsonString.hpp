@@ -0,0 +1,58 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef _MWS_XMLPARSER_JSONSTRING_HPP
+#define _MWS_XMLPARSER_JSONSTRING_HPP
+
+/**
+  * @brief   File containing the header of the JSON string serializer
+  *
+  * @file    jsonString.hpp
+  * @date    18 Oct 2026
+  *
+  * License: GPL v3
+  *
+  */
+
+#include <stddef.h>
+
+#include <string>
+
+namespace mws {
+namespace xmlparser {
+
+/**
+  * @brief Append str to out as a quoted JSON string, escaped as json-c
+  * escapes it: '/' as "\/", control characters other than \b \t \n \f \r
+  * as "\u00XX" and other bytes as they are.
+  * @param out is the string to which to append.
+  * @param str is the string to be serialized.
+  * @param size is the number of bytes of str.
+  */
+void appendJsonString(std::string* out, const char* str, size_t size);
+
+inline void appendJsonString(std::string* out, const std::string& str) {
+    appendJsonString(out, str.data(), str.size());
+}
+
+}  // namespace xmlparser
+}  // namespace mws
+
+#endif  // _MWS_XMLPARSER_JSONSTRING_HPP
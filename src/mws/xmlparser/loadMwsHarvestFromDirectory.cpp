@@ -32,18 +32,22 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 // System includes
 
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <libxml/parser.h>
 
 #include <algorithm>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "common/utils/compiler_defs.h"
 #include "common/utils/Path.hpp"
 #include "common/utils/util.hpp"
 #include "mws/index/IndexManager.hpp"
 using mws::index::IndexingOptions;
+using mws::index::EncodedHarvest;
 #include "processMwsHarvest.hpp"
 
 
@@ -54,31 +58,205 @@ using namespace std;
 namespace mws {
 namespace parser {
 
+/// Number of encoded files each worker may be ahead of the merge stage
+#define ENCODED_FILES_PER_JOB   2
+
+struct EncodedFile {
+    EncodedHarvest harvest;
+    int returnValue;
+    bool openFailed;
+};
+
+/**
+ * @brief State shared between the encoding workers and the merge stage.
+ * Workers pick files in order and parse/encode them concurrently; the merge
+ * stage indexes them strictly in order, which keeps formula, crawl and
+ * meaning ids identical to a sequential load.
+ */
+struct ParallelLoadContext {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    const vector<string>* paths;
+    IndexingOptions indexingOptions;
+    /// Encoded files, NULL until encoded or after being merged
+    vector<EncodedFile*> encodedFiles;
+    /// Next file to be picked up by a worker
+    size_t nextToEncode;
+    /// Next file to be merged in the index
+    size_t nextToMerge;
+    /// Maximum number of files encoded ahead of the merge stage
+    size_t window;
+    bool aborted;
+};
+
+/**
+ * @brief load a harvest file in the index
+ * @return number of formulae loaded, or -1 if the file cannot be opened
+ */
+static int
+loadHarvestFile(mws::index::IndexManager* indexManager, const string& path) {
+    printf("Loading %s... ", path.c_str());
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    auto loadReturn = loadMwsHarvestFromFd(indexManager, fd);
+    if (loadReturn.first == 0) {
+        printf("%d loaded\n", loadReturn.second);
+    } else {
+        printf("%d loaded (with errors)\n", loadReturn.second);
+    }
+    close(fd);
+
+    return loadReturn.second;
+}
+
+static void*
+encodeHarvestsWorker(void* arg) {
+    ParallelLoadContext* ctxt = (ParallelLoadContext*) arg;
+
+    pthread_mutex_lock(&ctxt->lock);
+    while (true) {
+        while (!ctxt->aborted &&
+               ctxt->nextToEncode < ctxt->paths->size() &&
+               ctxt->nextToEncode >= ctxt->nextToMerge + ctxt->window) {
+            pthread_cond_wait(&ctxt->changed, &ctxt->lock);
+        }
+        if (ctxt->aborted || ctxt->nextToEncode >= ctxt->paths->size()) {
+            break;
+        }
+        size_t fileIndex = ctxt->nextToEncode++;
+        pthread_mutex_unlock(&ctxt->lock);
+
+        EncodedFile* encodedFile = new EncodedFile();
+        encodedFile->returnValue = -1;
+        encodedFile->openFailed = false;
+        int fd = open((*ctxt->paths)[fileIndex].c_str(), O_RDONLY);
+        if (fd < 0) {
+            encodedFile->openFailed = true;
+        } else {
+            auto ret = encodeMwsHarvestFromFd(ctxt->indexingOptions, fd,
+                                              &encodedFile->harvest);
+            encodedFile->returnValue = ret.first;
+            close(fd);
+        }
+
+        pthread_mutex_lock(&ctxt->lock);
+        ctxt->encodedFiles[fileIndex] = encodedFile;
+        pthread_cond_broadcast(&ctxt->changed);
+    }
+    pthread_mutex_unlock(&ctxt->lock);
+
+    return NULL;
+}
+
+static int
+loadMwsHarvestsInParallel(mws::index::IndexManager* indexManager,
+                          const vector<string>& paths,
+                          int numJobs) {
+    ParallelLoadContext ctxt;
+    vector<pthread_t> workers;
+    int totalLoaded = 0;
+
+    // libxml2 must be initialized by the main thread before parsing on
+    // worker threads
+    xmlInitParser();
+
+    pthread_mutex_init(&ctxt.lock, NULL);
+    pthread_cond_init(&ctxt.changed, NULL);
+    ctxt.paths = &paths;
+    ctxt.indexingOptions = indexManager->getIndexingOptions();
+    ctxt.encodedFiles.resize(paths.size(), NULL);
+    ctxt.nextToEncode = 0;
+    ctxt.nextToMerge = 0;
+    ctxt.window = numJobs * ENCODED_FILES_PER_JOB;
+    ctxt.aborted = false;
+
+    for (int i = 0; i < numJobs; i++) {
+        pthread_t worker;
+        int ret = pthread_create(&worker, NULL, encodeHarvestsWorker, &ctxt);
+        if (ret != 0) {
+            PRINT_WARN("Cannot start harvest worker: %s\n", strerror(ret));
+            break;
+        }
+        workers.push_back(worker);
+    }
+
+    if (workers.empty()) {
+        pthread_cond_destroy(&ctxt.changed);
+        pthread_mutex_destroy(&ctxt.lock);
+        PRINT_WARN("Loading harvests without workers\n");
+        for (const string& path : paths) {
+            int loaded = loadHarvestFile(indexManager, path);
+            if (loaded < 0) break;
+            totalLoaded += loaded;
+        }
+        return totalLoaded;
+    }
+
+    for (size_t i = 0; !ctxt.aborted && i < paths.size(); i++) {
+        EncodedFile* encodedFile;
+
+        pthread_mutex_lock(&ctxt.lock);
+        while (ctxt.encodedFiles[i] == NULL) {
+            pthread_cond_wait(&ctxt.changed, &ctxt.lock);
+        }
+        encodedFile = ctxt.encodedFiles[i];
+        ctxt.encodedFiles[i] = NULL;
+        ctxt.nextToMerge = i + 1;
+        if (encodedFile->openFailed) {
+            ctxt.aborted = true;
+        }
+        pthread_cond_broadcast(&ctxt.changed);
+        pthread_mutex_unlock(&ctxt.lock);
+
+        printf("Loading %s... ", paths[i].c_str());
+        if (!encodedFile->openFailed) {
+            int loaded = indexManager->indexEncodedHarvest(encodedFile->harvest);
+            if (encodedFile->returnValue == 0) {
+                printf("%d loaded\n", loaded);
+            } else {
+                printf("%d loaded (with errors)\n", loaded);
+            }
+            totalLoaded += loaded;
+        }
+        delete encodedFile;
+    }
+
+    for (pthread_t worker : workers) {
+        pthread_join(worker, NULL);
+    }
+    // Files encoded after an abort are never merged
+    for (EncodedFile* encodedFile : ctxt.encodedFiles) {
+        delete encodedFile;
+    }
+    pthread_cond_destroy(&ctxt.changed);
+    pthread_mutex_destroy(&ctxt.lock);
+
+    return totalLoaded;
+}
+
 int
 loadMwsHarvestFromDirectory(mws::index::IndexManager* indexManager,
                             mws::AbsPath const& dirPath,
                             const std::string& extension,
-                            bool recursive) {
+                            bool recursive,
+                            int numJobs) {
     int totalLoaded = 0;
+    vector<string> paths;
 
     common::utils::FileCallback fileCallback =
-            [&totalLoaded, indexManager, extension]
+            [&totalLoaded, &paths, indexManager, extension, numJobs]
             (const std::string& path, const std::string& prefix) {
         UNUSED(prefix);
-        if (common::utils::hasSuffix(path, extension)) {
-            printf("Loading %s... ", path.c_str());
-            int fd = open(path.c_str(), O_RDONLY);
-            if (fd < 0) {
+        if (common::utils::hasSuffix(path, extension) && numJobs > 1) {
+            paths.push_back(path);
+        } else if (common::utils::hasSuffix(path, extension)) {
+            int loaded = loadHarvestFile(indexManager, path);
+            if (loaded < 0) {
                 return -1;
             }
-            auto loadReturn = loadMwsHarvestFromFd(indexManager, fd);
-            if (loadReturn.first == 0) {
-                printf("%d loaded\n", loadReturn.second);
-            } else {
-                printf("%d loaded (with errors)\n", loadReturn.second);
-            }
-            totalLoaded += loadReturn.second;
-            close(fd);
+            totalLoaded += loaded;
         } else {
             printf("Skipping \"%s\": bad extension\n", path.c_str());
         }
@@ -102,6 +280,10 @@ loadMwsHarvestFromDirectory(mws::index::IndexManager* indexManager,
     }
 
 fail:
+    if (numJobs > 1) {
+        // Harvests collected before a failure are loaded, as sequentially
+        totalLoaded = loadMwsHarvestsInParallel(indexManager, paths, numJobs);
+    }
     return totalLoaded;
 }
 
@@ -42,6 +42,7 @@ using std::pair;
 using mws::dbc::CrawlId;
 #include "mws/index/IndexManager.hpp"
 using mws::index::IndexingOptions;
+using mws::index::EncodedHarvest;
 #include "mws/types/CmmlToken.hpp"
 using mws::types::CmmlToken;
 #include "common/utils/compiler_defs.h"
@@ -78,6 +79,44 @@ CrawlId HarvestIndexer::processData(const string &data) {
 }
 
 
+class HarvestEncodingProcessor : public HarvestProcessor {
+ public:
+    int processExpression(const CmmlToken *tok,
+                          const string &exprUri, const uint32_t &crawlId);
+    CrawlId processData(const string &data);
+    HarvestEncodingProcessor(const IndexingOptions& indexingOptions,
+                             EncodedHarvest* encodedHarvest);
+ private:
+    IndexingOptions indexingOptions;
+    EncodedHarvest* encodedHarvest;
+};
+
+HarvestEncodingProcessor::HarvestEncodingProcessor(
+        const IndexingOptions& indexingOptions,
+        EncodedHarvest* encodedHarvest) :
+    indexingOptions(indexingOptions), encodedHarvest(encodedHarvest) {
+}
+
+int HarvestEncodingProcessor::processExpression(const CmmlToken* token,
+                                                const string& exprUri,
+                                                const uint32_t& crawlId) {
+    EncodedHarvest::Expression expression;
+    expression.xmlId = exprUri;
+    expression.crawlId = crawlId;
+    IndexManager::encodeContentMath(indexingOptions,
+                                    &encodedHarvest->meaningDictionary,
+                                    token, &expression.formulae);
+    encodedHarvest->expressions.push_back(expression);
+
+    return encodedHarvest->expressions.back().formulae.size();
+}
+
+CrawlId HarvestEncodingProcessor::processData(const string &data) {
+    encodedHarvest->crawlData.push_back(data);
+    return encodedHarvest->crawlData.size();
+}
+
+
 pair<int,int>
 loadMwsHarvestFromFd(mws::index::IndexManager *indexManager, int fd) {
     HarvestProcessor* harvestIndexer = new HarvestIndexer(indexManager);
@@ -87,5 +126,13 @@ loadMwsHarvestFromFd(mws::index::IndexManager *indexManager, int fd) {
     return ret;
 }
 
+pair<int,int>
+encodeMwsHarvestFromFd(const IndexingOptions& indexingOptions, int fd,
+                       EncodedHarvest* encodedHarvest) {
+    HarvestEncodingProcessor harvestEncoder(indexingOptions, encodedHarvest);
+
+    return processMwsHarvest(fd, &harvestEncoder);
+}
+
 }  // namespace parser
 }  // namespace mws
@@ -515,8 +515,8 @@ processMwsHarvest(int fd, HarvestProcessor* harvestProcessor) {
     saxHandler.error         = my_error;
     saxHandler.fatalError    = my_fatalError;
 
-    // Locking libXML -- to allow multi-threaded use
-    xmlLockLibrary();
+    // Parser contexts are not shared, so harvests can be parsed concurrently
+    // once the library was initialized (see initxmlparser)
     // Creating the IOParser context
     if ((ctxtPtr = xmlCreateIOParserCtxt(&saxHandler,
                                          &user_data,
@@ -538,9 +538,6 @@ processMwsHarvest(int fd, HarvestProcessor* harvestProcessor) {
         xmlFreeParserCtxt(ctxtPtr);
     }
 
-    // Unlocking libXML -- to allow multi-threaded use
-    xmlUnlockLibrary();
-
     return make_pair(ret, user_data.parsedExpr);
 }
 
@@ -83,11 +83,34 @@ processMwsHarvest(int fd, HarvestProcessor* harvestProcessor);
 std::pair<int, int>
 loadMwsHarvestFromFd(index::IndexManager* indexManager, int fd);
 
+/** @brief Function to parse and encode a MwsHarvest from a file descriptor,
+  * without touching the index. The result can be merged in the index later
+  * with IndexManager::indexEncodedHarvest().
+  * @param indexingOptions
+  * @param fd is the file descriptor from where to read.
+  * @param encodedHarvest where to store the encoded harvest.
+  * @return a pair with an exit code (0 on success and -1 on failure) and
+  * the number of encoded subexpressions.
+  */
+std::pair<int, int>
+encodeMwsHarvestFromFd(const index::IndexingOptions& indexingOptions, int fd,
+                       index::EncodedHarvest* encodedHarvest);
 
+/** @brief Function to load all MwsHarvest files from a directory.
+  * @param indexManager
+  * @param dirPath directory containing the harvests
+  * @param extension extension of the harvest files
+  * @param recursive whether to descend in subdirectories
+  * @param numJobs number of threads parsing and encoding harvests. Files are
+  * merged in the index in directory order, so the resulting index does not
+  * depend on numJobs.
+  * @return the number of loaded subexpressions
+  */
 int loadMwsHarvestFromDirectory(mws::index::IndexManager* indexManager,
                                 const mws::AbsPath& dirPath,
                                 const std::string& extension,
-                                bool recursive);
+                                bool recursive,
+                                int numJobs = 1);
 
 }  // namespace parser
 }  // namespace mws
@@ -59,17 +59,6 @@ using namespace mws;
 using namespace mws::types;
 
 
-/**
-  * @brief Callback function used to be used with an IO context parser
-  *
-  */
-static inline int
-fileInputReadCallback(void* file,
-                      char* buffer,
-                      int   len) {
-    return fread(buffer, sizeof(char), len, (FILE *) file);
-}
-
 /**
   * @brief This function is called before the SAX handler starts parsing the
   * document
@@ -323,11 +312,9 @@ my_fatalError(void*       user_data,
 namespace mws {
 namespace xmlparser {
 
-MwsQuery* readMwsQuery(FILE* file) {
-    MwsQuery_SaxUserData user_data;
-    xmlSAXHandler        saxHandler;
-    xmlParserCtxtPtr     ctxtPtr;
-    int                  ret;
+MwsQueryReader::MwsQueryReader() :
+    _userData(new MwsQuery_SaxUserData()), _ctxt(NULL) {
+    xmlSAXHandler saxHandler;
 
     // Initializing the SAX Handler
     memset(&saxHandler, 0, sizeof(saxHandler));
@@ -346,34 +333,74 @@ MwsQuery* readMwsQuery(FILE* file) {
     // Locking libXML -- to allow multi-threaded use
     xmlLockLibrary();
 
-    // Creating the IOParser context
-    ctxtPtr = xmlCreateIOParserCtxt(&saxHandler,
-                                    &user_data,
-                                    fileInputReadCallback,
-                                    NULL,
-                                    file,
-                                    XML_CHAR_ENCODING_UTF8);
-    if (ctxtPtr == NULL) {
+    // Creating the push parser context, the handler is copied
+    _ctxt = xmlCreatePushParserCtxt(&saxHandler, _userData,
+                                    /* chunk = */ NULL, /* size = */ 0,
+                                    /* filename = */ NULL);
+    if (_ctxt == NULL) {
         PRINT_WARN("Error while creating the ParserContext\n");
+    }
+
+    // Unlocking libXML -- to allow multi-threaded use
+    xmlUnlockLibrary();
+}
+
+MwsQueryReader::~MwsQueryReader() {
+    if (_ctxt != NULL) {
+        xmlLockLibrary();
+        xmlFreeParserCtxt(_ctxt);
         xmlUnlockLibrary();
-        return NULL;
     }
+    // state left by a query which was not finished
+    delete _userData->currentTokenRoot;
+    delete _userData->result;
+    delete _userData;
+}
+
+int MwsQueryReader::push(const char* chunk, size_t size) {
+    int ret;
 
-    ret = xmlParseDocument(ctxtPtr);
-    if (ret == -1) {
+    if (_ctxt == NULL) return -1;
+
+    xmlLockLibrary();
+    ret = xmlParseChunk(_ctxt, chunk, size, /* terminate = */ 0);
+    xmlUnlockLibrary();
+
+    return (ret == 0 && _ctxt->wellFormed) ? 0 : -1;
+}
+
+MwsQuery* MwsQueryReader::finish() {
+    MwsQuery* result;
+
+    if (_ctxt == NULL) return NULL;
+
+    xmlLockLibrary();
+    if (xmlParseChunk(_ctxt, NULL, 0, /* terminate = */ 1) != 0) {
         PRINT_WARN("Parsing failed\n");
     }
-    if (!ctxtPtr->wellFormed) {
+    xmlUnlockLibrary();
+
+    result = _userData->result;
+    _userData->result = NULL;
+    if (!_ctxt->wellFormed) {
         PRINT_WARN("Bad XML document\n");
+        delete result;
+        result = NULL;
     }
 
-    // Freeing the parser context
-    xmlFreeParserCtxt(ctxtPtr);
+    return result;
+}
 
-    // Unlocking libXML -- to allow multi-threaded use
-    xmlUnlockLibrary();
+MwsQuery* readMwsQuery(FILE* file) {
+    MwsQueryReader reader;
+    char buffer[BUFSIZ];
+    size_t nbytes;
+
+    while ((nbytes = fread(buffer, sizeof(char), sizeof(buffer), file)) > 0) {
+        if (reader.push(buffer, nbytes) != 0) break;
+    }
 
-    return user_data.result;
+    return reader.finish();
 }
 
 }  // namespace xmlparser
@@ -35,12 +35,48 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   *
   */
 
+#include <stddef.h>
 #include <stdio.h>
 #include "mws/types/MwsQuery.hpp"
 
+struct _xmlParserCtxt;
+
 namespace mws {
+
+struct MwsQuery_SaxUserData;
+
 namespace xmlparser {
 
+/**
+  * @brief Reader of a MwsQuery parsing its XML incrementally, as chunks of
+  * it arrive.
+  */
+class MwsQueryReader {
+ public:
+    MwsQueryReader();
+    ~MwsQueryReader();
+
+    /**
+      * @brief Parse the next chunk of the query.
+      * @return 0 on success, -1 if the query is malformed.
+      */
+    int push(const char* chunk, size_t size);
+
+    /**
+      * @brief Parse the end of the query.
+      * @return a pointer to a MwsQuery containing the information read, to
+      * be deleted by the caller, or NULL in case of failure.
+      */
+    mws::MwsQuery* finish();
+
+ private:
+    MwsQuery_SaxUserData* _userData;
+    struct _xmlParserCtxt* _ctxt;
+
+    MwsQueryReader(const MwsQueryReader&);
+    MwsQueryReader& operator=(const MwsQueryReader&);
+};
+
 /**
   * @brief Function to read a MwsQuery from an input file descriptor.
   * @param file is the file from where to read.
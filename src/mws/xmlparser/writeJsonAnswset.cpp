@@ -32,14 +32,11 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   *
   */
 
-#include <unistd.h>
-#include <json.h>
 #include <stdio.h>
 
-#include <sstream>
-#include <vector>
 #include <string>
 
+#include "mws/xmlparser/jsonString.hpp"
 #include "writeJsonAnswset.hpp"
 
 using namespace std;
@@ -48,69 +45,66 @@ using namespace mws;
 namespace mws
 {
 
-int
-writeJsonAnswset(mws::MwsAnswset* answset, FILE* file)
-{
-    const char*                data;
-    size_t                     data_size;
-    size_t                     bytes_written;
-    json_object *json_doc, *qvars, *hits;
-
-    json_doc = json_object_new_object();
-    qvars = json_object_new_array();
-    hits = json_object_new_array();
-
-    json_object_object_add(json_doc, "total",
-                           json_object_new_int(answset->total));
-
-    // Creating qvars field
-    for (int i = 0; i < (int) answset->qvarNames.size(); i++) {
-        json_object *qvar = json_object_new_object();
-        json_object_object_add(qvar, "name",
-                json_object_new_string(answset->qvarNames[i].c_str()));
-        json_object_object_add(qvar, "xpath",
-                json_object_new_string(answset->qvarXpaths[i].c_str()));
-
-        json_object_array_add(qvars, qvar);
-    }
-
-    json_object_object_add(json_doc, "qvars", qvars);
-
-    // Creating hits field
-    for (auto answer : answset->answers) {
-        json_object *hit = json_object_new_object();
-        json_object *math_ids = json_object_new_array();
-        json_object *math_id = json_object_new_object();
-        json_object_object_add(math_id, "url",
-                               json_object_new_string(answer->uri.c_str()));
-        json_object_object_add(math_id, "xpath",
-                               json_object_new_string(answer->xpath.c_str()));
-        json_object_array_add(math_ids, math_id);
-        json_object_object_add(hit, "math_ids", math_ids);
-        json_object_object_add(hit, "xhtml",
-                               json_object_new_string(answer->data.c_str()));
-        json_object_array_add(hits, hit);
-    }
-
-    json_object_object_add(json_doc, "hits", hits);
-
+namespace xmlparser {
 
-    string json_string = json_object_to_json_string(json_doc);
-
-    data = json_string.c_str();
-    data_size = json_string.size();
+JsonAnswsetWriter::JsonAnswsetWriter(const MwsAnswset* answset) :
+    _answset(answset), _nextAnswer(0), _stage(STAGE_HEADER) {
+}
 
-    bytes_written = 0;
-    while (bytes_written < data_size) {
-        bytes_written += fwrite(data + bytes_written,
-                               sizeof(char),
-                               data_size - bytes_written,
-                               file);
+/*
+ * The pieces are laid out as json-c prints the whole document:
+ * { "total": 2, "qvars": [ ... ], "hits": [ {...}, {...} ] }
+ */
+int JsonAnswsetWriter::writeNext(string* out) {
+    switch (_stage) {
+    case STAGE_HEADER:
+        out->append("{ \"total\": ");
+        out->append(std::to_string(_answset->total));
+        out->append(", \"qvars\": [");
+        for (size_t i = 0; i < _answset->qvarNames.size(); i++) {
+            out->append((i == 0) ? " { \"name\": " : ", { \"name\": ");
+            appendJsonString(out, _answset->qvarNames[i]);
+            out->append(", \"xpath\": ");
+            appendJsonString(out, _answset->qvarXpaths[i]);
+            out->append(" }");
+        }
+        out->append(" ], \"hits\": [");
+        _stage = STAGE_ANSWERS;
+        break;
+
+    case STAGE_ANSWERS:
+        if (_nextAnswer < _answset->answers.size()) {
+            const types::Answer* answer = _answset->answers[_nextAnswer];
+
+            out->append((_nextAnswer == 0) ? " " : ", ");
+            out->append("{ \"math_ids\": [ { \"url\": ");
+            appendJsonString(out, answer->uri);
+            out->append(", \"xpath\": ");
+            appendJsonString(out, answer->xpath);
+            out->append(" } ], \"xhtml\": ");
+            appendJsonString(out, answer->data);
+            out->append(" }");
+            _nextAnswer++;
+        } else {
+            out->append(" ] }");
+            _stage = STAGE_DONE;
+        }
+        break;
+
+    case STAGE_DONE:
+        return 0;
     }
 
-    json_object_put(json_doc);
-    return data_size;
+    return 1;
 }
 
+}  // namespace xmlparser
+
+int
+writeJsonAnswset(mws::MwsAnswset* answset, FILE* file)
+{
+    xmlparser::JsonAnswsetWriter writer(answset);
+    return writer.writeAll(file);
 }
 
+}
@@ -35,13 +35,42 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   */
 
 #include <stdio.h>
+
+#include <string>
+
 // Local includes
 
 #include "mws/types/MwsAnswset.hpp"    // MWS Answer Set datatype header
+#include "mws/xmlparser/AnswsetWriter.hpp"
 
 namespace mws
 {
 
+namespace xmlparser {
+
+/**
+  * @brief Writer of a MwsAnswset as JSON, one hit at a time.
+  */
+class JsonAnswsetWriter : public AnswsetWriter {
+ public:
+    /// @param answset is the MWS Answer Set to be written, which must
+    /// outlive the writer.
+    explicit JsonAnswsetWriter(const MwsAnswset* answset);
+
+    int writeNext(std::string* out);
+
+ private:
+    const MwsAnswset* _answset;
+    size_t _nextAnswer;
+    enum {
+        STAGE_HEADER,
+        STAGE_ANSWERS,
+        STAGE_DONE
+    } _stage;
+};
+
+}  // namespace xmlparser
+
 /**
   * @brief Function to write a MwsAnswset to an output file descriptor as JSON
   * data.
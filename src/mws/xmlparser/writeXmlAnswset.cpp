@@ -56,173 +56,203 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 using namespace std;
 using namespace mws;
 
-struct LocalContext {
-    FILE* file;
-    size_t total_bytes_written;
-};
-
 /**
   * @brief Callback function used with an xmlOutputBuffer
   *
   */
 static inline int
-fileXmlOutputWriteCallback(void* _ctxt, const char* data, int data_size) {
-    LocalContext* ctxt = (LocalContext*) _ctxt;
-    size_t bytes_written = fwrite(data, sizeof(char), data_size, ctxt->file);
-    ctxt->total_bytes_written += bytes_written;
-    return bytes_written;
+stringXmlOutputWriteCallback(void* _buffer, const char* data, int data_size) {
+    string* buffer = (string*) _buffer;
+    buffer->append(data, data_size);
+    return data_size;
 }
 
 namespace mws {
 namespace xmlparser {
 
-int writeXmlAnswset(MwsAnswset* answset, FILE* file) {
+XmlAnswsetWriter::XmlAnswsetWriter(const MwsAnswset* answset) :
+    _answset(answset), _writer(NULL), _nextAnswer(0), _stage(STAGE_HEADER) {
     xmlOutputBuffer* outPtr;
-    xmlTextWriter*   writerPtr;
-    size_t           qvarNr;
-    int              ret;
-    unsigned int     i;
-    LocalContext     ctxt;
-
-    // Initializing values
-    outPtr    = NULL;
-    writerPtr = NULL;
-    ret       = -1;
-    qvarNr    = answset->qvarNames.size();
-    ctxt.file = file;
-    ctxt.total_bytes_written = 0;
 
-    if (answset == NULL) {
-        PRINT_WARN("NULL answset passed to writeXmlAnswsetToFd");
-    } else if ((outPtr = xmlOutputBufferCreateIO(fileXmlOutputWriteCallback,
-                                               NULL,
-                                               &ctxt,
-                                               NULL))
+    if ((outPtr = xmlOutputBufferCreateIO(stringXmlOutputWriteCallback,
+                                          NULL,
+                                          &_buffer,
+                                          NULL))
             == NULL) {
         PRINT_WARN("Error while creating the OutputBuffer\n");
-    } else if ((writerPtr = xmlNewTextWriter(outPtr))
+    } else if ((_writer = xmlNewTextWriter(outPtr))
             == NULL) {
         PRINT_WARN("Error while creating the TextWriter\n");
-    } else if ((ret = xmlTextWriterStartDocument(writerPtr,  // xmlTextWriter
-                                               NULL,      // XML version ("1.0")
-                                               NULL,      // Encoding ("UTF-8")
-                                               NULL))     // Standalone ("yes")
+        xmlOutputBufferClose(outPtr);
+    }
+}
+
+XmlAnswsetWriter::~XmlAnswsetWriter() {
+    if (_writer) {
+        // This also cleans the output buffer
+        xmlFreeTextWriter(_writer);
+    }
+}
+
+int XmlAnswsetWriter::writeNext(string* out) {
+    int ret = -1;
+
+    if (_writer == NULL) return -1;
+
+    switch (_stage) {
+    case STAGE_HEADER:
+        ret = writeHeader();
+        _stage = STAGE_ANSWERS;
+        break;
+    case STAGE_ANSWERS:
+        if (_nextAnswer < _answset->answers.size()) {
+            ret = writeAnswer(_answset->answers[_nextAnswer++]);
+        } else {
+            ret = writeFooter();
+            _stage = STAGE_DONE;
+        }
+        break;
+    case STAGE_DONE:
+        return 0;
+    }
+
+    if (ret == -1) {
+        _stage = STAGE_DONE;
+        return -1;
+    } else if ((ret = xmlTextWriterFlush(_writer))
+            == -1) {
+        PRINT_WARN("Error at xmlTextWriterFlush\n");
+        _stage = STAGE_DONE;
+        return -1;
+    }
+    out->append(_buffer);
+    _buffer.clear();
+
+    return 1;
+}
+
+int XmlAnswsetWriter::writeHeader() {
+    int ret;
+
+    if ((ret = xmlTextWriterStartDocument(_writer,  // xmlTextWriter
+                                          NULL,     // XML version ("1.0")
+                                          NULL,     // Encoding ("UTF-8")
+                                          NULL))    // Standalone ("yes")
             == -1) {
         PRINT_WARN("Error at xmlTextWriterStartDocument\n");
-    } else if ((ret = xmlTextWriterWriteComment(writerPtr,
+    } else if ((ret = xmlTextWriterWriteComment(_writer,
                     BAD_CAST "MwsAnswset generated by " MWS_BUILD))
             == -1) {
         PRINT_WARN("Error at xmlTextWriterStartDocument\n");
-    } else if ((ret = xmlTextWriterStartElement(writerPtr,
+    } else if ((ret = xmlTextWriterStartElement(_writer,
                     BAD_CAST MWSANSWSET_MAIN_NAME))
             == -1) {
         PRINT_WARN("Error at xmlTextWriterStartElement\n");
-    } else if ((ret = xmlTextWriterWriteAttribute(writerPtr,
+    } else if ((ret = xmlTextWriterWriteAttribute(_writer,
                     BAD_CAST "xmlns:mws",
                     BAD_CAST "http://www.mathweb.org/mws/ns"))
             == -1) {
         PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
-    } else if ((ret = xmlTextWriterWriteAttribute(writerPtr,
+    } else if ((ret = xmlTextWriterWriteAttribute(_writer,
                     BAD_CAST "size",
-                    BAD_CAST std::to_string(answset->answers.size()).c_str()))
+                    BAD_CAST std::to_string(_answset->answers.size()).c_str()))
             == -1) {
         PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
-    } else if ((ret = xmlTextWriterWriteAttribute(writerPtr,
+    } else if ((ret = xmlTextWriterWriteAttribute(_writer,
                     BAD_CAST "total",
-                    BAD_CAST std::to_string(answset->total).c_str()))
+                    BAD_CAST std::to_string(_answset->total).c_str()))
+            == -1) {
+        PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
+    }
+
+    return ret;
+}
+
+int XmlAnswsetWriter::writeAnswer(const types::Answer* answer) {
+    size_t qvarNr = _answset->qvarNames.size();
+    int    ret;
+
+    if ((ret = xmlTextWriterStartElement(_writer,
+                BAD_CAST MWSANSWSET_ANSW_NAME))
+            == -1) {
+        PRINT_WARN("Error at xmlTextWriterStartElement\n");
+        return ret;
+    } else if ((ret = xmlTextWriterWriteAttribute(_writer,
+                BAD_CAST MWSANSWSET_URI_NAME,
+                BAD_CAST answer->uri.c_str()))
+            == -1) {
+        PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
+        return ret;
+    } else if ((ret = xmlTextWriterWriteAttribute(_writer,
+                BAD_CAST MWSANSWSET_XPATH_NAME,
+                BAD_CAST answer->xpath.c_str()))
             == -1) {
         PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
-    } else {
-        for (auto it = answset->answers.begin();
-             it != answset->answers.end(); it++) {
-            if ((ret = xmlTextWriterStartElement(writerPtr,
-                        BAD_CAST MWSANSWSET_ANSW_NAME))
-                    == -1) {
-                PRINT_WARN("Error at xmlTextWriterStartElement\n");
-                break;
-            } else if ((ret = xmlTextWriterWriteAttribute(writerPtr,
-                        BAD_CAST MWSANSWSET_URI_NAME,
-                        BAD_CAST (*it)->uri.c_str()))
-                    == -1) {
-                PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
-                break;
-            } else if ((ret = xmlTextWriterWriteAttribute(writerPtr,
-                        BAD_CAST MWSANSWSET_XPATH_NAME,
-                        BAD_CAST (*it)->xpath.c_str()))
-                    == -1) {
-                PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
-                break;
-            } else {
-                // Writing the substitutions
-                for (i = 0; i < qvarNr; i++) {
-                    string qvarXpath = (*it)->xpath + answset->qvarXpaths[i];
-                    if ((ret = xmlTextWriterStartElement(writerPtr,
-                                BAD_CAST MWSANSWSET_SUBSTPAIR_NAME))
-                            == -1) {
-                        PRINT_WARN("Error at xmlTextWriterStartElement\n");
-                        break;
-                    } else if ((ret = xmlTextWriterWriteAttribute(writerPtr,
-                                BAD_CAST "qvar",
-                                BAD_CAST answset->qvarNames[i].c_str()))
-                            == -1) {
-                        PRINT_WARN(
-                                "Error at xmlTextWriterWriteAttribute\n");
-                        break;
-                    } else if ((ret = xmlTextWriterWriteAttribute(writerPtr,
-                                BAD_CAST "xpath",
-                                BAD_CAST qvarXpath.c_str()))
-                            == -1) {
-                        PRINT_WARN(
-                                "Error at xmlTextWriterWriteAttribute\n");
-                        break;
-                    } else if ((ret = xmlTextWriterEndElement(writerPtr))
-                            == -1) {
-                        PRINT_WARN("Error at xmlTextWriterEndElement\n");
-                        break;
-                    }
-                }
-                // <data> ... </data>
-                xmlTextWriterWriteElement(writerPtr, BAD_CAST "data",
-                                          BAD_CAST (*it)->data.c_str());
-            }
-            if (ret == -1) {
-                PRINT_WARN("Error while writing xml substpairs\n");
-                break;
-            } else if ((ret = xmlTextWriterEndElement(writerPtr))
-                    == -1) {
-                PRINT_WARN("Error at xmlTextWriterEndElement\n");
-                break;
-            }
+        return ret;
+    }
+
+    // Writing the substitutions
+    for (size_t i = 0; i < qvarNr; i++) {
+        string qvarXpath = answer->xpath + _answset->qvarXpaths[i];
+        if ((ret = xmlTextWriterStartElement(_writer,
+                    BAD_CAST MWSANSWSET_SUBSTPAIR_NAME))
+                == -1) {
+            PRINT_WARN("Error at xmlTextWriterStartElement\n");
+            break;
+        } else if ((ret = xmlTextWriterWriteAttribute(_writer,
+                    BAD_CAST "qvar",
+                    BAD_CAST _answset->qvarNames[i].c_str()))
+                == -1) {
+            PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
+            break;
+        } else if ((ret = xmlTextWriterWriteAttribute(_writer,
+                    BAD_CAST "xpath",
+                    BAD_CAST qvarXpath.c_str()))
+                == -1) {
+            PRINT_WARN("Error at xmlTextWriterWriteAttribute\n");
+            break;
+        } else if ((ret = xmlTextWriterEndElement(_writer))
+                == -1) {
+            PRINT_WARN("Error at xmlTextWriterEndElement\n");
+            break;
         }
     }
+    // <data> ... </data>
+    xmlTextWriterWriteElement(_writer, BAD_CAST "data",
+                              BAD_CAST answer->data.c_str());
+
     if (ret == -1) {
-        PRINT_WARN("Error while writing xml answers\n");
-    } else if ((ret = xmlTextWriterEndElement(writerPtr))
+        PRINT_WARN("Error while writing xml substpairs\n");
+    } else if ((ret = xmlTextWriterEndElement(_writer))
             == -1) {
         PRINT_WARN("Error at xmlTextWriterEndElement\n");
-    } else if ((ret = xmlTextWriterEndDocument(writerPtr))
+    }
+
+    return ret;
+}
+
+int XmlAnswsetWriter::writeFooter() {
+    int ret;
+
+    if ((ret = xmlTextWriterEndElement(_writer))
             == -1) {
-        PRINT_WARN("Error at xmlTextWriterEndDocument\n");
-    } else if ((ret = xmlTextWriterFlush(writerPtr))
+        PRINT_WARN("Error at xmlTextWriterEndElement\n");
+    } else if ((ret = xmlTextWriterEndDocument(_writer))
             == -1) {
-        PRINT_WARN("Error at xmlTextWriterFlush\n");
-    } else {
-        ret = 0;
+        PRINT_WARN("Error at xmlTextWriterEndDocument\n");
     }
 
-    // Cleaning data
-    if (writerPtr) {
-        // This also cleans the outPtr
-        xmlFreeTextWriter(writerPtr);
-    } else if (outPtr) {
-        xmlOutputBufferClose(outPtr);
-    }
+    return ret;
+}
 
-    if (ret == 0) {
-        return ctxt.total_bytes_written;
-    } else {
-        return ret;
+int writeXmlAnswset(MwsAnswset* answset, FILE* file) {
+    if (answset == NULL) {
+        PRINT_WARN("NULL answset passed to writeXmlAnswsetToFd");
+        return -1;
     }
+
+    XmlAnswsetWriter writer(answset);
+    return writer.writeAll(file);
 }
 
 }  // namespace xmlparser
@@ -36,13 +36,51 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
   */
 
 #include <stdio.h>
+
+#include <string>
+
 // Local includes
 
 #include "mws/types/MwsAnswset.hpp"    // MWS Answer Set datatype header
+#include "mws/xmlparser/AnswsetWriter.hpp"
+
+struct _xmlTextWriter;
 
 namespace mws {
 namespace xmlparser {
 
+/**
+  * @brief Writer of a MwsAnswset as XML, one answer at a time.
+  */
+class XmlAnswsetWriter : public AnswsetWriter {
+ public:
+    /// @param answset is the MWS Answer Set to be written, which must
+    /// outlive the writer.
+    explicit XmlAnswsetWriter(const MwsAnswset* answset);
+    ~XmlAnswsetWriter();
+
+    int writeNext(std::string* out);
+
+ private:
+    int writeHeader();
+    int writeAnswer(const types::Answer* answer);
+    int writeFooter();
+
+    const MwsAnswset* _answset;
+    struct _xmlTextWriter* _writer;
+    /// output of _writer not yet returned
+    std::string _buffer;
+    size_t _nextAnswer;
+    enum {
+        STAGE_HEADER,
+        STAGE_ANSWERS,
+        STAGE_DONE
+    } _stage;
+
+    XmlAnswsetWriter(const XmlAnswsetWriter&);
+    XmlAnswsetWriter& operator=(const XmlAnswsetWriter&);
+};
+
 /**
   * @brief Function to write a MwsAnswset to an output file.
   * @param file is the file to which to write.
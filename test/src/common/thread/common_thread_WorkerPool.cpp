@@ -0,0 +1,85 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file common_thread_WorkerPool.cpp
+ * @brief WorkerPool test
+ */
+
+#include <pthread.h>
+
+#include "common/utils/compiler_defs.h"
+#include "common/thread/WorkerPool.hpp"
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static bool blockerStarted = false;
+static bool gateOpen = false;
+static int numRun = 0;
+
+static void runBlocker() {
+    pthread_mutex_lock(&lock);
+    blockerStarted = true;
+    numRun++;
+    pthread_cond_broadcast(&changed);
+    while (!gateOpen) {
+        pthread_cond_wait(&changed, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+static void runJob() {
+    pthread_mutex_lock(&lock);
+    numRun++;
+    pthread_mutex_unlock(&lock);
+}
+
+int main() {
+    WorkerPool pool(/* numWorkers = */ 1, /* queueDepth = */ 2);
+
+    FAIL_ON(pool.start() != 0);
+
+    /* the only worker is kept busy */
+    FAIL_ON(!pool.submit(runBlocker));
+    pthread_mutex_lock(&lock);
+    while (!blockerStarted) {
+        pthread_cond_wait(&changed, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+
+    /* jobs wait in the queue until it is full */
+    FAIL_ON(!pool.submit(runJob));
+    FAIL_ON(!pool.submit(runJob));
+    FAIL_ON(pool.submit(runJob));
+
+    /* queued jobs are run before stopping */
+    pthread_mutex_lock(&lock);
+    gateOpen = true;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+    pool.stop();
+    FAIL_ON(numRun != 3);
+    FAIL_ON(pool.submit(runJob));
+
+    return 0;
+
+fail:
+    return -1;
+}
@@ -0,0 +1,61 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file common_utils_Arena.cpp
+ * @brief Arena allocator test
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "common/utils/compiler_defs.h"
+#include "common/utils/Arena.hpp"
+using common::utils::Arena;
+
+#define TEST_SLAB_SIZE  1024
+
+int main() {
+    Arena arena(TEST_SLAB_SIZE);
+    char* block;
+    char* other;
+
+    /* blocks are aligned and do not overlap */
+    FAIL_ON((block = (char*) arena.allocate(3)) == NULL);
+    FAIL_ON((other = (char*) arena.allocate(16)) == NULL);
+    FAIL_ON(((uintptr_t) block & (ARENA_ALIGNMENT - 1)) != 0);
+    FAIL_ON(((uintptr_t) other & (ARENA_ALIGNMENT - 1)) != 0);
+    FAIL_ON(other < block + 3 && block < other + 16);
+    FAIL_ON(arena.getSlabBytes() != TEST_SLAB_SIZE);
+
+    /* released blocks are recycled by allocations of the same size */
+    arena.release(other, 16);
+    FAIL_ON(arena.allocate(16) != other);
+
+    /* large blocks get their own slab */
+    block = (char*) arena.allocate(TEST_SLAB_SIZE);
+    memset(block, 0, TEST_SLAB_SIZE);
+    FAIL_ON(arena.getSlabBytes() != 2 * TEST_SLAB_SIZE);
+
+    return 0;
+
+fail:
+    return -1;
+}
@@ -0,0 +1,156 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file DbQueryManager.cpp
+ * @brief Check batched queries answer like one query per formula
+ * @date 18 Oct 2026
+ */
+
+#include <string>
+using std::string;
+using std::to_string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "mws/dbc/CrawlDb.hpp"
+using mws::dbc::CrawlId;
+using mws::dbc::CrawlData;
+using mws::dbc::CrawlDb;
+using mws::dbc::CRAWLID_NULL;
+#include "mws/dbc/FormulaDb.hpp"
+using mws::dbc::FormulaDb;
+using mws::dbc::FormulaQuery;
+#include "mws/dbc/MemCrawlDb.hpp"
+using mws::dbc::MemCrawlDb;
+#include "mws/dbc/MemFormulaDb.hpp"
+using mws::dbc::MemFormulaDb;
+#include "mws/dbc/LevCrawlDb.hpp"
+using mws::dbc::LevCrawlDb;
+#include "mws/dbc/LevFormulaDb.hpp"
+using mws::dbc::LevFormulaDb;
+#include "mws/dbc/DbQueryManager.hpp"
+using mws::dbc::DbQueryManager;
+using mws::dbc::DbAnswerCallback;
+#include "mws/types/FormulaPath.hpp"
+using mws::types::FormulaId;
+using mws::types::FormulaPath;
+
+const char LEV_CRAWL_PATH[] = "/tmp/test_DbQueryManager_crawl.db";
+const char LEV_FORMULA_PATH[] = "/tmp/test_DbQueryManager_formula.db";
+
+struct FormulaInfo {
+    FormulaId formulaId;
+    CrawlId crawlId;
+};
+
+/// ids 2 and 10 order differently as numbers and as decimal keys
+vector<FormulaInfo> g_infos {
+    {1, 2}, {1, 10}, {1, 2}, {1, CRAWLID_NULL},
+    {2, 10}, {2, 3},
+    {10, 1}, {10, 2}, {10, 12},
+    {3, 11}
+};
+
+/// queried out of key order, with offsets, empty and missing formulae
+vector<FormulaQuery> g_queries {
+    {10, 0, 10}, {2, 0, 1}, {1, 1, 3}, {3, 0, 0}, {99, 0, 5}, {2, 1, 4}
+};
+
+static int fill(CrawlDb* crawlDb, FormulaDb* formulaDb) {
+    for (int i = 1; i <= 12; i++) {
+        FAIL_ON(crawlDb->putData("data" + to_string(i)) != (CrawlId) i);
+    }
+    for (size_t i = 0; i < g_infos.size(); i++) {
+        const FormulaInfo& info = g_infos[i];
+        FormulaPath formulaPath("id" + to_string(i), to_string(i));
+        FAIL_ON(formulaDb->insertFormula(info.formulaId, info.crawlId,
+                                         formulaPath) != 0);
+    }
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+static int check(CrawlDb* crawlDb, FormulaDb* formulaDb) {
+    DbQueryManager dbQueryManager(crawlDb, formulaDb);
+    vector<string> expected, actual;
+    DbAnswerCallback append;
+
+    for (const FormulaQuery& formulaQuery : g_queries) {
+        append = [&expected](const FormulaPath& formulaPath,
+                             const CrawlData& crawlData) {
+            expected.push_back(formulaPath.xmlId + ":" + crawlData);
+            return 0;
+        };
+        FAIL_ON(dbQueryManager.query(formulaQuery.formulaId,
+                                     formulaQuery.limitMin,
+                                     formulaQuery.limitSize,
+                                     append) != 0);
+    }
+    FAIL_ON(expected.size() != 8);
+
+    append = [&actual](const FormulaPath& formulaPath,
+                       const CrawlData& crawlData) {
+        actual.push_back(formulaPath.xmlId + ":" + crawlData);
+        return 0;
+    };
+    FAIL_ON(dbQueryManager.query(g_queries, append) != 0);
+    FAIL_ON(actual != expected);
+
+    // a failing callback stops the batch
+    append = [](const FormulaPath&, const CrawlData&) {
+        return -1;
+    };
+    FAIL_ON(dbQueryManager.query(g_queries, append) == 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    MemCrawlDb* memCrawlDb = new MemCrawlDb();
+    MemFormulaDb* memFormulaDb = new MemFormulaDb();
+    LevCrawlDb* levCrawlDb = new LevCrawlDb();
+    LevFormulaDb* levFormulaDb = new LevFormulaDb();
+
+    FAIL_ON(fill(memCrawlDb, memFormulaDb) != 0);
+    FAIL_ON(check(memCrawlDb, memFormulaDb) != 0);
+
+    levCrawlDb->create_new(LEV_CRAWL_PATH, /* deleteIfExists = */ true);
+    levFormulaDb->create_new(LEV_FORMULA_PATH, /* deleteIfExists = */ true);
+    FAIL_ON(fill(levCrawlDb, levFormulaDb) != 0);
+    FAIL_ON(check(levCrawlDb, levFormulaDb) != 0);
+
+    delete memCrawlDb;
+    delete memFormulaDb;
+    delete levCrawlDb;
+    delete levFormulaDb;
+
+    return 0;
+
+fail:
+    return -1;
+}
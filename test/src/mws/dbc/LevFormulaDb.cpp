@@ -0,0 +1,172 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file LevFormulaDb.cpp
+ * @brief Check the binary key schema of LevFormulaDb
+ * @date 18 Oct 2026
+ */
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <leveldb/db.h>
+
+#include "common/utils/compiler_defs.h"
+#include "mws/dbc/CrawlDb.hpp"
+using mws::dbc::CrawlId;
+#include "mws/dbc/LevFormulaDb.hpp"
+using mws::dbc::LevFormulaDb;
+#include "mws/types/FormulaPath.hpp"
+using mws::types::FormulaId;
+using mws::types::FormulaPath;
+
+const char DB_PATH[] = "/tmp/test_LevFormulaDb.db";
+const char DECIMAL_DB_PATH[] = "/tmp/test_LevFormulaDb_decimal.db";
+
+struct FormulaInfo {
+    FormulaId formulaId;
+    CrawlId crawlId;
+    FormulaPath formulaPath;
+};
+
+/// ids ordered differently as numbers and as decimal text, an id sharing
+/// the first bytes of the schema key, the largest id and an xmlId longer
+/// than 127 bytes
+vector<FormulaInfo> g_infos {
+    {10, 7, FormulaPath("id1", "/*[1]")},
+    {2, 0xffffffff, FormulaPath("id2", "")},
+    {10, 1, FormulaPath(string(300, 'x'), "/*[2]")},
+    {256, 3, FormulaPath("", "/*[3]")},
+    {0x6d777300, 4, FormulaPath("id5", "/*[4]")},
+    {10, 2, FormulaPath("id6", "/*[5]")},
+    {2, 5, FormulaPath("id7", "/*[6]")},
+    {0xffffffff, 6, FormulaPath("id8", "/*[7]")}
+};
+
+/// inserted after reopening the database
+vector<FormulaInfo> g_appended {
+    {10, 8, FormulaPath("id9", "/*[8]")},
+    {0xffffffff, 9, FormulaPath("id10", "/*[9]")},
+    {3, 10, FormulaPath("id11", "/*[10]")}
+};
+
+static int checkQuery(LevFormulaDb* formulaDb, FormulaId formulaId,
+                      unsigned limitMin, unsigned limitSize) {
+    vector<const FormulaInfo*> expected, actual;
+    unsigned skipped = 0, count = 0;
+
+    for (const FormulaInfo& info : g_infos) {
+        if (info.formulaId != formulaId) continue;
+        count++;
+        if (skipped++ < limitMin) continue;
+        if (expected.size() < limitSize) expected.push_back(&info);
+    }
+
+    size_t i = 0;
+    FAIL_ON(formulaDb->queryFormula(formulaId, limitMin, limitSize,
+                                    [&](const CrawlId& crawlId,
+                                        const FormulaPath& formulaPath) {
+        if (i >= expected.size() || crawlId != expected[i]->crawlId ||
+                formulaPath != expected[i]->formulaPath) {
+            return -1;
+        }
+        i++;
+        return 0;
+    }) != 0);
+    FAIL_ON(i != expected.size());
+    FAIL_ON(formulaDb->getCount(formulaId) != count);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+static int checkQueries(LevFormulaDb* formulaDb) {
+    FAIL_ON(checkQuery(formulaDb, 10, 0, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 10, 1, 1) != 0);
+    FAIL_ON(checkQuery(formulaDb, 2, 0, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 256, 0, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 0x6d777300, 0, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 0x6d777300, 1, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 10, 2, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 10, 5, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 1, 0, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 3, 0, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 0xffffffff, 0, 10) != 0);
+    FAIL_ON(checkQuery(formulaDb, 0xffffffff, 1, 10) != 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    LevFormulaDb* formulaDb = new LevFormulaDb();
+    leveldb::DB* decimalDb = NULL;
+
+    formulaDb->create_new(DB_PATH, /* deleteIfExists = */ true);
+    for (const FormulaInfo& info : g_infos) {
+        FAIL_ON(formulaDb->insertFormula(info.formulaId, info.crawlId,
+                                         info.formulaPath) != 0);
+    }
+    FAIL_ON(checkQueries(formulaDb) != 0);
+    delete formulaDb;
+
+    // reopened databases keep their schema and number their new hits
+    // after the existing ones
+    formulaDb = new LevFormulaDb();
+    formulaDb->open(DB_PATH);
+    FAIL_ON(checkQueries(formulaDb) != 0);
+    for (const FormulaInfo& info : g_appended) {
+        FAIL_ON(formulaDb->insertFormula(info.formulaId, info.crawlId,
+                                         info.formulaPath) != 0);
+        g_infos.push_back(info);
+    }
+    FAIL_ON(checkQueries(formulaDb) != 0);
+    delete formulaDb;
+
+    // databases with the decimal key schema are refused
+    (void) leveldb::DestroyDB(DECIMAL_DB_PATH, leveldb::Options());
+    {
+        leveldb::Options options;
+        options.create_if_missing = true;
+        FAIL_ON(!leveldb::DB::Open(options, DECIMAL_DB_PATH,
+                                   &decimalDb).ok());
+        FAIL_ON(!decimalDb->Put(leveldb::WriteOptions(), "1!1", "").ok());
+        delete decimalDb;
+    }
+    formulaDb = new LevFormulaDb();
+    try {
+        formulaDb->open(DECIMAL_DB_PATH);
+        goto fail;
+    } catch (...) {
+        // expected
+    }
+    delete formulaDb;
+
+    return 0;
+
+fail:
+    return -1;
+}
@@ -0,0 +1,99 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file MmapCrawlDb.cpp
+ * @brief Check crawl data written by MmapCrawlDb is read back
+ * @date 18 Oct 2026
+ */
+
+#include <stdio.h>
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "mws/dbc/MmapCrawlDb.hpp"
+using mws::dbc::CrawlId;
+using mws::dbc::CrawlData;
+using mws::dbc::CRAWLID_NULL;
+using mws::dbc::MmapCrawlDb;
+
+const char DB_PATH[] = "/tmp/test_MmapCrawlDb.dat";
+
+/// an empty element and sizes which are not multiples of 8
+vector<CrawlData> g_data {
+    "foobar",
+    "",
+    string(1000, 'x'),
+    string("nul\0byte", 8),
+    "a"
+};
+
+int main() {
+    MmapCrawlDb* crawlDb = new MmapCrawlDb();
+
+    crawlDb->create_new(DB_PATH, /* deleteIfExists = */ true);
+    for (size_t i = 0; i < g_data.size(); i++) {
+        FAIL_ON(crawlDb->putData(g_data[i]) != (CrawlId) i + 1);
+    }
+    crawlDb->save();
+    delete crawlDb;
+
+    crawlDb = new MmapCrawlDb();
+    crawlDb->open(DB_PATH);
+    for (size_t i = 0; i < g_data.size(); i++) {
+        FAIL_ON(crawlDb->getData(i + 1) != g_data[i]);
+    }
+
+    // Check for false positives
+    try {
+        CrawlData data = crawlDb->getData(CRAWLID_NULL);
+        goto fail;
+    } catch (...) {
+        // ignore
+    }
+    try {
+        CrawlData data = crawlDb->getData(g_data.size() + 1);
+        goto fail;
+    } catch (...) {
+        // ignore
+    }
+    delete crawlDb;
+
+    // existing databases are not overwritten
+    crawlDb = new MmapCrawlDb();
+    try {
+        crawlDb->create_new(DB_PATH, /* deleteIfExists = */ false);
+        goto fail;
+    } catch (...) {
+        // ignore
+    }
+    delete crawlDb;
+
+    (void) remove(DB_PATH);
+
+    return 0;
+
+fail:
+    return -1;
+}
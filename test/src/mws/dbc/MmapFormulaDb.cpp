@@ -0,0 +1,146 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file MmapFormulaDb.cpp
+ * @brief Check MmapFormulaDb answers like MemFormulaDb
+ * @date 18 Oct 2026
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "mws/dbc/CrawlDb.hpp"
+using mws::dbc::CrawlId;
+#include "mws/dbc/FormulaDb.hpp"
+using mws::dbc::FormulaDb;
+#include "mws/dbc/MemFormulaDb.hpp"
+using mws::dbc::MemFormulaDb;
+#include "mws/dbc/MmapFormulaDb.hpp"
+using mws::dbc::MmapFormulaDb;
+#include "mws/types/FormulaPath.hpp"
+using mws::types::FormulaId;
+using mws::types::FormulaPath;
+
+const char DB_PATH[] = "/tmp/test_MmapFormulaDb.dat";
+
+struct FormulaInfo {
+    FormulaId formulaId;
+    CrawlId crawlId;
+    FormulaPath formulaPath;
+};
+
+/// hits of formulae interleaved, with gaps between the ids
+vector<FormulaInfo> g_infos {
+    {10, 7, FormulaPath("id1", "/*[1]")},
+    {2, 0xffffffff, FormulaPath("id2", "")},
+    {10, 1, FormulaPath(string(300, 'x'), "/*[2]")},
+    {7, 3, FormulaPath("", "/*[3]")},
+    {10, 2, FormulaPath("id5", "/*[4]")},
+    {2, 5, FormulaPath("id6", "/*[5]")}
+};
+
+typedef vector<std::pair<CrawlId, FormulaPath> > Hits;
+
+static int query(FormulaDb* formulaDb, FormulaId formulaId,
+                 unsigned limitMin, unsigned limitSize, Hits* hits) {
+    hits->clear();
+    return formulaDb->queryFormula(formulaId, limitMin, limitSize,
+                                   [hits](const CrawlId& crawlId,
+                                          const FormulaPath& formulaPath) {
+        hits->push_back(std::make_pair(crawlId, formulaPath));
+        return 0;
+    });
+}
+
+static bool operator!=(const Hits& lhs, const Hits& rhs) {
+    if (lhs.size() != rhs.size()) return true;
+    for (size_t i = 0; i < lhs.size(); i++) {
+        if (lhs[i].first != rhs[i].first || lhs[i].second != rhs[i].second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main() {
+    MemFormulaDb memFormulaDb;
+    MmapFormulaDb* formulaDb = new MmapFormulaDb();
+    const FormulaId ids[] = {0, 1, 2, 7, 10, 11, 1000};
+    Hits expected, actual;
+
+    formulaDb->create_new(DB_PATH, /* deleteIfExists = */ true);
+    for (const FormulaInfo& info : g_infos) {
+        FAIL_ON(formulaDb->insertFormula(info.formulaId, info.crawlId,
+                                         info.formulaPath) != 0);
+        FAIL_ON(memFormulaDb.insertFormula(info.formulaId, info.crawlId,
+                                           info.formulaPath) != 0);
+    }
+    formulaDb->save();
+    FAIL_ON(access((string(DB_PATH) + ".tmp").c_str(), F_OK) == 0);
+    delete formulaDb;
+
+    formulaDb = new MmapFormulaDb();
+    formulaDb->open(DB_PATH);
+    for (FormulaId formulaId : ids) {
+        for (unsigned limitMin = 0; limitMin < 4; limitMin++) {
+            for (unsigned limitSize = 0; limitSize < 4; limitSize++) {
+                FAIL_ON(query(&memFormulaDb, formulaId, limitMin, limitSize,
+                              &expected) != 0);
+                FAIL_ON(query(formulaDb, formulaId, limitMin, limitSize,
+                              &actual) != 0);
+                FAIL_ON(actual != expected);
+            }
+        }
+    }
+    FAIL_ON(query(formulaDb, 10, 0, 10, &actual) != 0);
+    FAIL_ON(actual.size() != 3);
+
+    // a failing callback stops the query
+    FAIL_ON(formulaDb->queryFormula(10, 0, 10, [](const CrawlId&,
+                                                  const FormulaPath&) {
+        return -1;
+    }) == 0);
+    delete formulaDb;
+
+    // databases without hits
+    formulaDb = new MmapFormulaDb();
+    formulaDb->create_new(DB_PATH, /* deleteIfExists = */ true);
+    formulaDb->save();
+    delete formulaDb;
+    formulaDb = new MmapFormulaDb();
+    formulaDb->open(DB_PATH);
+    FAIL_ON(query(formulaDb, 0, 0, 10, &actual) != 0);
+    FAIL_ON(!actual.empty());
+    delete formulaDb;
+
+    (void) remove(DB_PATH);
+
+    return 0;
+
+fail:
+    return -1;
+}
@@ -0,0 +1,239 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file IndexCompaction_compact.cpp
+ * @brief Test that compacting the delta segments of an index gives the
+ * index built from all harvests at once
+ * @date 18 Oct 2026
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mws/dbc/MemCrawlDb.hpp"
+#include "mws/dbc/MemFormulaDb.hpp"
+#include "mws/dbc/MmapCrawlDb.hpp"
+#include "mws/dbc/MmapFormulaDb.hpp"
+#include "mws/index/IndexCompaction.hpp"
+#include "mws/index/IndexManager.hpp"
+#include "mws/index/IndexSegments.hpp"
+#include "mws/index/MeaningDictionary.hpp"
+using mws::index::MeaningDictionary;
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/xmlparser/initxmlparser.hpp"
+#include "mws/xmlparser/processMwsHarvest.hpp"
+#include "common/utils/compiler_defs.h"
+
+#include "build-gen/config.h"
+
+#define TMP_INDEX_PATH  "/tmp/test-compact-index"
+
+using namespace std;
+using namespace mws;
+
+static int loadHarvests(index::IndexManager* indexManager,
+                        const vector<string>& harvests) {
+    for (const string& harvest : harvests) {
+        string path = (string) MWS_TESTDATA_PATH + "/" + harvest;
+        int fd = open(path.c_str(), O_RDONLY);
+        FAIL_ON(fd < 0);
+        parser::loadMwsHarvestFromFd(indexManager, fd);
+        close(fd);
+    }
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+static vector<string> getFormulae(dbc::FormulaDb* formulaDb,
+                                  dbc::CrawlDb* crawlDb,
+                                  uint32_t formulaId) {
+    vector<string> formulae;
+    formulaDb->queryFormula(formulaId, 0, 1000,
+            [&formulae, crawlDb](const dbc::CrawlId& crawlId,
+                                 const types::FormulaPath& formulaPath) {
+        string data = (crawlId == dbc::CRAWLID_NULL) ?
+                "" : crawlDb->getData(crawlId);
+        formulae.push_back(data + formulaPath.xmlId + formulaPath.xpath);
+        return 0;
+    });
+
+    return formulae;
+}
+
+/// Write a segment as mws-index -m does
+static int buildSegment(const string& path, const vector<string>& harvests,
+                        MeaningDictionary* meaningDictionary) {
+    dbc::MmapCrawlDb crawlDb;
+    dbc::MmapFormulaDb formulaDb;
+    MwsIndexNode data;
+    index::IndexingOptions indexingOptions;
+    const string memsectorPath = path + "/memsector.dat";
+    memsector_writer_t mswr;
+
+    indexingOptions.renameCi = false;
+    mkdir(path.c_str(), 0755);
+    crawlDb.create_new((path + "/crawl.dat").c_str(), true);
+    formulaDb.create_new((path + "/formula.dat").c_str(), true);
+    index::IndexManager indexManager(&formulaDb, &crawlDb, &data,
+                                     meaningDictionary, indexingOptions);
+    FAIL_ON(loadHarvests(&indexManager, harvests) != 0);
+    crawlDb.save();
+    formulaDb.save();
+    FAIL_ON(unlink(memsectorPath.c_str()) != 0 && errno != ENOENT);
+    FAIL_ON(memsector_create(&mswr, memsectorPath.c_str(),
+                             MEMSECTOR_INITIAL_SIZE) != 0);
+    FAIL_ON(data.exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+struct Tester {
+    /// Expected index, built at once
+    MwsIndexNode data;
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+    MeaningDictionary meaningDictionary;
+    /// Compacted index
+    memsector_handle_t ms;
+    dbc::MmapCrawlDb compactCrawlDb;
+    dbc::MmapFormulaDb compactFormulaDb;
+
+    bool sameIndex(const MwsIndexNode* node, const inode_t* inode) {
+        if (node->children.size() == 0) {
+            const leaf_t* leaf = (const leaf_t*) inode;
+            FAIL_ON(leaf->type != LEAF_NODE);
+            FAIL_ON(leaf->num_hits != node->solutions);
+            FAIL_ON(getFormulae(&formulaDb, &crawlDb, node->id) !=
+                    getFormulae(&compactFormulaDb, &compactCrawlDb,
+                                leaf->formula_id));
+        } else {
+            FAIL_ON(inode->type != INTERNAL_NODE);
+            FAIL_ON(inode->size != node->children.size());
+            uint32_t i = 0;
+            for (auto& kv : node->children) {
+                encoded_token_t token =
+                        inode_get_token(inode, ms.index.format, i);
+                FAIL_ON(memcmp(&kv.first, &token,
+                               sizeof(encoded_token_t)) != 0);
+                const inode_t* child = (const inode_t*)
+                        memsector_off2addr(ms.alloc, ms.index.off_shift,
+                                           inode_get_off(&ms.index, inode,
+                                                         i));
+                FAIL_ON(!sameIndex(kv.second, child));
+                i++;
+            }
+        }
+
+        return true;
+
+    fail:
+        return false;
+    }
+
+    int testCompaction() {
+        const vector<vector<string> > segmentHarvests = {
+            {"data1.harvest", "data2.harvest"},
+            {"data3.harvest"},
+            {"data4.harvest", "eq_ambiguity.harvest"},
+        };
+        const string indexPath = TMP_INDEX_PATH;
+        const string meaningPath = indexPath + "/meaning.dat";
+        index::IndexingOptions indexingOptions;
+        index::CompactionOptions options;
+        MeaningDictionary indexMeaningDictionary;
+        MeaningDictionary compactMeaningDictionary;
+        std::filebuf fb;
+        std::ostream os(&fb);
+        std::istream is(&fb);
+
+        indexingOptions.renameCi = false;
+        index::IndexManager indexManager(&formulaDb, &crawlDb, &data,
+                                         &meaningDictionary,
+                                         indexingOptions);
+        for (size_t i = 0; i < segmentHarvests.size(); i++) {
+            FAIL_ON(loadHarvests(&indexManager, segmentHarvests[i]) != 0);
+            string path = (i == 0) ? indexPath :
+                    index::getDeltaSegmentPath(indexPath, i);
+            FAIL_ON(buildSegment(path, segmentHarvests[i],
+                                 &indexMeaningDictionary) != 0);
+        }
+        FAIL_ON(fb.open(meaningPath.c_str(), std::ios::out) == NULL);
+        indexMeaningDictionary.save(os);
+        fb.close();
+
+        // an abandoned compaction leaves the index unchanged
+        options.isCancelled = []() { return true; };
+        FAIL_ON(index::compactIndex(indexPath, options) != -1);
+        FAIL_ON(index::getDeltaSegments(indexPath).size() != 2);
+        FAIL_ON(access((indexPath + ".compact").c_str(), F_OK) == 0);
+
+        options.isCancelled = nullptr;
+        options.maxWriteRate = 1 << 20;
+        FAIL_ON(index::compactIndex(indexPath, options) != 3);
+        FAIL_ON(!index::getDeltaSegments(indexPath).empty());
+        FAIL_ON(access((indexPath + ".old/delta-2").c_str(), F_OK) != 0);
+        FAIL_ON(index::compactIndex(indexPath, options) != 0);
+
+        FAIL_ON(fb.open(meaningPath.c_str(), std::ios::in) == NULL);
+        FAIL_ON(compactMeaningDictionary.load(is) != 0);
+        fb.close();
+        FAIL_ON(compactMeaningDictionary.getKeys() !=
+                meaningDictionary.getKeys());
+        compactCrawlDb.open((indexPath + "/crawl.dat").c_str());
+        compactFormulaDb.open((indexPath + "/formula.dat").c_str());
+        FAIL_ON(memsector_load(&ms, (indexPath + "/memsector.dat").c_str())
+                != 0);
+        FAIL_ON(!sameIndex(&data, ms.index.root));
+        memsector_unload(&ms);
+
+        return 0;
+
+    fail:
+        return -1;
+    }
+};
+
+int main() {
+    Tester tester;
+
+    FAIL_ON(initxmlparser() != 0);
+    FAIL_ON(tester.testCompaction() != 0);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,190 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file IndexCompaction_openLevelDb.cpp
+ * @brief Test compacting an index whose LevelDB databases are held open,
+ * as mwsd-load holds those of the index it serves
+ * @date 18 Oct 2026
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mws/dbc/LevCrawlDb.hpp"
+#include "mws/dbc/LevFormulaDb.hpp"
+#include "mws/index/IndexCompaction.hpp"
+#include "mws/index/IndexManager.hpp"
+#include "mws/index/IndexSegments.hpp"
+#include "mws/index/MeaningDictionary.hpp"
+using mws::index::MeaningDictionary;
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/SegmentDatabases.hpp"
+using mws::index::SegmentDatabasesList;
+using mws::index::openSegmentDatabases;
+#include "mws/index/memsector.h"
+#include "mws/xmlparser/initxmlparser.hpp"
+#include "mws/xmlparser/processMwsHarvest.hpp"
+#include "common/utils/compiler_defs.h"
+
+#include "build-gen/config.h"
+
+#define TMP_INDEX_PATH  "/tmp/test-compact-leveldb-index"
+
+using namespace std;
+using namespace mws;
+
+/// Write a segment as mws-index does, with LevelDB databases
+static int buildSegment(const string& path, const string& harvest,
+                        MeaningDictionary* meaningDictionary) {
+    dbc::LevCrawlDb crawlDb;
+    dbc::LevFormulaDb formulaDb;
+    MwsIndexNode data;
+    index::IndexingOptions indexingOptions;
+    const string harvestPath = (string) MWS_TESTDATA_PATH + "/" + harvest;
+    const string memsectorPath = path + "/memsector.dat";
+    memsector_writer_t mswr;
+    int fd;
+
+    mkdir(path.c_str(), 0755);
+    crawlDb.create_new((path + "/crawl.db").c_str(), true);
+    formulaDb.create_new((path + "/formula.db").c_str(), true);
+    index::IndexManager indexManager(&formulaDb, &crawlDb, &data,
+                                     meaningDictionary, indexingOptions);
+    FAIL_ON((fd = open(harvestPath.c_str(), O_RDONLY)) < 0);
+    parser::loadMwsHarvestFromFd(&indexManager, fd);
+    close(fd);
+    FAIL_ON(unlink(memsectorPath.c_str()) != 0 && errno != ENOENT);
+    FAIL_ON(memsector_create(&mswr, memsectorPath.c_str(),
+                             MEMSECTOR_INITIAL_SIZE) != 0);
+    FAIL_ON(data.exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+/// @return number of hits under inode, each found in formulaDb
+static int countHits(const memsector_handle_t* ms, const inode_t* inode,
+                     dbc::FormulaDb* formulaDb) {
+    if (inode->type == LEAF_NODE) {
+        const leaf_t* leaf = (const leaf_t*) inode;
+        int numFound = 0;
+        formulaDb->queryFormula(leaf->formula_id, 0, 1000,
+                [&numFound](const dbc::CrawlId&, const types::FormulaPath&) {
+            numFound++;
+            return 0;
+        });
+        return (numFound == (int) leaf->num_hits) ? numFound : -1;
+    }
+
+    int numHits = 0;
+    for (uint32_t i = 0; i < inode->size; i++) {
+        const inode_t* child = (const inode_t*)
+                memsector_off2addr(ms->alloc, ms->index.off_shift,
+                                   inode_get_off(&ms->index, inode, i));
+        int childHits = countHits(ms, child, formulaDb);
+        if (childHits < 0) return -1;
+        numHits += childHits;
+    }
+
+    return numHits;
+}
+
+static int countSegmentHits(const string& path, dbc::FormulaDb* formulaDb) {
+    memsector_handle_t ms;
+    int numHits;
+
+    if (memsector_load(&ms, (path + "/memsector.dat").c_str()) != 0) {
+        return -1;
+    }
+    numHits = countHits(&ms, ms.index.root, formulaDb);
+    memsector_unload(&ms);
+
+    return numHits;
+}
+
+int main() {
+    const string indexPath = TMP_INDEX_PATH;
+    const string deltaPath = index::getDeltaSegmentPath(indexPath, 1);
+    MeaningDictionary meaningDictionary;
+    index::CompactionOptions options;
+    SegmentDatabasesList opened;
+    shared_ptr<index::SegmentDatabases> compacted;
+    std::ofstream out;
+    int numHits;
+    int deltaHits;
+    bool swapped = false;
+
+    FAIL_ON(initxmlparser() != 0);
+    FAIL_ON(index::removeDirectory(indexPath) != 0);
+    FAIL_ON(index::removeDirectory(indexPath + ".old") != 0);
+    FAIL_ON(buildSegment(indexPath, "data1.harvest",
+                         &meaningDictionary) != 0);
+    FAIL_ON(buildSegment(deltaPath, "data3.harvest",
+                         &meaningDictionary) != 0);
+    out.open((indexPath + "/meaning.dat").c_str());
+    meaningDictionary.save(out);
+    out.close();
+
+    // held open, as by the daemon serving the index
+    opened.push_back(openSegmentDatabases(indexPath, opened));
+    opened.push_back(openSegmentDatabases(deltaPath, opened));
+    FAIL_ON(opened[0] == NULL || opened[1] == NULL);
+    FAIL_ON(!opened[0]->isLevelDb);
+    FAIL_ON((numHits = countSegmentHits(indexPath,
+                                        opened[0]->formulaDb)) <= 0);
+    FAIL_ON((deltaHits = countSegmentHits(deltaPath,
+                                          opened[1]->formulaDb)) <= 0);
+    numHits += deltaHits;
+
+    // they cannot be opened again
+    FAIL_ON(index::compactIndex(indexPath, options) != -1);
+    FAIL_ON(index::getDeltaSegments(indexPath).size() != 1);
+
+    options.databases = opened;
+    options.beforeSwap = [&]() {
+        options.databases.clear();
+        opened.clear();
+        swapped = true;
+    };
+    FAIL_ON(index::compactIndex(indexPath, options) != 2);
+    FAIL_ON(!swapped);
+    FAIL_ON(!index::getDeltaSegments(indexPath).empty());
+
+    // closed before the swap, so the compacted index can be opened
+    compacted = openSegmentDatabases(indexPath, opened);
+    FAIL_ON(compacted == NULL || !compacted->isLevelDb);
+    FAIL_ON(countSegmentHits(indexPath, compacted->formulaDb) != numHits);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
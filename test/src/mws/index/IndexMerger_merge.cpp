@@ -0,0 +1,201 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file IndexMerger_merge.cpp
+ * @brief Test that merging index shards gives the same index as building it
+ * from all harvests at once
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "mws/dbc/MemCrawlDb.hpp"
+#include "mws/dbc/MemFormulaDb.hpp"
+#include "mws/index/IndexManager.hpp"
+#include "mws/index/IndexMerger.hpp"
+#include "mws/index/MeaningDictionary.hpp"
+using mws::index::MeaningDictionary;
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/xmlparser/initxmlparser.hpp"
+#include "mws/xmlparser/processMwsHarvest.hpp"
+#include "common/utils/compiler_defs.h"
+
+#include "build-gen/config.h"
+
+#define TMP_MEMSECTOR_PATH  "/tmp/test-merge.memsector"
+
+using namespace std;
+using namespace mws;
+
+struct Index {
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+    MwsIndexNode data;
+    MeaningDictionary meaningDictionary;
+    memsector_handle_t ms;
+
+    int load(const vector<string>& harvests) {
+        index::IndexingOptions indexingOptions;
+        indexingOptions.renameCi = false;
+        index::IndexManager indexManager(&formulaDb, &crawlDb, &data,
+                                         &meaningDictionary, indexingOptions);
+        for (const string& harvest : harvests) {
+            string path = (string) MWS_TESTDATA_PATH + "/" + harvest;
+            int fd = open(path.c_str(), O_RDONLY);
+            FAIL_ON(fd < 0);
+            parser::loadMwsHarvestFromFd(&indexManager, fd);
+            close(fd);
+        }
+
+        return 0;
+
+    fail:
+        return -1;
+    }
+
+    vector<string> getFormulae(uint32_t formulaId) {
+        vector<string> formulae;
+        formulaDb.queryFormula(formulaId, 0, 1000,
+                [&formulae, this](const dbc::CrawlId& crawlId,
+                                  const types::FormulaPath& formulaPath) {
+            string data = (crawlId == dbc::CRAWLID_NULL) ?
+                    "" : crawlDb.getData(crawlId);
+            formulae.push_back(data + formulaPath.xmlId + formulaPath.xpath);
+            return 0;
+        });
+
+        return formulae;
+    }
+};
+
+static int exportIndex(Index* index, const char* path,
+                       index_format_t format) {
+    memsector_writer_t mswr;
+
+    FAIL_ON(unlink(path) != 0 && errno != ENOENT);
+    FAIL_ON(memsector_create_format(&mswr, path, MEMSECTOR_INITIAL_SIZE,
+                                    format, /* off_shift = */ 0) != 0);
+    FAIL_ON(index->data.exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+    FAIL_ON(memsector_load(&index->ms, path) != 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+struct Tester {
+    static bool sameIndex(Index* expected, const MwsIndexNode* node,
+                          Index* merged, const inode_t* inode) {
+        if (node->children.size() == 0) {
+            const leaf_t* leaf = (const leaf_t*) inode;
+            FAIL_ON(leaf->type != LEAF_NODE);
+            FAIL_ON(leaf->num_hits != node->solutions);
+            FAIL_ON(expected->getFormulae(node->id) !=
+                    merged->getFormulae(leaf->formula_id));
+        } else {
+            FAIL_ON(inode->type != INTERNAL_NODE);
+            FAIL_ON(inode->size != node->children.size());
+            uint32_t i = 0;
+            for (auto& kv : node->children) {
+                const index_format_t format = merged->ms.index.format;
+                encoded_token_t token = inode_get_token(inode, format, i);
+                FAIL_ON(memcmp(&kv.first, &token,
+                               sizeof(encoded_token_t)) != 0);
+                const inode_t* child = (const inode_t*)
+                        memsector_off2addr(merged->ms.alloc,
+                                           merged->ms.index.off_shift,
+                                           inode_get_off(&merged->ms.index,
+                                                         inode, i));
+                FAIL_ON(!sameIndex(expected, kv.second, merged, child));
+                i++;
+            }
+        }
+
+        return true;
+
+    fail:
+        return false;
+    }
+};
+
+int main() {
+    const vector<string> shard1Harvests = { "data1.harvest", "data2.harvest" };
+    const vector<string> shard2Harvests = { "data3.harvest", "data4.harvest",
+                                            "eq_ambiguity.harvest" };
+    vector<string> allHarvests = shard1Harvests;
+    allHarvests.insert(allHarvests.end(), shard2Harvests.begin(),
+                       shard2Harvests.end());
+    Index expected, shard1, shard2;
+
+    FAIL_ON(initxmlparser() != 0);
+    FAIL_ON(expected.load(allHarvests) != 0);
+    FAIL_ON(shard1.load(shard1Harvests) != 0);
+    FAIL_ON(shard2.load(shard2Harvests) != 0);
+    // shards of different formats
+    FAIL_ON(exportIndex(&shard1, TMP_MEMSECTOR_PATH ".1",
+                        INDEX_FORMAT_LATEST) != 0);
+    FAIL_ON(exportIndex(&shard2, TMP_MEMSECTOR_PATH ".2",
+                        INDEX_FORMAT_COMPACT) != 0);
+
+    for (index_format_t format : {INDEX_FORMAT_LATEST,
+                                  INDEX_FORMAT_COMPACT}) {
+        Index merged;
+        index::IndexMerger merger(&merged.formulaDb, &merged.crawlDb,
+                                  &merged.meaningDictionary);
+        memsector_writer_t mswr;
+
+        merger.addShard({&shard1.ms.index, &shard1.meaningDictionary,
+                         &shard1.formulaDb, &shard1.crawlDb});
+        merger.addShard({&shard2.ms.index, &shard2.meaningDictionary,
+                         &shard2.formulaDb, &shard2.crawlDb});
+
+        FAIL_ON(unlink(TMP_MEMSECTOR_PATH) != 0 && errno != ENOENT);
+        FAIL_ON(memsector_create_format(&mswr, TMP_MEMSECTOR_PATH,
+                                        MEMSECTOR_INITIAL_SIZE, format,
+                                        /* off_shift = */ 0) != 0);
+        FAIL_ON(merger.exportToMemsector(&mswr) != 0);
+        FAIL_ON(memsector_save(&mswr) != 0);
+        FAIL_ON(memsector_load(&merged.ms, TMP_MEMSECTOR_PATH) != 0);
+        FAIL_ON(merged.ms.index.format != format);
+
+        FAIL_ON(expected.meaningDictionary.getKeys() !=
+                merged.meaningDictionary.getKeys());
+        FAIL_ON(!Tester::sameIndex(&expected, &expected.data,
+                                   &merged, merged.ms.index.root));
+
+        FAIL_ON(memsector_remove(&merged.ms) != 0);
+    }
+    FAIL_ON(memsector_remove(&shard1.ms) != 0);
+    FAIL_ON(memsector_remove(&shard2.ms) != 0);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
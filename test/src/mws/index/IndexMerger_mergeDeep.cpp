@@ -0,0 +1,178 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file IndexMerger_mergeDeep.cpp
+ * @brief Merge of shards holding very deep formulae
+ */
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "mws/dbc/MemCrawlDb.hpp"
+#include "mws/dbc/MemFormulaDb.hpp"
+#include "mws/index/IndexMerger.hpp"
+#include "mws/index/MeaningDictionary.hpp"
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/index/index.h"
+#include "common/utils/compiler_defs.h"
+
+#define TMP_MEMSECTOR_PATH  "/tmp/test-merge-deep.memsector"
+#define FORMULA_DEPTH       (1 << 20)
+
+using namespace std;
+using namespace mws;
+
+struct Shard {
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+    MwsIndexNode data;
+    index::MeaningDictionary meaningDictionary;
+    memsector_handle_t ms;
+};
+
+struct Tester {
+    static int buildShard(Shard* shard, const vector<encoded_token_t>& formula,
+                          const string& xpath, const char* path);
+    static int testDeepMerge(Shard* shard1, Shard* shard2,
+                             index_format_t format);
+};
+
+int Tester::buildShard(Shard* shard, const vector<encoded_token_t>& formula,
+                       const string& xpath, const char* path) {
+    memsector_writer_t mswr;
+    types::FormulaPath formulaPath;
+    MwsIndexNode* leafNode = shard->data.insertData(formula);
+
+    leafNode->solutions = 1;
+    formulaPath.xpath = xpath;
+    FAIL_ON(shard->formulaDb.insertFormula(leafNode->id, dbc::CRAWLID_NULL,
+                                           formulaPath) != 0);
+    FAIL_ON(unlink(path) != 0 && errno != ENOENT);
+    FAIL_ON(memsector_create(&mswr, path, MEMSECTOR_INITIAL_SIZE) != 0);
+    FAIL_ON(shard->data.exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+    FAIL_ON(memsector_load(&shard->ms, path) != 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+/// The shards share all but the last token of their formulae
+int Tester::testDeepMerge(Shard* shard1, Shard* shard2,
+                          index_format_t format) {
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+    index::MeaningDictionary meaningDictionary;
+    index::IndexMerger merger(&formulaDb, &crawlDb, &meaningDictionary);
+    memsector_writer_t mswr;
+    memsector_handle_t ms;
+    const inode_t* inode;
+    uint64_t size;
+    vector<string> xpaths;
+
+    merger.addShard({&shard1->ms.index, &shard1->meaningDictionary,
+                     &shard1->formulaDb, &shard1->crawlDb});
+    merger.addShard({&shard2->ms.index, &shard2->meaningDictionary,
+                     &shard2->formulaDb, &shard2->crawlDb});
+    size = merger.getMemsectorSize(format, /* offShift = */ 0,
+                                   /* subtreeCounts = */ true);
+
+    FAIL_ON(unlink(TMP_MEMSECTOR_PATH) != 0 && errno != ENOENT);
+    // Start from a single page to go through many grow steps
+    FAIL_ON(memsector_create_flags(&mswr, TMP_MEMSECTOR_PATH, 4096, format,
+                                   /* off_shift = */ 0,
+                                   MEMSECTOR_FLAG_SUBTREE_COUNTS) != 0);
+    FAIL_ON(merger.exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+    FAIL_ON(memsector_load(&ms, TMP_MEMSECTOR_PATH) != 0);
+    FAIL_ON(ms.index.format != format);
+    if (format == INDEX_FORMAT_COMPACT) {
+        FAIL_ON(memsector_size_inuse(ms.alloc, ms.index.off_shift) > size);
+    } else {
+        FAIL_ON(memsector_size_inuse(ms.alloc, ms.index.off_shift) != size);
+        FAIL_ON(inode_get_counts(ms.index.root)->num_hits != 2);
+    }
+
+    inode = ms.index.root;
+    for (int i = 0; i <= FORMULA_DEPTH; i++) {
+        const uint32_t numChildren = (i == FORMULA_DEPTH) ? 2 : 1;
+        FAIL_ON(inode->type != INTERNAL_NODE);
+        FAIL_ON(inode->size != numChildren);
+        if (numChildren == 1) {
+            inode = (const inode_t*) memsector_off2addr(ms.alloc,
+                    ms.index.off_shift, inode_get_off(&ms.index, inode, 0));
+        }
+    }
+    for (uint32_t i = 0; i < 2; i++) {
+        const leaf_t* leaf = (const leaf_t*) memsector_off2addr(ms.alloc,
+                ms.index.off_shift, inode_get_off(&ms.index, inode, i));
+        FAIL_ON(leaf->type != LEAF_NODE);
+        FAIL_ON(leaf->num_hits != 1);
+        formulaDb.queryFormula(leaf->formula_id, 0, 1,
+                [&xpaths](const dbc::CrawlId&,
+                          const types::FormulaPath& formulaPath) {
+            xpaths.push_back(formulaPath.xpath);
+            return 0;
+        });
+    }
+    FAIL_ON(xpaths != vector<string>({"shard1", "shard2"}));
+
+    FAIL_ON(memsector_remove(&ms) != 0);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    Shard shard1, shard2;
+    vector<encoded_token_t> formula;
+
+    for (int i = 0; i < FORMULA_DEPTH; i++) {
+        formula.push_back(encoded_token(i % HVAR_ID_MAX + 1, 1));
+    }
+    formula.push_back(encoded_token(HVAR_ID_MIN, 0));
+    FAIL_ON(Tester::buildShard(&shard1, formula, "shard1",
+                               TMP_MEMSECTOR_PATH ".1") != 0);
+    formula.back() = encoded_token(HVAR_ID_MIN + 1, 0);
+    FAIL_ON(Tester::buildShard(&shard2, formula, "shard2",
+                               TMP_MEMSECTOR_PATH ".2") != 0);
+
+    FAIL_ON(Tester::testDeepMerge(&shard1, &shard2,
+                                  INDEX_FORMAT_LATEST) != 0);
+    FAIL_ON(Tester::testDeepMerge(&shard1, &shard2,
+                                  INDEX_FORMAT_COMPACT) != 0);
+
+    FAIL_ON(memsector_remove(&shard1.ms) != 0);
+    FAIL_ON(memsector_remove(&shard2.ms) != 0);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
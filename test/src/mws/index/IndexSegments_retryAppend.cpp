@@ -0,0 +1,82 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file IndexSegments_retryAppend.cpp
+ * @brief Appending a delta segment after an append which failed midway
+ */
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "mws/index/IndexSegments.hpp"
+#include "common/utils/compiler_defs.h"
+
+#define TMP_INDEX_PATH  "/tmp/test-retry-append"
+
+using namespace std;
+using namespace mws::index;
+
+int main() {
+    const string indexPath = TMP_INDEX_PATH;
+    string segmentPath, deltaPath;
+    FILE* file;
+    int lock = -1;
+
+    FAIL_ON(removeDirectory(indexPath) != 0);
+    FAIL_ON(mkdir(indexPath.c_str(), 0755) != 0);
+
+    // an append which fails before publishing its segment
+    FAIL_ON((lock = lockIndex(indexPath)) < 0);
+    segmentPath = createDeltaSegment(indexPath, &deltaPath);
+    FAIL_ON(segmentPath != indexPath + "/delta-1.tmp");
+    FAIL_ON(deltaPath != indexPath + "/delta-1");
+    FAIL_ON((file = fopen((segmentPath + "/crawl.dat").c_str(), "w")) == NULL);
+    fclose(file);
+    unlockIndex(lock);
+    FAIL_ON(!getDeltaSegments(indexPath).empty());
+
+    // the next append writes the same segment from scratch
+    FAIL_ON((lock = lockIndex(indexPath)) < 0);
+    segmentPath = createDeltaSegment(indexPath, &deltaPath);
+    FAIL_ON(segmentPath != indexPath + "/delta-1.tmp");
+    FAIL_ON(access((segmentPath + "/crawl.dat").c_str(), F_OK) == 0);
+    FAIL_ON(rename(segmentPath.c_str(), deltaPath.c_str()) != 0);
+    unlockIndex(lock);
+    FAIL_ON(getDeltaSegments(indexPath) != vector<int>({1}));
+
+    FAIL_ON((lock = lockIndex(indexPath)) < 0);
+    segmentPath = createDeltaSegment(indexPath, &deltaPath);
+    FAIL_ON(segmentPath != indexPath + "/delta-2.tmp");
+    FAIL_ON(deltaPath != indexPath + "/delta-2");
+    unlockIndex(lock);
+
+    FAIL_ON(removeDirectory(indexPath) != 0);
+    (void) remove(getIndexSiblingPath(indexPath, ".lock").c_str());
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
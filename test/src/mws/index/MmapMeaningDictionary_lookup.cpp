@@ -0,0 +1,120 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file MmapMeaningDictionary_lookup.cpp
+ * @brief Check meanings saved by MmapMeaningDictionary are looked up with
+ * the ids of the MeaningDictionary
+ * @date 18 Oct 2026
+ */
+
+#include <stdio.h>
+
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "mws/index/MeaningDictionary.hpp"
+using mws::index::MeaningDictionary;
+#include "mws/index/MmapMeaningDictionary.hpp"
+using mws::index::MmapMeaningDictionary;
+
+const char IDX_PATH[] = "/tmp/test_MmapMeaningDictionary.idx";
+const char DAT_PATH[] = "/tmp/test_MmapMeaningDictionary.dat";
+const MeaningId KEY_NOT_FOUND = MeaningDictionary::KEY_NOT_FOUND;
+
+int main() {
+    MeaningDictionary dictionary;
+    MmapMeaningDictionary* mmapDictionary = NULL;
+    vector<string> misses;
+    FILE* file;
+
+    // an empty key and sizes which are not multiples of 8
+    dictionary.put("");
+    dictionary.put(string("nul\0byte", 8));
+    for (int i = 0; i < 5000; i++) {
+        dictionary.put("csymbol#" + std::to_string(i));
+        misses.push_back("ci#" + std::to_string(i));
+    }
+    misses.push_back(string("nul", 3));
+    misses.push_back("csymbol#");
+    misses.push_back("csymbol#50000");
+
+    FAIL_ON((file = fopen(DAT_PATH, "w")) == NULL);
+    fclose(file);
+    MmapMeaningDictionary::save(dictionary, IDX_PATH);
+    FAIL_ON(!MmapMeaningDictionary::isUpToDate(IDX_PATH, DAT_PATH));
+
+    mmapDictionary = new MmapMeaningDictionary();
+    mmapDictionary->open(IDX_PATH);
+    FAIL_ON(mmapDictionary->size() != dictionary.getKeys().size());
+    for (const string& key : dictionary.getKeys()) {
+        FAIL_ON(mmapDictionary->get(key) == KEY_NOT_FOUND);
+        FAIL_ON(mmapDictionary->get(key) != dictionary.get(key));
+    }
+    for (const string& key : misses) {
+        FAIL_ON(mmapDictionary->get(key) != KEY_NOT_FOUND);
+    }
+    delete mmapDictionary;
+
+    // an empty dictionary finds nothing
+    MmapMeaningDictionary::save(MeaningDictionary(), IDX_PATH);
+    mmapDictionary = new MmapMeaningDictionary();
+    mmapDictionary->open(IDX_PATH);
+    FAIL_ON(mmapDictionary->size() != 0);
+    FAIL_ON(mmapDictionary->get("") != KEY_NOT_FOUND);
+    FAIL_ON(mmapDictionary->get("csymbol#0") != KEY_NOT_FOUND);
+    delete mmapDictionary;
+
+    // files which are not dictionaries are rejected
+    mmapDictionary = new MmapMeaningDictionary();
+    try {
+        mmapDictionary->open(DAT_PATH);
+        goto fail;
+    } catch (...) {
+        // ignore
+    }
+    delete mmapDictionary;
+    FAIL_ON((file = fopen(DAT_PATH, "w")) == NULL);
+    fputs(string(100, 'x').c_str(), file);
+    fclose(file);
+    mmapDictionary = new MmapMeaningDictionary();
+    try {
+        mmapDictionary->open(DAT_PATH);
+        goto fail;
+    } catch (...) {
+        // ignore
+    }
+    delete mmapDictionary;
+
+    // a dictionary saved before meaning.dat is out of date
+    FAIL_ON(MmapMeaningDictionary::isUpToDate(IDX_PATH, DAT_PATH));
+    FAIL_ON(MmapMeaningDictionary::isUpToDate("/nonexistent", DAT_PATH));
+
+    (void) remove(IDX_PATH);
+    (void) remove(DAT_PATH);
+
+    return 0;
+
+fail:
+    return -1;
+}
@@ -0,0 +1,100 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file MwsIndexNode_exportDeep.cpp
+ * @brief Export of a very deep index through a growing memsector
+ */
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/index/index.h"
+#include "common/utils/compiler_defs.h"
+
+#define TMP_MEMSECTOR_PATH  "/tmp/test-deep.memsector"
+#define FORMULA_DEPTH       (1 << 20)
+
+using namespace std;
+using namespace mws;
+
+struct Tester {
+    static int testDeepExport();
+};
+
+int Tester::testDeepExport() {
+    memsector_writer_t mswr;
+    memsector_handle_t ms;
+    MwsIndexNode* data = new MwsIndexNode();
+    vector<encoded_token_t> formula;
+    const inode_t* inode;
+    const leaf_t* leaf;
+    MwsIndexNode* leafNode;
+
+    for (int i = 0; i < FORMULA_DEPTH; i++) {
+        formula.push_back(encoded_token(i % 1000 + 1, 1));
+    }
+    leafNode = data->insertData(formula);
+    leafNode->solutions = 1;
+
+    FAIL_ON(unlink(TMP_MEMSECTOR_PATH) != 0 && errno != ENOENT);
+    // Start from a single page to go through many grow steps
+    FAIL_ON(memsector_create_flags(&mswr, TMP_MEMSECTOR_PATH, 4096,
+                                   INDEX_FORMAT_LATEST, /* off_shift = */ 0,
+                                   MEMSECTOR_FLAG_SUBTREE_COUNTS) != 0);
+    FAIL_ON(data->exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+    FAIL_ON(memsector_load(&ms, TMP_MEMSECTOR_PATH) != 0);
+    FAIL_ON(!ms.index.subtree_counts);
+    FAIL_ON(memsector_size_inuse(ms.alloc, ms.index.off_shift) !=
+            sizeof(memsector_header_t) + FORMULA_DEPTH *
+            (sizeof(inode_counts_t) + inode_size(ms.index.format, 1)) +
+            leaf_size());
+
+    inode = ms.index.root;
+    for (const encoded_token_t& token : formula) {
+        FAIL_ON(inode->type != INTERNAL_NODE);
+        FAIL_ON(inode->size != 1);
+        FAIL_ON(inode_get_counts(inode)->num_hits != 1);
+        FAIL_ON(inode_get_token(inode, ms.index.format, 0).id != token.id);
+        inode = (const inode_t*) memsector_off2addr(ms.alloc,
+                ms.index.off_shift, inode_get_off(&ms.index, inode, 0));
+    }
+    leaf = (const leaf_t*) inode;
+    FAIL_ON(leaf->type != LEAF_NODE);
+    FAIL_ON(leaf->num_hits != 1);
+    FAIL_ON(leaf->formula_id != leafNode->id);
+
+    FAIL_ON(memsector_remove(&ms) != 0);
+    delete data;
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    return Tester::testDeepExport() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
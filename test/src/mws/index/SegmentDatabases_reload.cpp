@@ -0,0 +1,107 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file SegmentDatabases_reload.cpp
+ * @brief Test opening the LevelDB databases of a segment again, as
+ * mwsd-load does when reloading its index
+ * @date 18 Oct 2026
+ */
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include "mws/dbc/LevCrawlDb.hpp"
+#include "mws/dbc/LevFormulaDb.hpp"
+#include "mws/index/IndexSegments.hpp"
+#include "mws/index/SegmentDatabases.hpp"
+using mws::index::SegmentDatabases;
+using mws::index::SegmentDatabasesList;
+using mws::index::openSegmentDatabases;
+#include "common/utils/compiler_defs.h"
+
+#define TMP_DATA_PATH   "/tmp/test-reload-segment"
+#define FIRST_CRAWL_ID  (dbc::CRAWLID_NULL + 1)
+
+using namespace std;
+using namespace mws;
+
+/// Write the LevelDB databases of a segment, whose crawl data is data
+static int buildSegment(const string& path, const string& data) {
+    dbc::LevCrawlDb crawlDb;
+    dbc::LevFormulaDb formulaDb;
+
+    FAIL_ON(index::removeDirectory(path) != 0);
+    FAIL_ON(mkdir(path.c_str(), 0755) != 0);
+    crawlDb.create_new((path + "/crawl.db").c_str(), true);
+    formulaDb.create_new((path + "/formula.db").c_str(), true);
+    FAIL_ON(crawlDb.putData(data) != FIRST_CRAWL_ID);
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    const string linkPath = TMP_DATA_PATH;
+    const string path1 = linkPath + "-1";
+    const string path2 = linkPath + "-2";
+    shared_ptr<SegmentDatabases> loaded;
+    shared_ptr<SegmentDatabases> reloaded;
+
+    FAIL_ON(buildSegment(path1, "data1") != 0);
+    FAIL_ON(buildSegment(path2, "data2") != 0);
+    unlink(linkPath.c_str());
+    FAIL_ON(symlink(path1.c_str(), linkPath.c_str()) != 0);
+
+    loaded = openSegmentDatabases(linkPath, SegmentDatabasesList());
+    FAIL_ON(loaded == NULL || !loaded->isLevelDb);
+    FAIL_ON(loaded->path != index::getRealPath(path1));
+    FAIL_ON(loaded->crawlDb->getData(FIRST_CRAWL_ID) != "data1");
+
+    // locked by the loaded generation
+    FAIL_ON(openSegmentDatabases(linkPath, SegmentDatabasesList()) != NULL);
+    // the same directory is shared
+    reloaded = openSegmentDatabases(linkPath, {loaded});
+    FAIL_ON(reloaded != loaded);
+
+    // the link retargeted to another index, which is opened
+    FAIL_ON(unlink(linkPath.c_str()) != 0);
+    FAIL_ON(symlink(path2.c_str(), linkPath.c_str()) != 0);
+    reloaded = openSegmentDatabases(linkPath, {loaded});
+    FAIL_ON(reloaded == NULL || reloaded == loaded);
+    FAIL_ON(reloaded->crawlDb->getData(FIRST_CRAWL_ID) != "data2");
+
+    // closed with the last generation sharing it
+    loaded.reset();
+    loaded = openSegmentDatabases(path1, {reloaded});
+    FAIL_ON(loaded == NULL);
+    FAIL_ON(loaded->crawlDb->getData(FIRST_CRAWL_ID) != "data1");
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
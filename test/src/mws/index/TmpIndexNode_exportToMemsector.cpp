@@ -27,12 +27,14 @@ along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
 #include <unistd.h>
 
 #include <string>
+#include <tuple>
 
 #include "mws/dbc/MemCrawlDb.hpp"
 #include "mws/dbc/MemFormulaDb.hpp"
 #include "mws/index/MwsIndexNode.hpp"
 #include "mws/index/memsector.h"
 #include "mws/index/IndexManager.hpp"
+#include "mws/index/TmpIndexAccessor.hpp"
 #include "mws/index/MeaningDictionary.hpp"
 using mws::index::MeaningDictionary;
 #include "mws/xmlparser/processMwsHarvest.hpp"
@@ -48,7 +50,7 @@ using common::utils::FlagParser;
 using namespace std;
 using namespace mws;
 
-const memsector_alloc_header_t *alloc;
+const index_handle_t *ms_index;
 
 struct Tester {
     static inline
@@ -57,16 +59,29 @@ struct Tester {
         switch (inode->type) {
         case INTERNAL_NODE: {
             if (tmp_node->children.size() != inode->size) return false;
+            if (ms_index->subtree_counts &&
+                    inode_get_counts(inode)->num_hits !=
+                    index::TmpIndexAccessor::getSubtreeHitsCount(
+                        const_cast<MwsIndexNode*>(tmp_node))) {
+                return false;
+            }
             int i = 0;
             for (auto& kv : tmp_node->children) {
                 MeaningId           meaningId  = kv.first.id;
                 Arity               arity      = kv.first.arity;
                 const MwsIndexNode* child_node = kv.second;
 
-                if (meaningId != inode->data[i].token.id) return false;
-                if (arity     != inode->data[i].token.arity) return false;
+                encoded_token_t token =
+                        inode_get_token(inode, ms_index->format, i);
+                memsector_off_t off = inode_get_off(ms_index, inode, i);
+                if (meaningId != token.id) return false;
+                if (arity     != token.arity) return false;
+                if (inode_get_child(ms_index, inode, kv.first) != off) {
+                    return false;
+                }
                 inode_t* child_inode = (inode_t*)
-                        memsector_off2addr(alloc, inode->data[i].off);
+                        memsector_off2addr(ms_index->alloc,
+                                           ms_index->off_shift, off);
                 if (!memsector_inode_consistent(child_node, child_inode)) {
                     return false;
                 }
@@ -91,7 +106,7 @@ struct Tester {
 
 static
 int test_memsector_consistency(MwsIndexNode* data, memsector_handle_t* ms) {
-    alloc = ms_get_alloc(ms);
+    ms_index = &ms->index;
     if (Tester::memsector_inode_consistent(data, ms->index.root))
         return 0;
     else
@@ -159,31 +174,58 @@ int main(int argc, char* argv[]) {
                                                 ".harvest",
                                                 /* recursive = */ false) <= 0);
 
-    memsector_size = data->getMemsectorSize();
-    FAIL_ON(memsector_create(&mswr, tmp_memsector_path.c_str(),
-                             memsector_size) != 0);
-    printf("Memsector %s of %d Kb created\n",
-           tmp_memsector_path.c_str(), (int) memsector_size / 1024);
-    
-    data->exportToMemsector(&mswr);
-    printf("Index exported to memsector\n");
-    printf("Space used: %d Kb\n",
-           memsector_size_inuse(&mswr.ms_header->alloc_header) / 1024);
-
-    FAIL_ON(memsector_save(&mswr) != 0);
-    printf("Memsector saved\n");
-
-    FAIL_ON(memsector_load(&ms, tmp_memsector_path.c_str()) != 0);
-    printf("Memsector loaded\n");
-
-    if (test_memsector_consistency(data, &ms) != 0) {
-        printf("FAIL: Inconsistency detected!\n");
-        goto fail;
-    }
-    printf("Memsector consistent with index\n");
+    for (const tuple<index_format_t, uint32_t, uint32_t>& exportConfig :
+         {make_tuple(INDEX_FORMAT_SORTED_PAIRS, 0u, 0u),
+          make_tuple(INDEX_FORMAT_BLOCKED_KEYS, 0u, 0u),
+          make_tuple(INDEX_FORMAT_BLOCKED_KEYS, 0u,
+                     (uint32_t) MEMSECTOR_FLAG_SUBTREE_COUNTS),
+          make_tuple(INDEX_FORMAT_BLOCKED_KEYS, 3u,
+                     (uint32_t) MEMSECTOR_FLAG_SUBTREE_COUNTS),
+          make_tuple(INDEX_FORMAT_COMPACT, 0u, 0u),
+          make_tuple(INDEX_FORMAT_COMPACT, 3u,
+                     (uint32_t) MEMSECTOR_FLAG_SUBTREE_COUNTS)}) {
+        const index_format_t exportFormat = get<0>(exportConfig);
+        const uint32_t exportOffShift = get<1>(exportConfig);
+        const uint32_t exportFlags = get<2>(exportConfig);
+        memsector_size = data->getMemsectorSize(exportFormat, exportOffShift,
+                                                exportFlags != 0);
+        FAIL_ON(memsector_create_flags(&mswr, tmp_memsector_path.c_str(),
+                                       memsector_size, exportFormat,
+                                       exportOffShift, exportFlags) != 0);
+        printf("Memsector %s of %d Kb created with format %d, "
+               "offset shift %u\n",
+               tmp_memsector_path.c_str(), (int) memsector_size / 1024,
+               exportFormat, exportOffShift);
+
+        FAIL_ON(data->exportToMemsector(&mswr) != 0);
+        printf("Index exported to memsector\n");
+        // the size estimate is exact, or an upper bound for compact indexes
+        if (exportFormat == INDEX_FORMAT_COMPACT) {
+            FAIL_ON(mswr_size_inuse(&mswr) > memsector_size);
+        } else {
+            FAIL_ON(mswr_size_inuse(&mswr) != memsector_size);
+        }
+        printf("Space used: %d Kb\n", (int) (mswr_size_inuse(&mswr) / 1024));
 
-    FAIL_ON(memsector_remove(&ms) != 0);
-    printf("Memsector removed\n");
+        FAIL_ON(memsector_save(&mswr) != 0);
+        printf("Memsector saved\n");
+
+        FAIL_ON(memsector_load(&ms, tmp_memsector_path.c_str()) != 0);
+        FAIL_ON(ms.index.format != exportFormat);
+        FAIL_ON(ms.index.off_shift != exportOffShift);
+        // without the flag, the layout is that of indexes without counts
+        FAIL_ON(ms.index.subtree_counts != (exportFlags != 0));
+        printf("Memsector loaded\n");
+
+        if (test_memsector_consistency(data, &ms) != 0) {
+            printf("FAIL: Inconsistency detected!\n");
+            goto fail;
+        }
+        printf("Memsector consistent with index\n");
+
+        FAIL_ON(memsector_remove(&ms) != 0);
+        printf("Memsector removed\n");
+    }
 
     return 0;
 
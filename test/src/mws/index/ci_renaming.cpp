@@ -92,7 +92,7 @@ struct Tester {
         // Fail if we have not indexed all expresions
         FAIL_ON(ret.second != 8);
         // Fail if the index is not as compressed as it should
-        FAIL_ON(data.children._data.size() != 4);
+        FAIL_ON(data.children.size() != 4);
         (void) close(fd);
 
         (void) clearxmlparser();
@@ -0,0 +1,98 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file index_warm_up.cpp
+ * @brief Warm-up of the first levels of an index in every index format
+ * @date 18 Oct 2026
+ */
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/index/index.h"
+#include "common/utils/compiler_defs.h"
+
+#define TMP_MEMSECTOR_PATH  "/tmp/test-warm-up.memsector"
+
+using namespace std;
+using namespace mws;
+
+struct Tester {
+    static int testWarmUp(index_format_t format);
+};
+
+/*
+ * root -a-> inode -b-> leaf
+ *                 -c-> leaf
+ *      -d-> leaf
+ */
+int Tester::testWarmUp(index_format_t format) {
+    memsector_writer_t mswr;
+    memsector_handle_t ms;
+    MwsIndexNode* data = new MwsIndexNode();
+    const encoded_token_t a = encoded_token(1, 1), b = encoded_token(2, 0),
+            c = encoded_token(3, 0), d = encoded_token(4, 0);
+
+    data->insertData(vector<encoded_token_t>{a, b})->solutions = 1;
+    data->insertData(vector<encoded_token_t>{a, c})->solutions = 1;
+    data->insertData(vector<encoded_token_t>{d})->solutions = 1;
+
+    FAIL_ON(unlink(TMP_MEMSECTOR_PATH) != 0 && errno != ENOENT);
+    FAIL_ON(memsector_create_format(&mswr, TMP_MEMSECTOR_PATH,
+                                    MEMSECTOR_INITIAL_SIZE, format,
+                                    /* off_shift = */ 0) != 0);
+    FAIL_ON(data->exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+    // advice the system does not support does not fail the load
+    FAIL_ON(memsector_load_flags(&ms, TMP_MEMSECTOR_PATH,
+                                 MEMSECTOR_LOAD_POPULATE |
+                                 MEMSECTOR_LOAD_WILLNEED |
+                                 MEMSECTOR_LOAD_HUGEPAGE) != 0);
+
+    FAIL_ON(index_warm_up(&ms.index, 0) != 1);
+    FAIL_ON(index_warm_up(&ms.index, 1) != 3);
+    FAIL_ON(index_warm_up(&ms.index, 2) != 5);
+    FAIL_ON(index_warm_up(&ms.index, 100) != 5);
+
+    FAIL_ON(memsector_unload(&ms) != 0);
+    FAIL_ON(memsector_remove(&ms) != 0);
+    delete data;
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    FAIL_ON(Tester::testWarmUp(INDEX_FORMAT_SORTED_PAIRS) != 0);
+    FAIL_ON(Tester::testWarmUp(INDEX_FORMAT_BLOCKED_KEYS) != 0);
+    FAIL_ON(Tester::testWarmUp(INDEX_FORMAT_COMPACT) != 0);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,136 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @file inode_get_child.cpp
+ * @brief Child lookup in narrow and wide nodes of all index formats and
+ * with all instruction sets
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <vector>
+
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/index/index.h"
+#include "common/utils/compiler_defs.h"
+
+#define TMP_MEMSECTOR_PATH  "/tmp/test-inode.memsector"
+
+using namespace std;
+using namespace mws;
+
+static bool tokenLess(const encoded_token_t& lhs, const encoded_token_t& rhs) {
+    return memcmp(&lhs, &rhs, sizeof(encoded_token_t)) < 0;
+}
+
+static encoded_token_t randomToken() {
+    return encoded_token(rand() & 0xFFFFFF, rand() & 0xFF);
+}
+
+struct Tester {
+    static int testLookup(uint32_t numChildren, index_format_t format);
+};
+
+int Tester::testLookup(uint32_t numChildren, index_format_t format) {
+    typedef bool (*TokenLess)(const encoded_token_t&, const encoded_token_t&);
+    map<encoded_token_t, unsigned long long, TokenLess> formulaIds(tokenLess);
+    MwsIndexNode* data = new MwsIndexNode();
+    memsector_writer_t mswr;
+    memsector_handle_t ms;
+    const inode_t* root;
+
+    // the extreme tokens have the smallest key and the padding key
+    formulaIds[encoded_token(0, 0)] = 0;
+    formulaIds[encoded_token(0xFFFFFF, 0xFF)] = 0;
+    while (formulaIds.size() < numChildren) {
+        formulaIds[randomToken()] = 0;
+    }
+    for (auto& kv : formulaIds) {
+        kv.second = data->insertData(vector<encoded_token_t>(1, kv.first))->id;
+    }
+
+    FAIL_ON(unlink(TMP_MEMSECTOR_PATH) != 0 && errno != ENOENT);
+    FAIL_ON(memsector_create_format(&mswr, TMP_MEMSECTOR_PATH,
+                                    MEMSECTOR_INITIAL_SIZE, format,
+                                    /* off_shift = */ 0) != 0);
+    FAIL_ON(data->exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+    FAIL_ON(memsector_load(&ms, TMP_MEMSECTOR_PATH) != 0);
+    FAIL_ON(ms.index.format != format);
+
+    root = ms.index.root;
+    FAIL_ON(root->size != numChildren);
+    for (auto& kv : formulaIds) {
+        memsector_off_t off = inode_get_child(&ms.index, root, kv.first);
+        FAIL_ON(off == MEMSECTOR_OFF_NULL);
+        const leaf_t* leaf = (const leaf_t*)
+                memsector_off2addr(ms.alloc, ms.index.off_shift, off);
+        FAIL_ON(leaf->type != LEAF_NODE);
+        FAIL_ON(leaf->formula_id != kv.second);
+    }
+    for (int i = 0; i < 1000; i++) {
+        encoded_token_t token = randomToken();
+        if (formulaIds.find(token) == formulaIds.end()) {
+            FAIL_ON(inode_get_child(&ms.index, root, token) !=
+                    MEMSECTOR_OFF_NULL);
+        }
+    }
+
+    FAIL_ON(memsector_remove(&ms) != 0);
+    delete data;
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    const uint32_t numChildren[] = {2, 3, 4, 7, 8, 9, 15, 16, 17,
+                                    255, 256, 257, 4097, 70000};
+
+    srand(42);
+    for (uint32_t size : numChildren) {
+        FAIL_ON(Tester::testLookup(size, INDEX_FORMAT_SORTED_PAIRS) != 0);
+        FAIL_ON(Tester::testLookup(size, INDEX_FORMAT_COMPACT) != 0);
+    }
+    for (inode_search_isa_t isa : {INODE_SEARCH_SCALAR, INODE_SEARCH_SSE2,
+                                   INODE_SEARCH_AVX2}) {
+        if (inode_search_set_isa(isa) != 0) {
+            printf("Instruction set %d not supported\n", isa);
+            continue;
+        }
+        for (uint32_t size : numChildren) {
+            FAIL_ON(Tester::testLookup(size, INDEX_FORMAT_BLOCKED_KEYS) != 0);
+        }
+    }
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,139 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief Test that loading harvests with several jobs builds the same index
+  * as loading them sequentially
+  *
+  * @file loadMwsHarvestFromDirectoryTest.cpp
+  * @date 17 Oct 2026
+  *
+  * License: GPL v3
+  *
+  */
+
+// System includes
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+// Local includes
+
+#include "mws/dbc/MemCrawlDb.hpp"
+#include "mws/dbc/MemFormulaDb.hpp"
+#include "mws/index/IndexManager.hpp"
+#include "mws/index/MeaningDictionary.hpp"
+using mws::index::MeaningDictionary;
+#include "mws/types/FormulaPath.hpp"
+#include "mws/xmlparser/initxmlparser.hpp"
+#include "mws/xmlparser/clearxmlparser.hpp"
+#include "mws/xmlparser/processMwsHarvest.hpp"
+#include "common/utils/compiler_defs.h"
+
+#include "build-gen/config.h"
+
+// Namespaces
+
+using namespace std;
+using namespace mws;
+
+struct LoadedIndex {
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+    MwsIndexNode data;
+    MeaningDictionary meaningDictionary;
+    int totalLoaded;
+
+    explicit LoadedIndex(int numJobs) {
+        index::IndexingOptions indexingOptions;
+        indexingOptions.renameCi = true;
+        index::IndexManager indexManager(&formulaDb, &crawlDb, &data,
+                                         &meaningDictionary, indexingOptions);
+        totalLoaded =
+                parser::loadMwsHarvestFromDirectory(&indexManager,
+                                                    AbsPath(MWS_TESTDATA_PATH),
+                                                    ".harvest",
+                                                    /* recursive = */ false,
+                                                    numJobs);
+    }
+};
+
+struct Tester {
+    static vector<string> getFormulae(LoadedIndex* index,
+                                      const MwsIndexNode* node) {
+        vector<string> formulae;
+        index->formulaDb.queryFormula(node->id, 0, 1000,
+                [&formulae, index](const dbc::CrawlId& crawlId,
+                                   const types::FormulaPath& formulaPath) {
+            string crawlData = (crawlId == dbc::CRAWLID_NULL) ?
+                    "" : index->crawlDb.getData(crawlId);
+            formulae.push_back(to_string(crawlId) + crawlData +
+                               formulaPath.xmlId + formulaPath.xpath);
+            return 0;
+        });
+
+        return formulae;
+    }
+
+    static bool sameIndex(LoadedIndex* a, const MwsIndexNode* aNode,
+                          LoadedIndex* b, const MwsIndexNode* bNode) {
+        FAIL_ON(aNode->id - a->data.id != bNode->id - b->data.id);
+        FAIL_ON(aNode->solutions != bNode->solutions);
+        FAIL_ON(getFormulae(a, aNode) != getFormulae(b, bNode));
+        FAIL_ON(aNode->children.size() != bNode->children.size());
+        for (auto aIt = aNode->children.begin(), bIt = bNode->children.begin();
+             aIt != aNode->children.end(); aIt++, bIt++) {
+            FAIL_ON(memcmp(&aIt->first, &bIt->first,
+                           sizeof(encoded_token_t)) != 0);
+            FAIL_ON(!sameIndex(a, aIt->second, b, bIt->second));
+        }
+
+        return true;
+
+    fail:
+        return false;
+    }
+};
+
+int main() {
+    FAIL_ON(initxmlparser() != 0);
+
+    {
+        LoadedIndex sequential(1);
+        LoadedIndex parallel(4);
+
+        FAIL_ON(sequential.totalLoaded == 0);
+        FAIL_ON(sequential.totalLoaded != parallel.totalLoaded);
+        FAIL_ON(sequential.meaningDictionary.getKeys() !=
+                parallel.meaningDictionary.getKeys());
+        FAIL_ON(!Tester::sameIndex(&sequential, &sequential.data,
+                                   &parallel, &parallel.data));
+    }
+
+    (void) clearxmlparser();
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
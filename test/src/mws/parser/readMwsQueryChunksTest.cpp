@@ -0,0 +1,110 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief Testing the MwsQueryReader, fed with a query byte by byte
+  *
+  * @file readMwsQueryChunksTest.cpp
+  * @date 17 Oct 2026
+  *
+  * License: GPL v3
+  *
+  */
+
+#include <libxml/parser.h>             // LibXML parser header
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>                      // C++ String header
+
+#include "mws/xmlparser/readMwsQuery.hpp"
+using mws::xmlparser::MwsQueryReader;
+#include "common/utils/compiler_defs.h"
+
+#include "build-gen/config.h"
+
+// Namespaces
+
+using namespace std;
+using namespace mws;
+
+int main()
+{
+    MwsQuery*   expected = NULL;
+    MwsQuery*   result = NULL;
+    FILE*       file;
+    string      xml;
+    string      xml_path = (string) MWS_TESTDATA_PATH + "/MwsQuery1.xml";
+    char        buffer[BUFSIZ];
+    size_t      nbytes;
+
+    file = fopen(xml_path.c_str(), "r");
+    FAIL_ON(file == NULL);
+    expected = xmlparser::readMwsQuery(file);
+    FAIL_ON(expected == NULL);
+    rewind(file);
+    while ((nbytes = fread(buffer, sizeof(char), sizeof(buffer), file)) > 0) {
+        xml.append(buffer, nbytes);
+    }
+    fclose(file);
+
+    // chunks split tags, attributes and text
+    {
+        MwsQueryReader reader;
+        for (char c : xml) {
+            FAIL_ON(reader.push(&c, 1) != 0);
+        }
+        result = reader.finish();
+    }
+    FAIL_ON(result == NULL);
+    FAIL_ON(result->warnings != 0);
+    FAIL_ON(result->attrResultMaxSize != expected->attrResultMaxSize);
+    FAIL_ON(result->attrResultLimitMin != expected->attrResultLimitMin);
+    FAIL_ON(result->tokens.size() != expected->tokens.size());
+    FAIL_ON(result->tokens[0]->toString() != expected->tokens[0]->toString());
+    delete result;
+
+    // a truncated query is rejected
+    {
+        MwsQueryReader reader;
+        FAIL_ON(reader.push(xml.data(), xml.size() / 2) != 0);
+        result = reader.finish();
+    }
+    FAIL_ON(result != NULL);
+
+    // as is a malformed one, from the chunk breaking it
+    {
+        MwsQueryReader reader;
+        FAIL_ON(reader.push("<mws:query>", 11) != 0);
+        FAIL_ON(reader.push("</mws:expr>", 11) == 0);
+        result = reader.finish();
+    }
+    FAIL_ON(result != NULL);
+
+    delete expected;
+    (void) xmlCleanupParser();
+
+    return EXIT_SUCCESS;
+
+fail:
+    delete expected;
+    delete result;
+    return EXIT_FAILURE;
+}
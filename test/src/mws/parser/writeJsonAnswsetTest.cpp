@@ -0,0 +1,138 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief Testing the JSON serializer of MwsAnswset against json-c
+  *
+  * @file writeJsonAnswsetTest.cpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  *
+  */
+
+#include <json.h>
+#include <stdlib.h>
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include "mws/xmlparser/jsonString.hpp"
+#include "mws/xmlparser/writeJsonAnswset.hpp"
+#include "common/utils/compiler_defs.h"
+
+using mws::MwsAnswset;
+using mws::types::Answer;
+using mws::xmlparser::JsonAnswsetWriter;
+using mws::xmlparser::appendJsonString;
+
+/// Answer set document as json-c prints it
+static string jsoncAnswset(const MwsAnswset& answset) {
+    json_object* json_doc = json_object_new_object();
+    json_object* qvars = json_object_new_array();
+    json_object* hits = json_object_new_array();
+
+    json_object_object_add(json_doc, "total",
+                           json_object_new_int(answset.total));
+    for (size_t i = 0; i < answset.qvarNames.size(); i++) {
+        json_object* qvar = json_object_new_object();
+        json_object_object_add(qvar, "name",
+                json_object_new_string(answset.qvarNames[i].c_str()));
+        json_object_object_add(qvar, "xpath",
+                json_object_new_string(answset.qvarXpaths[i].c_str()));
+        json_object_array_add(qvars, qvar);
+    }
+    json_object_object_add(json_doc, "qvars", qvars);
+    for (const Answer* answer : answset.answers) {
+        json_object* hit = json_object_new_object();
+        json_object* math_ids = json_object_new_array();
+        json_object* math_id = json_object_new_object();
+        json_object_object_add(math_id, "url",
+                               json_object_new_string(answer->uri.c_str()));
+        json_object_object_add(math_id, "xpath",
+                               json_object_new_string(answer->xpath.c_str()));
+        json_object_array_add(math_ids, math_id);
+        json_object_object_add(hit, "math_ids", math_ids);
+        json_object_object_add(hit, "xhtml",
+                               json_object_new_string(answer->data.c_str()));
+        json_object_array_add(hits, hit);
+    }
+    json_object_object_add(json_doc, "hits", hits);
+
+    string result = json_object_to_json_string(json_doc);
+    json_object_put(json_doc);
+
+    return result;
+}
+
+static string jsoncString(const string& str) {
+    json_object* json_str = json_object_new_string(str.c_str());
+    string result = json_object_to_json_string(json_str);
+    json_object_put(json_str);
+
+    return result;
+}
+
+static string writeAnswset(const MwsAnswset& answset) {
+    JsonAnswsetWriter writer(&answset);
+    string result;
+    int ret;
+
+    while ((ret = writer.writeNext(&result)) == 1) continue;
+
+    return (ret == 0) ? result : "";
+}
+
+int main() {
+    // every byte but NUL, at every offset of a SIMD block
+    string allBytes;
+    for (int c = 1; c < 256; c++) allBytes.push_back(c);
+    for (size_t offset = 0; offset < 40; offset++) {
+        string str = string(offset, 'a') + allBytes + string(offset, '/');
+        // appended after what out already holds
+        string escaped = "[";
+        appendJsonString(&escaped, str);
+        FAIL_ON(escaped != "[" + jsoncString(str));
+    }
+
+    for (int numAnswers = 0; numAnswers < 4; numAnswers++) {
+        MwsAnswset answset;
+        answset.total = numAnswers * 7;
+        for (int i = 0; i < numAnswers % 3; i++) {
+            answset.qvarNames.push_back("x\"" + to_string(i));
+            answset.qvarXpaths.push_back("/*[1]/*[" + to_string(i) + "]");
+        }
+        for (int i = 0; i < numAnswers; i++) {
+            Answer* answer = new Answer();
+            answer->uri = "http://example.org/a?b=1&c=\"2\"#" + to_string(i);
+            answer->xpath = "/*[1]/*[2]";
+            answer->data = "<math>\t<mi>\xce\xb1</mi>\n\\ \x01</math>" +
+                    string(i * 100, 'x');
+            answset.answers.push_back(answer);
+        }
+        FAIL_ON(writeAnswset(answset) != jsoncAnswset(answset));
+    }
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,122 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief Testing the MatchListCache: expiry and eviction
+  *
+  * @file MatchListCache_ttl.cpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <stdlib.h>
+
+#include <memory>
+using std::shared_ptr;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "mws/query/MatchListCache.hpp"
+using mws::query::MatchList;
+using mws::query::MatchListCache;
+
+/// Cache whose clock is set by the test
+struct TestMatchListCache : public MatchListCache {
+    time_t currentTime;
+
+    TestMatchListCache(size_t capacity, time_t ttl) :
+        MatchListCache(capacity, ttl), currentTime(0) {
+    }
+
+    time_t now() const {
+        return currentTime;
+    }
+};
+
+static vector<encoded_token_t> makeQuery(uint32_t id) {
+    vector<encoded_token_t> query(1);
+    query[0].arity = 0;
+    query[0].id = id;
+
+    return query;
+}
+
+static shared_ptr<const MatchList> makeMatches(unsigned numMatches) {
+    MatchList* matches = new MatchList();
+    for (unsigned i = 0; i < numMatches; i++) {
+        matches->add(i, i);
+    }
+    matches->setTotal(numMatches);
+
+    return shared_ptr<const MatchList>(matches);
+}
+
+int main() {
+    shared_ptr<const MatchList> matches = makeMatches(100);
+    const size_t matchesSize = matches->getMemoryUsage();
+    TestMatchListCache disabled(0, 10);
+    // room for two match lists
+    TestMatchListCache cache(2 * matchesSize + 512, 10);
+
+    disabled.put(makeQuery(1), 100, matches);
+    FAIL_ON(disabled.get(makeQuery(1), 100) != NULL);
+
+    FAIL_ON(cache.get(makeQuery(1), 100) != NULL);
+    cache.put(makeQuery(1), 100, matches);
+    FAIL_ON(cache.get(makeQuery(1), 100) != matches);
+    // counted up to another total, the matches differ
+    FAIL_ON(cache.get(makeQuery(1), 50) != NULL);
+    FAIL_ON(cache.getHits() != 1 || cache.getMisses() != 2);
+
+    // match lists expire ttl seconds after being cached
+    cache.currentTime = 9;
+    FAIL_ON(cache.get(makeQuery(1), 100) == NULL);
+    cache.currentTime = 10;
+    FAIL_ON(cache.get(makeQuery(1), 100) != NULL);
+    FAIL_ON(cache.getSize() != 0);
+
+    // least recently used match list is evicted first
+    cache.put(makeQuery(1), 100, matches);
+    cache.put(makeQuery(2), 100, makeMatches(100));
+    FAIL_ON(cache.get(makeQuery(1), 100) == NULL);
+    cache.put(makeQuery(3), 100, makeMatches(100));
+    FAIL_ON(cache.get(makeQuery(2), 100) != NULL);
+    FAIL_ON(cache.get(makeQuery(1), 100) == NULL);
+    FAIL_ON(cache.get(makeQuery(3), 100) == NULL);
+
+    // expired match lists are evicted before recently used ones
+    cache.currentTime = 15;
+    cache.put(makeQuery(2), 100, makeMatches(100));
+    cache.currentTime = 20;
+    cache.put(makeQuery(4), 100, makeMatches(100));
+    FAIL_ON(cache.get(makeQuery(2), 100) == NULL);
+    FAIL_ON(cache.get(makeQuery(4), 100) == NULL);
+
+    cache.clear();
+    FAIL_ON(cache.getSize() != 0);
+    FAIL_ON(cache.get(makeQuery(4), 100) != NULL);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
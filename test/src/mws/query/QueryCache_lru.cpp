@@ -0,0 +1,135 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief Testing the QueryCache: hits, misses, eviction and invalidation
+  *
+  * @file QueryCache_lru.cpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <stdlib.h>
+
+#include <memory>
+using std::unique_ptr;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "mws/query/QueryCache.hpp"
+using mws::query::QueryCache;
+using mws::MwsAnswset;
+using mws::MwsQuery;
+using mws::types::Answer;
+
+static vector<encoded_token_t> makeQuery(uint32_t id) {
+    vector<encoded_token_t> query(2);
+    query[0].arity = 1;
+    query[0].id = id;
+    query[1].arity = 0;
+    query[1].id = id + 1;
+
+    return query;
+}
+
+static MwsAnswset* makeAnswset(int total, const string& data) {
+    MwsAnswset* answset = new MwsAnswset();
+    Answer* answer = new Answer();
+    answer->uri = "http://example.org/" + std::to_string(total);
+    answer->xpath = "/*[1]";
+    answer->data = data;
+    answset->answers.push_back(answer);
+    answset->total = total;
+    answset->qvarNames.push_back("x");
+    answset->qvarXpaths.push_back("/*[1]/*[1]");
+
+    return answset;
+}
+
+int main() {
+    const string data(1500, 'x');
+    MwsQuery page, nextPage;
+    unique_ptr<MwsAnswset> answset(makeAnswset(1, data));
+    unique_ptr<MwsAnswset> cached;
+    QueryCache disabled(0);
+    // room for two answer sets
+    QueryCache cache(2 * 2000);
+
+    nextPage.attrResultLimitMin = page.attrResultMaxSize;
+
+    // disabled cache
+    disabled.put(makeQuery(1), page, *answset);
+    FAIL_ON(disabled.get(makeQuery(1), page) != NULL);
+    FAIL_ON(disabled.getSize() != 0);
+
+    FAIL_ON(cache.get(makeQuery(1), page) != NULL);
+    cache.put(makeQuery(1), page, *answset);
+    cached.reset(cache.get(makeQuery(1), page));
+    FAIL_ON(cached == NULL);
+    FAIL_ON(cached.get() == answset.get());
+    FAIL_ON(cached->total != 1);
+    FAIL_ON(cached->answers.size() != 1);
+    FAIL_ON(cached->answers[0] == answset->answers[0]);
+    FAIL_ON(cached->answers[0]->data != data);
+    FAIL_ON(cached->qvarNames != answset->qvarNames);
+    FAIL_ON(cached->qvarXpaths != answset->qvarXpaths);
+    FAIL_ON(cache.getHits() != 1 || cache.getMisses() != 1);
+
+    // another page of the same query is another entry
+    FAIL_ON(cache.get(makeQuery(1), nextPage) != NULL);
+    FAIL_ON(cache.get(makeQuery(3), page) != NULL);
+
+    // least recently used answer set is evicted first
+    answset.reset(makeAnswset(2, data));
+    cache.put(makeQuery(1), nextPage, *answset);
+    cached.reset(cache.get(makeQuery(1), page));
+    FAIL_ON(cached == NULL);
+    answset.reset(makeAnswset(3, data));
+    cache.put(makeQuery(3), page, *answset);
+    FAIL_ON(cache.getSize() > 2 * 2000);
+    cached.reset(cache.get(makeQuery(1), nextPage));
+    FAIL_ON(cached != NULL);
+    cached.reset(cache.get(makeQuery(1), page));
+    FAIL_ON(cached == NULL || cached->total != 1);
+    cached.reset(cache.get(makeQuery(3), page));
+    FAIL_ON(cached == NULL || cached->total != 3);
+
+    // answer sets larger than the cache are not cached
+    answset.reset(makeAnswset(4, string(4000, 'x')));
+    cache.put(makeQuery(5), page, *answset);
+    cached.reset(cache.get(makeQuery(5), page));
+    FAIL_ON(cached != NULL);
+    cached.reset(cache.get(makeQuery(3), page));
+    FAIL_ON(cached == NULL);
+
+    cache.clear();
+    FAIL_ON(cache.getSize() != 0);
+    cached.reset(cache.get(makeQuery(3), page));
+    FAIL_ON(cached != NULL);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,116 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+  * @brief Testing the QueryCache with queries differing only in the names
+  * of their qvars
+  *
+  * @file QueryCache_qvars.cpp
+  * @date 18 Oct 2026
+  *
+  * License: GPL v3
+  */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <memory>
+using std::unique_ptr;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+#include "common/utils/compiler_defs.h"
+#include "mws/index/ExpressionEncoder.hpp"
+using mws::index::ExpressionInfo;
+using mws::index::IndexingOptions;
+using mws::index::MeaningDictionary;
+using mws::index::QueryEncoder;
+#include "mws/query/QueryCache.hpp"
+using mws::query::QueryCache;
+#include "mws/types/CmmlToken.hpp"
+using mws::types::CmmlToken;
+using mws::MwsAnswset;
+using mws::MwsQuery;
+using mws::types::Answer;
+
+/// ?x + ?y, with the qvar names given
+static CmmlToken* makeSum(const string& x, const string& y) {
+    CmmlToken* root = CmmlToken::newRoot(false);
+    root->setTag("apply");
+    root->newChildNode()->setTag("plus");
+    for (const string& name : {x, y}) {
+        CmmlToken* qvar = root->newChildNode();
+        qvar->setTag("mws:qvar");
+        qvar->appendTextContent(name.data(), name.size());
+    }
+
+    return root;
+}
+
+int main() {
+    MeaningDictionary meaningDictionary;
+    IndexingOptions indexingOptions;
+    QueryEncoder encoder(&meaningDictionary);
+    unique_ptr<CmmlToken> xy(makeSum("x", "y"));
+    unique_ptr<CmmlToken> ab(makeSum("a", "b"));
+    vector<encoded_token_t> encodedXy, encodedAb;
+    ExpressionInfo xyInfo, abInfo;
+    MwsQuery query;
+    MwsAnswset answset;
+    unique_ptr<MwsAnswset> cached;
+    QueryCache cache(1 << 20);
+
+    meaningDictionary.put(xy->getMeaning());
+    meaningDictionary.put(xy->getChildNodes().front()->getMeaning());
+    indexingOptions.renameCi = false;
+    FAIL_ON(encoder.encode(indexingOptions, xy.get(), &encodedXy,
+                           &xyInfo) != 0);
+    FAIL_ON(encoder.encode(indexingOptions, ab.get(), &encodedAb,
+                           &abInfo) != 0);
+    // both queries are cached under the same key
+    FAIL_ON(encodedXy.size() != encodedAb.size());
+    FAIL_ON(memcmp(encodedXy.data(), encodedAb.data(),
+                   encodedXy.size() * sizeof(encoded_token_t)) != 0);
+    FAIL_ON(abInfo.qvarNames != vector<string>({"a", "b"}));
+    FAIL_ON(xyInfo.qvarXpaths != abInfo.qvarXpaths);
+
+    answset.total = 1;
+    answset.answers.push_back(new Answer());
+    answset.answers[0]->uri = "http://example.org/";
+    answset.qvarNames = xyInfo.qvarNames;
+    answset.qvarXpaths = xyInfo.qvarXpaths;
+    cache.put(encodedXy, query, answset);
+
+    cached.reset(cache.get(encodedAb, query));
+    FAIL_ON(cached == NULL);
+    FAIL_ON(cached->total != 1);
+    FAIL_ON(cached->answers.size() != 1);
+    FAIL_ON(cached->answers[0]->uri != answset.answers[0]->uri);
+    // named as in the query cached: IndexDaemon::answer() renames them
+    FAIL_ON(cached->qvarNames != xyInfo.qvarNames);
+    FAIL_ON(cached->qvarXpaths != abInfo.qvarXpaths);
+
+    return EXIT_SUCCESS;
+
+fail:
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,182 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @brief Test that pages answered from a match list are the pages
+ * answered by walking the index
+ *
+ * @file SearchContext_matchList.cpp
+ * @date 18 Oct 2026
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <cerrno>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mws/dbc/DbQueryManager.hpp"
+#include "mws/dbc/MemCrawlDb.hpp"
+#include "mws/dbc/MemFormulaDb.hpp"
+#include "mws/index/IndexAccessor.hpp"
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/memsector.h"
+#include "mws/query/MatchList.hpp"
+#include "mws/query/SearchContext.hpp"
+#include "mws/types/MwsAnswset.hpp"
+#include "common/utils/compiler_defs.h"
+
+#define TMP_MEMSECTOR_PATH  "/tmp/test-match-list.memsector"
+#define NUM_FORMULAE        2000
+#define MAX_DEPTH           4
+
+using namespace std;
+using namespace mws;
+using mws::index::IndexAccessor;
+using mws::query::MatchList;
+using mws::query::SearchContext;
+
+static const MeaningId CONST_A = CONSTANT_ID_MIN;       // a, b, c
+static const MeaningId CONST_F = CONSTANT_ID_MIN + 3;   // f(_)
+static const MeaningId CONST_G = CONSTANT_ID_MIN + 4;   // g(_, _)
+
+static void randomTerm(vector<encoded_token_t>* formula, int depth) {
+    int r = (depth < MAX_DEPTH) ? rand() % 4 : 0;
+    switch (r) {
+    case 0:
+        formula->push_back(encoded_token(CONST_A + rand() % 3, 0));
+        break;
+    case 1:
+        formula->push_back(encoded_token(CONST_F, 1));
+        randomTerm(formula, depth + 1);
+        break;
+    default:
+        formula->push_back(encoded_token(CONST_G, 2));
+        randomTerm(formula, depth + 1);
+        randomTerm(formula, depth + 1);
+        break;
+    }
+}
+
+static int comparePages(SearchContext* ctxt,
+                        const MatchList* matches,
+                        index_handle_t* index,
+                        dbc::DbQueryManager* dbQueryManager,
+                        unsigned offset, unsigned size, unsigned maxTotal) {
+    MwsAnswset* expected = ctxt->getResult<IndexAccessor>(
+            index, dbQueryManager, offset, size, maxTotal);
+    MwsAnswset* actual = matches->getPage(dbQueryManager, offset, size);
+    int ret = -1;
+
+    FAIL_ON(expected->total != actual->total);
+    FAIL_ON(expected->answers.size() != actual->answers.size());
+    for (size_t i = 0; i < expected->answers.size(); i++) {
+        FAIL_ON(expected->answers[i]->uri != actual->answers[i]->uri);
+    }
+    ret = 0;
+
+fail:
+    delete expected;
+    delete actual;
+    return ret;
+}
+
+struct Tester {
+    static int testMatchList();
+};
+
+int Tester::testMatchList() {
+    MwsIndexNode* data = new MwsIndexNode();
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+    dbc::DbQueryManager dbQueryManager(&crawlDb, &formulaDb);
+    memsector_writer_t mswr;
+    memsector_handle_t ms;
+    const unsigned offsets[] = {0, 1, 7, 29, 30, 100, 1000, 1499, 1500,
+                                NUM_FORMULAE};
+    const unsigned sizes[] = {0, 1, 30, NUM_FORMULAE};
+    const unsigned maxTotals[] = {50, 1500, 3 * NUM_FORMULAE};
+    const vector<vector<encoded_token_t> > queries = {
+        // ?x
+        {encoded_token(QVAR_ID_MIN, 0)},
+        // g(?x, ?y)
+        {encoded_token(CONST_G, 2), encoded_token(QVAR_ID_MIN, 0),
+         encoded_token(QVAR_ID_MIN + 1, 0)},
+        // g(?x, ?x)
+        {encoded_token(CONST_G, 2), encoded_token(QVAR_ID_MIN, 0),
+         encoded_token(QVAR_ID_MIN, 0)},
+        // g(f(_), _)
+        {encoded_token(CONST_G, 2), encoded_token(CONST_F, 1),
+         encoded_token(ANON_QVAR_ID_MIN, 0),
+         encoded_token(ANON_QVAR_ID_MIN, 0)},
+        // f(a), without any match
+        {encoded_token(CONST_F, 1), encoded_token(CONST_F, 1),
+         encoded_token(CONST_F, 1), encoded_token(CONST_F, 1),
+         encoded_token(CONST_F, 1), encoded_token(CONST_A, 0)},
+    };
+
+    srand(42);
+    for (int i = 0; i < NUM_FORMULAE; i++) {
+        vector<encoded_token_t> formula;
+        randomTerm(&formula, 0);
+        MwsIndexNode* leaf = data->insertData(formula);
+        leaf->solutions++;
+
+        types::FormulaPath formulaPath;
+        formulaPath.xmlId = "f" + to_string(i);
+        FAIL_ON(formulaDb.insertFormula(leaf->id, dbc::CRAWLID_NULL,
+                                        formulaPath) != 0);
+    }
+
+    FAIL_ON(unlink(TMP_MEMSECTOR_PATH) != 0 && errno != ENOENT);
+    FAIL_ON(memsector_create(&mswr, TMP_MEMSECTOR_PATH, 4096) != 0);
+    FAIL_ON(data->exportToMemsector(&mswr) != 0);
+    FAIL_ON(memsector_save(&mswr) != 0);
+    FAIL_ON(memsector_load(&ms, TMP_MEMSECTOR_PATH) != 0);
+
+    for (const vector<encoded_token_t>& query : queries) {
+        SearchContext ctxt(query);
+        for (unsigned maxTotal : maxTotals) {
+            unique_ptr<MatchList> matches(
+                    ctxt.getMatches<IndexAccessor>(&ms.index, maxTotal));
+            for (unsigned offset : offsets) {
+                for (unsigned size : sizes) {
+                    FAIL_ON(comparePages(&ctxt, matches.get(), &ms.index,
+                                         &dbQueryManager,
+                                         offset, size, maxTotal) != 0);
+                }
+            }
+        }
+    }
+
+    FAIL_ON(memsector_remove(&ms) != 0);
+    delete data;
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    return Tester::testMatchList() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
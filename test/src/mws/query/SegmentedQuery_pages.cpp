@@ -0,0 +1,168 @@
+/*
+
+Copyright (C) 2010-2013 KWARC Group <kwarc.info>
+
+This file is part of MathWebSearch.
+
+MathWebSearch is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MathWebSearch is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MathWebSearch.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/**
+ * @brief Test that pages of an index made of segments are the pages of
+ * the hits of the segments, concatenated
+ *
+ * @file SegmentedQuery_pages.cpp
+ * @date 18 Oct 2026
+ */
+
+#include <stdlib.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mws/dbc/DbQueryManager.hpp"
+#include "mws/dbc/MemCrawlDb.hpp"
+#include "mws/dbc/MemFormulaDb.hpp"
+#include "mws/index/MwsIndexNode.hpp"
+#include "mws/index/TmpIndexAccessor.hpp"
+#include "mws/query/SearchContext.hpp"
+#include "mws/query/SegmentedQuery.hpp"
+#include "mws/types/MwsAnswset.hpp"
+#include "common/utils/compiler_defs.h"
+
+#define NUM_SEGMENTS        3
+#define NUM_FORMULAE        300
+#define MAX_DEPTH           3
+
+using namespace std;
+using namespace mws;
+using mws::index::TmpIndexAccessor;
+using mws::query::SearchContext;
+using mws::query::querySegments;
+
+static const MeaningId CONST_A = CONSTANT_ID_MIN;       // a, b
+static const MeaningId CONST_F = CONSTANT_ID_MIN + 2;   // f(_)
+static const MeaningId CONST_G = CONSTANT_ID_MIN + 3;   // g(_, _)
+
+static void randomTerm(vector<encoded_token_t>* formula, int depth) {
+    int r = (depth < MAX_DEPTH) ? rand() % 4 : 0;
+    switch (r) {
+    case 0:
+        formula->push_back(encoded_token(CONST_A + rand() % 2, 0));
+        break;
+    case 1:
+        formula->push_back(encoded_token(CONST_F, 1));
+        randomTerm(formula, depth + 1);
+        break;
+    default:
+        formula->push_back(encoded_token(CONST_G, 2));
+        randomTerm(formula, depth + 1);
+        randomTerm(formula, depth + 1);
+        break;
+    }
+}
+
+struct Segment {
+    MwsIndexNode data;
+    dbc::MemCrawlDb crawlDb;
+    dbc::MemFormulaDb formulaDb;
+};
+
+struct Tester {
+    static int testSegmentedPages();
+};
+
+int Tester::testSegmentedPages() {
+    vector<unique_ptr<Segment> > segments;
+    const unsigned offsets[] = {0, 1, 13, 99, 100, 101, 250, 800};
+    const unsigned sizes[] = {0, 1, 30, 1000};
+    const unsigned maxTotals[] = {1, 40, 150, 3000};
+    const vector<vector<encoded_token_t> > queries = {
+        // ?x
+        {encoded_token(QVAR_ID_MIN, 0)},
+        // g(?x, ?x)
+        {encoded_token(CONST_G, 2), encoded_token(QVAR_ID_MIN, 0),
+         encoded_token(QVAR_ID_MIN, 0)},
+        // f(_)
+        {encoded_token(CONST_F, 1), encoded_token(ANON_QVAR_ID_MIN, 0)},
+    };
+
+    srand(42);
+    for (int s = 0; s < NUM_SEGMENTS; s++) {
+        segments.push_back(unique_ptr<Segment>(new Segment()));
+        // later segments are smaller, as delta segments are
+        for (int i = 0; i < NUM_FORMULAE >> s; i++) {
+            vector<encoded_token_t> formula;
+            randomTerm(&formula, 0);
+            MwsIndexNode* leaf = segments[s]->data.insertData(formula);
+            leaf->solutions++;
+
+            types::FormulaPath formulaPath;
+            formulaPath.xmlId = to_string(s) + "." + to_string(i);
+            FAIL_ON(segments[s]->formulaDb.insertFormula(
+                    leaf->id, dbc::CRAWLID_NULL, formulaPath) != 0);
+        }
+    }
+
+    for (const vector<encoded_token_t>& query : queries) {
+        SearchContext ctxt(query);
+        auto querySegment = [&](size_t i, unsigned offset, unsigned size,
+                                unsigned maxTotal) {
+            dbc::DbQueryManager dbQueryManager(&segments[i]->crawlDb,
+                                               &segments[i]->formulaDb);
+            return ctxt.getResult<TmpIndexAccessor>(&segments[i]->data,
+                                                    &dbQueryManager,
+                                                    offset, size, maxTotal);
+        };
+
+        // all hits of the segments, one after the other
+        vector<string> hits;
+        for (size_t i = 0; i < segments.size(); i++) {
+            unique_ptr<MwsAnswset> all(querySegment(i, 0, 100000, 100000));
+            FAIL_ON(all->total != (int) all->answers.size());
+            for (mws::types::Answer* answer : all->answers) {
+                hits.push_back(answer->uri);
+            }
+        }
+        FAIL_ON(hits.empty());
+
+        for (unsigned maxTotal : maxTotals) {
+            for (unsigned offset : offsets) {
+                for (unsigned size : sizes) {
+                    unique_ptr<MwsAnswset> page(
+                            querySegments(segments.size(), offset, size,
+                                          maxTotal, querySegment));
+                    unsigned total = min<unsigned>(hits.size(), maxTotal);
+                    unsigned end = min(offset + size, total);
+                    FAIL_ON(page->total != (int) total);
+                    FAIL_ON(page->answers.size() !=
+                            (end > offset ? end - offset : 0));
+                    for (size_t i = 0; i < page->answers.size(); i++) {
+                        FAIL_ON(page->answers[i]->uri != hits[offset + i]);
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+
+fail:
+    return -1;
+}
+
+int main() {
+    return Tester::testSegmentedPages() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -69,7 +69,7 @@ int query_engine_tester(mws::MwsIndexNode* data,
 
     data->exportToMemsector(&mswr);
     printf("Index exported to memsector\n");
-    printf("Space used: %d\n", memsector_size_inuse(&mswr.ms_header->alloc_header));
+    printf("Space used: %d\n", (int) mswr_size_inuse(&mswr));
 
     FAIL_ON(memsector_save(&mswr) != 0);
     printf("Memsector saved\n");